@@ -19,88 +19,1093 @@
 typedef char *string;
 
 
-// --- Original Input Functions ---
-// ... (code for get_string, get_char, etc. - unchanged) ...
-string get_string(const char *prompt)
-{
+// --- Line Reader ---
+// FILE readers read with fgets, so stdio does the block I/O and the newline
+// scan and nothing past the current line is consumed: get_string can share
+// stdin with scanf/fgetc in the same program. fd readers read ahead into
+// their own block buffer, find newlines with memchr and hand out lines that
+// point straight into the block. Memory readers copy each line out of the
+// caller's (const) buffer. Either way lines are borrowed: valid until the
+// next call, '\n' removed, NUL-terminated.
+#define READER_BLOCK_SIZE 65536
+#define LINE_STACK_SIZE 256
+
+#if defined(__unix__) || defined(__APPLE__)
+#define AQUANT_HAVE_POSIX_IO 1
+#include <unistd.h>
+#endif
+
+typedef struct LineBuffer {
+    char *data;
+    size_t capacity;
+    bool on_heap; // false while data is the caller's initial (stack) storage
+} LineBuffer;
+
+struct aq_reader {
+    FILE *fp;           // FILE reader
+    const char *memory; // Memory reader (borrowed)
+    int fd;             // fd reader when both of the above are NULL
+    LineBuffer line;    // FILE and memory readers: the reusable line buffer
+    char *block;        // fd readers: read-ahead buffer, one spare byte for '\0'
+    size_t block_size;
+    size_t start, end;  // Unread bytes are block[start, end) (memory[...] for memory readers)
+    bool eof;
+    bool error;         // A read or allocation failed (reported as EOF by aq_reader_next_line)
+};
+
+static void line_buffer_release(LineBuffer *lb) {
+    if (lb->on_heap) free(lb->data);
+}
+
+// Doubles the buffer, keeping the first 'used' bytes.
+static bool line_buffer_grow(LineBuffer *lb, size_t used) {
+    if (lb->capacity > SIZE_MAX / 2) return false;
+    size_t new_capacity = lb->capacity * 2;
+    char *temp;
+    if (lb->on_heap) {
+        temp = realloc(lb->data, new_capacity);
+    } else {
+        temp = malloc(new_capacity);
+        if (temp != NULL) memcpy(temp, lb->data, used);
+    }
+    if (temp == NULL) return false;
+    lb->data = temp;
+    lb->capacity = new_capacity;
+    lb->on_heap = true;
+    return true;
+}
+
+// Reads one line into lb->data. Returns false at EOF/error with nothing read.
+// A NUL byte ends the line's text (the rest of that line is skipped); a line
+// that does not fit in memory is returned in pieces.
+static bool read_line_file(FILE *fp, LineBuffer *lb, size_t *length) {
+    size_t size = 0;
+    bool got = false, cut = false;
+    while (1) {
+        size_t avail = lb->capacity - size; // Always >= 2 here
+        if (avail > INT_MAX) avail = INT_MAX;
+        char *chunk = lb->data + size;
+        chunk[avail - 1] = 1; // fgets overwrites this only when it fills the chunk
+        if (fgets(chunk, (int)avail, fp) == NULL) break;
+        got = true;
+        size_t n = strlen(chunk);
+        if (chunk[avail - 1] != '\0') { // Stopped at '\n' or EOF
+            if (!cut) size += n;
+            break;
+        }
+        if (!cut) {
+            size += n;
+            cut = n < avail - 1;
+        }
+        if (chunk[avail - 2] == '\n') break;
+        if (!cut && !line_buffer_grow(lb, size)) break;
+    }
+    if (size > 0 && lb->data[size - 1] == '\n') size--;
+    lb->data[size] = '\0';
+    *length = size;
+    return got;
+}
+
+// Prints the prompt and reads one line of stdin into lb. NULL at EOF/error.
+static const char* prompt_line(const char *prompt, LineBuffer *lb) {
     if (prompt != NULL)
     {
         printf("%s", prompt);
         fflush(stdout);
     }
+    size_t length;
+    return read_line_file(stdin, lb, &length) ? lb->data : NULL;
+}
 
-    char *buffer = NULL;
-    size_t capacity = 0;
-    size_t size = 0;
-    int c;
+// O(1)
+aq_reader* aq_reader_create_file(FILE *fp) {
+    if (fp == NULL) return NULL;
+    aq_reader *reader = calloc(1, sizeof(aq_reader));
+    if (reader == NULL) return NULL;
+    reader->fp = fp;
+    reader->fd = -1;
+    reader->line.data = malloc(LINE_STACK_SIZE);
+    if (reader->line.data == NULL) { free(reader); return NULL; }
+    reader->line.capacity = LINE_STACK_SIZE;
+    reader->line.on_heap = true;
+    return reader;
+}
 
-    while ((c = fgetc(stdin)) != '\n' && c != EOF)
-    {
-        if (size + 1 > capacity)
-        {
-            size_t new_capacity = (capacity == 0) ? 32 : capacity + (capacity / 2);
-            if (new_capacity < size + 1) new_capacity = size + 1;
-            if (new_capacity == capacity) new_capacity++;
-
-            char *temp = realloc(buffer, new_capacity);
-            if (temp == NULL)
-            {
-                if (buffer != NULL) {
-                   buffer[size] = '\0';
-                }
-                return buffer; // Return NULL if nothing read, or partial string on realloc fail
+// O(1). Returns NULL where file descriptors are not available.
+aq_reader* aq_reader_create_fd(int fd) {
+#ifdef AQUANT_HAVE_POSIX_IO
+    if (fd < 0) return NULL;
+    aq_reader *reader = calloc(1, sizeof(aq_reader));
+    if (reader == NULL) return NULL;
+    reader->fd = fd;
+    reader->block_size = READER_BLOCK_SIZE;
+    reader->block = malloc(reader->block_size + 1);
+    if (reader->block == NULL) { free(reader); return NULL; }
+    return reader;
+#else
+    (void)fd;
+    return NULL;
+#endif
+}
+
+// O(1). Borrows data: keep it alive and unchanged while the reader is used.
+aq_reader* aq_reader_create_buffer(const char *data, size_t size) {
+    if (data == NULL && size > 0) return NULL;
+    aq_reader *reader = calloc(1, sizeof(aq_reader));
+    if (reader == NULL) return NULL;
+    reader->memory = (data != NULL) ? data : "";
+    reader->fd = -1;
+    reader->end = size;
+    reader->line.data = malloc(LINE_STACK_SIZE);
+    if (reader->line.data == NULL) { free(reader); return NULL; }
+    reader->line.capacity = LINE_STACK_SIZE;
+    reader->line.on_heap = true;
+    return reader;
+}
+
+void aq_reader_destroy(aq_reader *reader) {
+    if (reader == NULL) return;
+    line_buffer_release(&reader->line);
+    free(reader->block);
+    free(reader);
+}
+
+#ifdef AQUANT_HAVE_POSIX_IO
+// Makes room after the unread bytes (moving them to the front, or doubling
+// the block for a line longer than it) and reads once. False at EOF/error.
+static bool reader_fill(aq_reader *reader) {
+    if (reader->start > 0) {
+        memmove(reader->block, reader->block + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end == reader->block_size) {
+        char *temp = NULL;
+        if (reader->block_size <= (SIZE_MAX - 1) / 2) temp = realloc(reader->block, reader->block_size * 2 + 1);
+        if (temp == NULL) { reader->error = true; return false; }
+        reader->block = temp;
+        reader->block_size *= 2;
+    }
+    while (1) {
+        ssize_t n = read(reader->fd, reader->block + reader->end, reader->block_size - reader->end);
+        if (n > 0) { reader->end += (size_t)n; return true; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) reader->error = true;
+        return false;
+    }
+}
+#endif
+
+// O(L) amortized. The line is borrowed: valid until the next call or destroy.
+const char* aq_reader_next_line(aq_reader *reader, size_t *length) {
+    size_t ignored;
+    if (length == NULL) length = &ignored;
+    *length = 0;
+    if (reader == NULL) return NULL;
+    if (reader->fp != NULL) {
+        if (read_line_file(reader->fp, &reader->line, length)) return reader->line.data;
+        reader->error = ferror(reader->fp) != 0;
+        return NULL;
+    }
+    if (reader->memory != NULL) {
+        if (reader->start >= reader->end) return NULL;
+        const char *begin = reader->memory + reader->start;
+        size_t rest = reader->end - reader->start;
+        const char *newline = memchr(begin, '\n', rest);
+        size_t size = (newline != NULL) ? (size_t)(newline - begin) : rest;
+        while (size >= reader->line.capacity) {
+            if (!line_buffer_grow(&reader->line, 0)) { reader->error = true; return NULL; }
+        }
+        memcpy(reader->line.data, begin, size);
+        reader->line.data[size] = '\0';
+        reader->start += size + (newline != NULL);
+        *length = size;
+        return reader->line.data;
+    }
+#ifdef AQUANT_HAVE_POSIX_IO
+    size_t scanned = 0; // Bytes of the pending line already searched for '\n'
+    while (1) {
+        char *begin = reader->block + reader->start;
+        char *newline = memchr(begin + scanned, '\n', reader->end - reader->start - scanned);
+        if (newline != NULL) {
+            *newline = '\0';
+            *length = (size_t)(newline - begin);
+            reader->start += *length + 1;
+            return begin;
+        }
+        scanned = reader->end - reader->start;
+        if (reader->eof || !reader_fill(reader)) {
+            reader->eof = true;
+            if (reader->start == reader->end) return NULL;
+            begin = reader->block + reader->start;
+            *length = reader->end - reader->start;
+            begin[*length] = '\0'; // The spare byte past block_size
+            reader->start = reader->end;
+            return begin;
+        }
+    }
+#else
+    return NULL;
+#endif
+}
+
+
+// --- Number Parsing ---
+// Locale-independent replacements for strtol/strtof/strtod, used by get_*,
+// aq_input_get_*, aq_scan_* and string_to_*. Whitespace is the ASCII set
+// " \t\n\v\f\r". Digits are taken 8 at a time with SWAR. Decimals try
+// Clinger's exact fast path, then Eisel-Lemire: one (rarely two) 64x64->128
+// multiplications by a truncated power of five give the correctly rounded
+// result. Mantissas longer than 19 digits whose rounding stays ambiguous,
+// and hex floats, are handed to strtod/strtof as a copy without a decimal
+// point (hex floats with the binary exponent adjusted for the fractional
+// digits), so the locale never matters.
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define AQUANT_SWAR_DIGITS 0
+#else
+#define AQUANT_SWAR_DIGITS 1
+#endif
+
+#define DECIMAL_MAX_DIGITS 19 // Always fits a uint64_t
+#define POW5_MIN_EXP (-342)
+#define POW5_MAX_EXP 308
+
+// 128-bit truncated 5^q, normalized so that the top bit is set, for q in
+// [POW5_MIN_EXP, POW5_MAX_EXP] (the fast_float table).
+static const uint64_t pow5_128[POW5_MAX_EXP - POW5_MIN_EXP + 1][2] = {
+    {0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL}, {0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL},
+    {0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL}, {0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL},
+    {0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL}, {0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL},
+    {0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL}, {0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL},
+    {0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL}, {0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL},
+    {0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL}, {0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL},
+    {0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL}, {0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL},
+    {0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL}, {0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL},
+    {0x84a57695fe98746dULL, 0x014bb630f7604b57ULL}, {0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL},
+    {0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL}, {0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL},
+    {0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL}, {0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL},
+    {0xfd00b897478238d0ULL, 0x8920b098955522b4ULL}, {0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL},
+    {0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL}, {0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL},
+    {0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL}, {0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL},
+    {0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL}, {0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL},
+    {0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL}, {0xeba09271e88d976bULL, 0xf7864a44c633682eULL},
+    {0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL}, {0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL},
+    {0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL}, {0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL},
+    {0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL}, {0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL},
+    {0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL}, {0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL},
+    {0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL}, {0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL},
+    {0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL}, {0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL},
+    {0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL}, {0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL},
+    {0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL}, {0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL},
+    {0xa37fce126597973cULL, 0xe50ff107bab528a0ULL}, {0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL},
+    {0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL}, {0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL},
+    {0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL}, {0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL},
+    {0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL}, {0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL},
+    {0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL}, {0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL},
+    {0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL}, {0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL},
+    {0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL}, {0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL},
+    {0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL}, {0x91376c36d99995beULL, 0x23100809b9c21fa1ULL},
+    {0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL}, {0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL},
+    {0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL}, {0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL},
+    {0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL}, {0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL},
+    {0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL}, {0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL},
+    {0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL}, {0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL},
+    {0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL}, {0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL},
+    {0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL}, {0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL},
+    {0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL}, {0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL},
+    {0xc987434744ac874eULL, 0xa327ffb266b56220ULL}, {0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL},
+    {0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL}, {0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL},
+    {0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL}, {0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL},
+    {0xc0314325637a1939ULL, 0xfa911155fefb5308ULL}, {0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL},
+    {0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL}, {0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL},
+    {0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL}, {0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL},
+    {0xb749faed14125d36ULL, 0xcef980ec671f667bULL}, {0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL},
+    {0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL}, {0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL},
+    {0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL}, {0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL},
+    {0xaecc49914078536dULL, 0x58fae9f773886e18ULL}, {0xda7f5bf590966848ULL, 0xaf39a475506a899eULL},
+    {0x888f99797a5e012dULL, 0x6d8406c952429603ULL}, {0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL},
+    {0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL}, {0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL},
+    {0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL}, {0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL},
+    {0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL}, {0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL},
+    {0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL}, {0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL},
+    {0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL}, {0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL},
+    {0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL}, {0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL},
+    {0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL}, {0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL},
+    {0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL}, {0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL},
+    {0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL}, {0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL},
+    {0xb913179899f68584ULL, 0x28e2557b59846e3fULL}, {0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL},
+    {0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL}, {0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL},
+    {0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL}, {0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL},
+    {0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL}, {0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL},
+    {0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL}, {0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL},
+    {0xd77485cb25823ac7ULL, 0x7d633293366b828bULL}, {0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL},
+    {0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL}, {0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL},
+    {0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL}, {0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL},
+    {0xcd795be870516656ULL, 0x67902e276c921f8bULL}, {0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL},
+    {0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL}, {0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL},
+    {0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL}, {0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL},
+    {0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL}, {0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL},
+    {0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL}, {0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL},
+    {0xef340a98172aace4ULL, 0x86fb897116c87c34ULL}, {0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL},
+    {0xbae0a846d2195712ULL, 0x8974836059cca109ULL}, {0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL},
+    {0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL}, {0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL},
+    {0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL}, {0x8e938662882af53eULL, 0x547eb47b7282ee9cULL},
+    {0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL}, {0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL},
+    {0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL}, {0xae0b158b4738705eULL, 0x9624ab50b148d445ULL},
+    {0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL}, {0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL},
+    {0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL}, {0xd47487cc8470652bULL, 0x7647c3200069671fULL},
+    {0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL}, {0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL},
+    {0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL}, {0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL},
+    {0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL}, {0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL},
+    {0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL}, {0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL},
+    {0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL}, {0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL},
+    {0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL}, {0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL},
+    {0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL}, {0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL},
+    {0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL}, {0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL},
+    {0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL}, {0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL},
+    {0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL}, {0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL},
+    {0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL}, {0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL},
+    {0x8c974f7383725573ULL, 0x1e414218c73a13fbULL}, {0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL},
+    {0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL}, {0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL},
+    {0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL}, {0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL},
+    {0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL}, {0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL},
+    {0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL}, {0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL},
+    {0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL}, {0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL},
+    {0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL}, {0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL},
+    {0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL}, {0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL},
+    {0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL}, {0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL},
+    {0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL}, {0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL},
+    {0xbe89523386091465ULL, 0xf6bbb397f1135823ULL}, {0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL},
+    {0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL}, {0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL},
+    {0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL}, {0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL},
+    {0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL}, {0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL},
+    {0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL}, {0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL},
+    {0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL}, {0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL},
+    {0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL}, {0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL},
+    {0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL}, {0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL},
+    {0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL}, {0x843610cb4bf160cbULL, 0xcedf722a585139baULL},
+    {0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL}, {0xce947a3da6a9273eULL, 0x733d226229feea32ULL},
+    {0x811ccc668829b887ULL, 0x0806357d5a3f525fULL}, {0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL},
+    {0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL}, {0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL},
+    {0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL}, {0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL},
+    {0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL}, {0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL},
+    {0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL}, {0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL},
+    {0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL}, {0xbbe226efb628afeaULL, 0x890489f70a55368bULL},
+    {0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL}, {0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL},
+    {0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL}, {0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL},
+    {0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL}, {0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL},
+    {0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL}, {0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL},
+    {0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL}, {0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL},
+    {0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL}, {0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL},
+    {0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL}, {0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL},
+    {0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL}, {0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL},
+    {0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL}, {0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL},
+    {0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL}, {0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL},
+    {0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL}, {0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL},
+    {0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL}, {0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL},
+    {0xc24452da229b021bULL, 0xfbe85badce996168ULL}, {0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL},
+    {0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL}, {0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL},
+    {0xed246723473e3813ULL, 0x290123e9aab23b68ULL}, {0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL},
+    {0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL}, {0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL},
+    {0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL}, {0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL},
+    {0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL}, {0x8d590723948a535fULL, 0x579c487e5a38ad0eULL},
+    {0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL}, {0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL},
+    {0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL}, {0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL},
+    {0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL}, {0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL},
+    {0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL}, {0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL},
+    {0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL}, {0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL},
+    {0xcdb02555653131b6ULL, 0x3792f412cb06794dULL}, {0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL},
+    {0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL}, {0xc8de047564d20a8bULL, 0xf245825a5a445275ULL},
+    {0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL}, {0x9ced737bb6c4183dULL, 0x55464dd69685606bULL},
+    {0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL}, {0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL},
+    {0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL}, {0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL},
+    {0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL}, {0x95a8637627989aadULL, 0xdde7001379a44aa8ULL},
+    {0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL}, {0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL},
+    {0x9226712162ab070dULL, 0xcab3961304ca70e8ULL}, {0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL},
+    {0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL}, {0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL},
+    {0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL}, {0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL},
+    {0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL}, {0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL},
+    {0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL}, {0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL},
+    {0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL}, {0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL},
+    {0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL}, {0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL},
+    {0xcfb11ead453994baULL, 0x67de18eda5814af2ULL}, {0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL},
+    {0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL}, {0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL},
+    {0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL}, {0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL},
+    {0xc612062576589ddaULL, 0x95364afe032a819eULL}, {0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL},
+    {0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL}, {0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL},
+    {0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL}, {0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL},
+    {0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL}, {0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL},
+    {0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL}, {0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL},
+    {0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL}, {0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL},
+    {0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL}, {0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL},
+    {0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL}, {0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL},
+    {0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL}, {0x89705f4136b4a597ULL, 0x31680a88f8953031ULL},
+    {0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL}, {0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL},
+    {0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL}, {0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL},
+    {0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL}, {0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL},
+    {0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL}, {0xccccccccccccccccULL, 0xcccccccccccccccdULL},
+    {0x8000000000000000ULL, 0x0000000000000000ULL}, {0xa000000000000000ULL, 0x0000000000000000ULL},
+    {0xc800000000000000ULL, 0x0000000000000000ULL}, {0xfa00000000000000ULL, 0x0000000000000000ULL},
+    {0x9c40000000000000ULL, 0x0000000000000000ULL}, {0xc350000000000000ULL, 0x0000000000000000ULL},
+    {0xf424000000000000ULL, 0x0000000000000000ULL}, {0x9896800000000000ULL, 0x0000000000000000ULL},
+    {0xbebc200000000000ULL, 0x0000000000000000ULL}, {0xee6b280000000000ULL, 0x0000000000000000ULL},
+    {0x9502f90000000000ULL, 0x0000000000000000ULL}, {0xba43b74000000000ULL, 0x0000000000000000ULL},
+    {0xe8d4a51000000000ULL, 0x0000000000000000ULL}, {0x9184e72a00000000ULL, 0x0000000000000000ULL},
+    {0xb5e620f480000000ULL, 0x0000000000000000ULL}, {0xe35fa931a0000000ULL, 0x0000000000000000ULL},
+    {0x8e1bc9bf04000000ULL, 0x0000000000000000ULL}, {0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL},
+    {0xde0b6b3a76400000ULL, 0x0000000000000000ULL}, {0x8ac7230489e80000ULL, 0x0000000000000000ULL},
+    {0xad78ebc5ac620000ULL, 0x0000000000000000ULL}, {0xd8d726b7177a8000ULL, 0x0000000000000000ULL},
+    {0x878678326eac9000ULL, 0x0000000000000000ULL}, {0xa968163f0a57b400ULL, 0x0000000000000000ULL},
+    {0xd3c21bcecceda100ULL, 0x0000000000000000ULL}, {0x84595161401484a0ULL, 0x0000000000000000ULL},
+    {0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL}, {0xcecb8f27f4200f3aULL, 0x0000000000000000ULL},
+    {0x813f3978f8940984ULL, 0x4000000000000000ULL}, {0xa18f07d736b90be5ULL, 0x5000000000000000ULL},
+    {0xc9f2c9cd04674edeULL, 0xa400000000000000ULL}, {0xfc6f7c4045812296ULL, 0x4d00000000000000ULL},
+    {0x9dc5ada82b70b59dULL, 0xf020000000000000ULL}, {0xc5371912364ce305ULL, 0x6c28000000000000ULL},
+    {0xf684df56c3e01bc6ULL, 0xc732000000000000ULL}, {0x9a130b963a6c115cULL, 0x3c7f400000000000ULL},
+    {0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL}, {0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL},
+    {0x96769950b50d88f4ULL, 0x1314448000000000ULL}, {0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL},
+    {0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL}, {0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL},
+    {0xb7abc627050305adULL, 0xf14a3d9e40000000ULL}, {0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL},
+    {0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL}, {0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL},
+    {0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL}, {0x8c213d9da502de45ULL, 0x4526f422cc340000ULL},
+    {0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL}, {0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL},
+    {0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL}, {0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL},
+    {0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL}, {0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL},
+    {0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL}, {0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL},
+    {0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL}, {0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL},
+    {0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL}, {0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL},
+    {0x9f4f2726179a2245ULL, 0x01d762422c946590ULL}, {0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL},
+    {0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL}, {0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL},
+    {0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL}, {0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL},
+    {0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL}, {0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL},
+    {0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL}, {0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL},
+    {0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL}, {0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL},
+    {0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL}, {0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL},
+    {0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL}, {0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL},
+    {0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL}, {0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL},
+    {0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL}, {0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL},
+    {0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL}, {0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL},
+    {0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL}, {0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL},
+    {0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL}, {0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL},
+    {0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL}, {0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL},
+    {0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL}, {0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL},
+    {0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL}, {0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL},
+    {0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL}, {0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL},
+    {0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL}, {0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL},
+    {0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL}, {0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL},
+    {0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL}, {0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL},
+    {0x924d692ca61be758ULL, 0x593c2626705f9c56ULL}, {0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL},
+    {0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL}, {0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL},
+    {0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL}, {0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL},
+    {0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL}, {0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL},
+    {0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL}, {0x884134fe908658b2ULL, 0x3109058d147fdcddULL},
+    {0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL}, {0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL},
+    {0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL}, {0xa6539930bf6bff45ULL, 0x84db8346b786151cULL},
+    {0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL}, {0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL},
+    {0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL}, {0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL},
+    {0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL}, {0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL},
+    {0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL}, {0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL},
+    {0x9ae757596946075fULL, 0x3375788de9b06958ULL}, {0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL},
+    {0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL}, {0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL},
+    {0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL}, {0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL},
+    {0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL}, {0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL},
+    {0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL}, {0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL},
+    {0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL}, {0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL},
+    {0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL}, {0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL},
+    {0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL}, {0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL},
+    {0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL}, {0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL},
+    {0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL}, {0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL},
+    {0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL}, {0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL},
+    {0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL}, {0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL},
+    {0x802221226be55a64ULL, 0xc2494954da2c9789ULL}, {0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL},
+    {0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL}, {0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL},
+    {0x9c69a97284b578d7ULL, 0xff2a760414536efbULL}, {0xc38413cf25e2d70dULL, 0xfef5138519684abaULL},
+    {0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL}, {0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL},
+    {0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL}, {0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL},
+    {0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL}, {0xba756174393d88dfULL, 0x94f971119aeef9e4ULL},
+    {0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL}, {0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL},
+    {0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL}, {0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL},
+    {0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL}, {0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL},
+    {0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL}, {0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL},
+    {0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL}, {0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL},
+    {0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL}, {0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL},
+    {0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL}, {0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL},
+    {0xa59bc234db398c25ULL, 0x43fab9837e699095ULL}, {0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL},
+    {0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL}, {0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL},
+    {0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL}, {0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL},
+    {0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL}, {0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL},
+    {0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL}, {0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL},
+    {0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL}, {0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL},
+    {0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL}, {0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL},
+    {0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL}, {0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL},
+    {0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL}, {0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL},
+    {0x8fa475791a569d10ULL, 0xf96e017d694487bcULL}, {0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL},
+    {0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL}, {0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL},
+    {0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL}, {0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL},
+    {0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL}, {0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL},
+    {0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL}, {0x85c7056562757456ULL, 0xf6872d5667844e49ULL},
+    {0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL}, {0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL},
+    {0x82a45b450226b39cULL, 0xecc0024661173473ULL}, {0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL},
+    {0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL}, {0xff290242c83396ceULL, 0x7e67047175a15271ULL},
+    {0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL}, {0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL},
+    {0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL}, {0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL},
+    {0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL}, {0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL},
+    {0x98165af37b2153deULL, 0xc3727a337a8b704aULL}, {0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL},
+    {0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL}, {0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL},
+    {0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL}, {0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL},
+    {0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL}, {0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL},
+    {0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL}, {0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL},
+    {0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL}, {0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL},
+    {0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL}, {0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL},
+    {0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL}, {0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL},
+    {0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL}, {0xd31045a8341ca07cULL, 0x1ede48111209a050ULL},
+    {0x83ea2b892091e44dULL, 0x934aed0aab460432ULL}, {0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL},
+    {0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL}, {0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL},
+    {0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL}, {0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL},
+    {0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL}, {0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL},
+    {0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL}, {0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL},
+    {0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL}, {0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL},
+    {0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL}, {0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL},
+    {0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL}, {0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL},
+    {0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL}, {0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL},
+    {0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL}, {0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL},
+    {0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL}, {0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL},
+    {0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL}, {0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL},
+    {0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL}, {0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL},
+    {0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL}, {0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL},
+    {0x8533285c936b35deULL, 0xd53a88958f87275fULL}, {0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL},
+    {0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL}, {0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL},
+    {0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL}, {0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL},
+    {0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL}, {0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL},
+    {0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL}, {0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL},
+    {0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL}, {0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL},
+    {0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL}, {0x976e41088617ca01ULL, 0xd5be0503e085d813ULL},
+    {0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL}, {0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL},
+    {0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL}, {0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL},
+    {0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL}, {0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL},
+    {0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL}, {0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL},
+    {0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL}, {0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL},
+    {0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL}, {0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL},
+    {0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL}, {0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL},
+    {0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL}, {0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL},
+    {0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL}, {0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL},
+    {0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL}, {0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL},
+    {0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL}, {0xa0555e361951c366ULL, 0xd7e105bcc332621fULL},
+    {0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL}, {0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL},
+    {0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL}, {0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL},
+    {0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL}, {0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL},
+    {0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL}, {0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL},
+    {0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL}, {0xbaa718e68396cffdULL, 0xd30560258f54e6baULL},
+    {0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL}, {0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL},
+    {0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL}, {0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL},
+    {0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL},
+};
+
+static const double exact_pow10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+typedef struct FloatFormat {
+    int mantissa_bits;    // Explicit mantissa bits
+    int minimum_exponent; // -bias
+    int infinite_power;   // Biased exponent of inf
+    int min_round_even;   // Decimal exponents where halfway cases can be exact
+    int max_round_even;
+} FloatFormat;
+
+static const FloatFormat double_format = { 52, -1023, 0x7FF, -4, 23 };
+static const FloatFormat float_format = { 23, -127, 0xFF, -17, 10 };
+
+// A decimal as mantissa * 10^exp10, plus the text needed for the fallback.
+typedef struct DecimalNumber {
+    bool negative;
+    uint64_t mantissa;      // First DECIMAL_MAX_DIGITS significant digits
+    int64_t exp10;
+    bool truncated;         // More significant digits than the mantissa holds
+    const char *digits;     // Mantissa text, '.' included
+    const char *digits_end;
+    int64_t text_exp10;     // Exponent for the mantissa text with the '.' removed
+} DecimalNumber;
+
+// High 64 bits of a * b; the low half goes to *lo.
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 aq_uint128; // __extension__: no -pedantic warning in C99/C11 mode
+#endif
+
+static inline uint64_t mul_hi_64(uint64_t a, uint64_t b, uint64_t *lo) {
+#if defined(__SIZEOF_INT128__)
+    aq_uint128 m = (aq_uint128)a * b;
+    *lo = (uint64_t)m;
+    return (uint64_t)(m >> 64);
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+    uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+    *lo = (mid << 32) | (uint32_t)p0;
+    return p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+}
+
+static inline int leading_zeros_64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    while (!(x & (1ULL << 63))) { x <<= 1; n++; }
+    return n;
+#endif
+}
+
+static inline bool parse_is_space(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool parse_is_digit(unsigned char c) {
+    return (unsigned)(c - '0') <= 9;
+}
+
+static const char* parse_skip_space(const char *p, const char *end) {
+    while (p < end && parse_is_space((unsigned char)*p)) p++;
+    return p;
+}
+
+// True if only whitespace is left (a NUL byte ends the text, as for strtol).
+static bool parse_at_end(const char *p, const char *end) {
+    p = parse_skip_space(p, end);
+    return p == end || *p == '\0';
+}
+
+#if AQUANT_SWAR_DIGITS
+static inline uint64_t load_u64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline bool swar_is_8_digits(uint64_t v) {
+    return ((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+static inline uint32_t swar_parse_8_digits(uint64_t v) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);
+    return (uint32_t)((((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32);
+}
+#endif
+
+// Appends the digit run at p to *value. Leading zeros are skipped while
+// *count is 0; *count counts every significant digit, and *value stays
+// exact while *count <= DECIMAL_MAX_DIGITS. Returns the end of the run.
+static const char* parse_digits(const char *p, const char *end, uint64_t *value, size_t *count) {
+    if (*count == 0) {
+        while (p < end && *p == '0') p++;
+    }
+#if AQUANT_SWAR_DIGITS
+    while (end - p >= 8 && *count + 8 <= DECIMAL_MAX_DIGITS) {
+        uint64_t chunk = load_u64(p);
+        if (!swar_is_8_digits(chunk)) break;
+        *value = *value * 100000000 + swar_parse_8_digits(chunk);
+        *count += 8;
+        p += 8;
+    }
+#endif
+    for (; p < end && parse_is_digit((unsigned char)*p); ++p) {
+        if (*count < DECIMAL_MAX_DIGITS) *value = *value * 10 + (unsigned)(*p - '0');
+        (*count)++;
+    }
+    return p;
+}
+
+// strtol(s, &end, 10) without the locale. Returns the end of the number, or
+// begin if there is none. Out-of-range values set *range_error and clamp.
+static const char* parse_integer_prefix(const char *begin, const char *end, long min, long max, long *out, bool *range_error) {
+    const char *p = parse_skip_space(begin, end);
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) negative = (*p++ == '-');
+    if (p == end || !parse_is_digit((unsigned char)*p)) return begin;
+    uint64_t value = 0;
+    size_t count = 0;
+    p = parse_digits(p, end, &value, &count);
+    uint64_t limit = negative ? (uint64_t)0 - (uint64_t)min : (uint64_t)max;
+    *range_error = count > DECIMAL_MAX_DIGITS || value > limit;
+    if (*range_error) *out = negative ? min : max;
+    else if (negative) *out = (value == 0) ? 0 : -(long)(value - 1) - 1;
+    else *out = (long)value;
+    return p;
+}
+
+// floor(log2(10^q)), valid for |q| < 1700.
+static inline int64_t pow10_to_pow2(int64_t q) {
+    return (q >= 0) ? ((217706 * q) >> 16) : -((-217706 * q + 65535) >> 16);
+}
+
+// Eisel-Lemire: w * 10^q rounded to nearest-even in format f, as an
+// explicit mantissa and a biased exponent. w must be non-zero and exact.
+static void eisel_lemire(uint64_t w, int64_t q, const FloatFormat *f, uint64_t *mantissa_out, int *power2_out) {
+    *mantissa_out = 0;
+    *power2_out = 0;
+    if (q < POW5_MIN_EXP) return;
+    if (q > POW5_MAX_EXP) { *power2_out = f->infinite_power; return; }
+    int lz = leading_zeros_64(w);
+    w <<= lz;
+    const uint64_t *pow5 = pow5_128[q - POW5_MIN_EXP];
+    uint64_t lo, hi = mul_hi_64(w, pow5[0], &lo);
+    uint64_t precision_mask = UINT64_MAX >> (f->mantissa_bits + 3);
+    if ((hi & precision_mask) == precision_mask) { // Low bits could still carry: use the rest of 5^q
+        uint64_t lo2, hi2 = mul_hi_64(w, pow5[1], &lo2);
+        lo += hi2;
+        if (hi2 > lo) hi++;
+    }
+    int upperbit = (int)(hi >> 63);
+    int shift = upperbit + 64 - f->mantissa_bits - 3;
+    uint64_t mantissa = hi >> shift;
+    int power2 = (int)(pow10_to_pow2(q) + 63 + upperbit - lz - f->minimum_exponent);
+    if (power2 <= 0) { // Subnormal, or rounds up to the smallest normal
+        if (-power2 + 1 >= 64) return;
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        *mantissa_out = mantissa;
+        *power2_out = (mantissa < (1ULL << f->mantissa_bits)) ? 0 : 1;
+        return;
+    }
+    // Exactly halfway between two floats: round to even instead of up.
+    if (lo <= 1 && q >= f->min_round_even && q <= f->max_round_even && (mantissa & 3) == 1 && (mantissa << shift) == hi) {
+        mantissa &= ~1ULL;
+    }
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ULL << f->mantissa_bits)) {
+        mantissa = 1ULL << f->mantissa_bits;
+        power2++;
+    }
+    mantissa &= ~(1ULL << f->mantissa_bits);
+    if (power2 >= f->infinite_power) { power2 = f->infinite_power; mantissa = 0; }
+    *mantissa_out = mantissa;
+    *power2_out = power2;
+}
+
+// Parses [sign](digits[.digits]|.digits)[(e|E)[sign]digits] at p (no
+// leading whitespace). Returns the end, or p if there is no number.
+static const char* parse_decimal(const char *p, const char *end, DecimalNumber *num) {
+    const char *begin = p;
+    num->negative = false;
+    if (p < end && (*p == '+' || *p == '-')) num->negative = (*p++ == '-');
+    num->digits = p;
+    uint64_t value = 0;
+    size_t count = 0;
+    const char *int_end = parse_digits(p, end, &value, &count);
+    size_t int_len = (size_t)(int_end - p);
+    size_t frac_len = 0;
+    p = int_end;
+    if (p < end && *p == '.') {
+        const char *frac_end = parse_digits(p + 1, end, &value, &count);
+        frac_len = (size_t)(frac_end - (p + 1));
+        if (int_len + frac_len == 0) return begin;
+        p = frac_end;
+    } else if (int_len == 0) {
+        return begin;
+    }
+    num->digits_end = p;
+    int64_t exp = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *e = p + 1;
+        bool exp_negative = false;
+        if (e < end && (*e == '+' || *e == '-')) exp_negative = (*e++ == '-');
+        if (e < end && parse_is_digit((unsigned char)*e)) {
+            for (; e < end && parse_is_digit((unsigned char)*e); ++e) {
+                if (exp < 100000000) exp = exp * 10 + (*e - '0');
             }
-            buffer = temp;
-            capacity = new_capacity;
+            if (exp_negative) exp = -exp;
+            p = e;
         }
-        buffer[size++] = (char) c;
     }
+    num->mantissa = value;
+    num->truncated = count > DECIMAL_MAX_DIGITS;
+    num->text_exp10 = exp - (int64_t)frac_len;
+    num->exp10 = num->text_exp10 + (num->truncated ? (int64_t)(count - DECIMAL_MAX_DIGITS) : 0);
+    return p;
+}
 
-    if (size == 0 && (c == '\n' || c == EOF))
-    {
-        char *empty_buffer = realloc(buffer, 1);
-        if (empty_buffer == NULL) {
-            free(buffer);
-            return NULL;
+// Matches "inf", "infinity" or "nan[(chars)]", case-insensitively. Returns
+// the end of the match, or p.
+static const char* parse_special(const char *p, const char *end, bool *is_nan) {
+    static const char infinity[] = "infinity";
+    size_t avail = (size_t)(end - p), i = 0;
+    while (i < 8 && i < avail && (p[i] | 0x20) == infinity[i]) i++;
+    if (i == 8) { *is_nan = false; return p + 8; }
+    if (i >= 3) { *is_nan = false; return p + 3; }
+    if (avail >= 3 && (p[0] | 0x20) == 'n' && (p[1] | 0x20) == 'a' && (p[2] | 0x20) == 'n') {
+        *is_nan = true;
+        const char *q = p + 3;
+        if (q < end && *q == '(') {
+            const char *r = q + 1;
+            while (r < end && (isalnum((unsigned char)*r) || *r == '_')) r++;
+            if (r < end && *r == ')') return r + 1;
+        }
+        return q;
+    }
+    return p;
+}
+
+// Runs strtod (is_float: strtof) on a NUL-terminated copy of text, which
+// must not depend on the locale. Returns the number of bytes consumed.
+static size_t parse_with_libc(const char *text, size_t length, bool is_float, double *out, bool *range_error) {
+    char small[128];
+    char *copy = (length < sizeof(small)) ? small : malloc(length + 1);
+    if (copy == NULL) return 0;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    char *endptr;
+    errno = 0;
+    double d;
+    if (is_float) {
+        float f = strtof(copy, &endptr);
+        *range_error = errno == ERANGE && (f == HUGE_VALF || f == -HUGE_VALF || f == 0);
+        d = f;
+    } else {
+        d = strtod(copy, &endptr);
+        *range_error = errno == ERANGE && (d == HUGE_VAL || d == -HUGE_VAL || d == 0);
+    }
+    size_t consumed = (size_t)(endptr - copy);
+    if (copy != small) free(copy);
+    *out = d;
+    return consumed;
+}
+
+// Slow path for long ambiguous mantissas: the digits without the '.' plus
+// an explicit exponent, so strtod/strtof never sees a decimal point.
+static bool decimal_with_libc(const DecimalNumber *num, bool is_float, double *out, bool *range_error) {
+    size_t digits = (size_t)(num->digits_end - num->digits);
+    char *text = malloc(digits + 32);
+    if (text == NULL) return false;
+    size_t n = 0;
+    if (num->negative) text[n++] = '-';
+    for (const char *p = num->digits; p < num->digits_end; ++p) {
+        if (*p != '.') text[n++] = *p;
+    }
+    n += (size_t)snprintf(text + n, 32, "e%lld", (long long)num->text_exp10);
+    parse_with_libc(text, n, is_float, out, range_error);
+    free(text);
+    return true;
+}
+
+static inline bool hex_digit(char c) {
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+// Hex float at p ("0x" already checked, sign before it): the hex digits without
+// the '.' plus a binary exponent lowered by 4 per fractional digit, so strtod/strtof
+// never sees a decimal point. Returns the end of the number (just past the '0'
+// when no hex digit follows the "0x", as strtod does), or NULL on allocation failure.
+static const char* hex_with_libc(const char *p, const char *end, bool negative, bool is_float, double *out, bool *range_error) {
+    const char *digits = p + 2, *q = digits;
+    while (q < end && hex_digit(*q)) q++;
+    const char *int_end = q, *frac = q;
+    if (q < end && *q == '.') { frac = ++q; while (q < end && hex_digit(*q)) q++; }
+    size_t int_digits = (size_t)(int_end - digits), frac_digits = (frac < q) ? (size_t)(q - frac) : 0;
+    if (int_digits + frac_digits == 0) {
+        *out = negative ? -0.0 : 0.0;
+        return p + 1;
+    }
+    long long exp2 = 0;
+    if (q < end && (*q | 0x20) == 'p') { // Only an exponent with digits belongs to the number
+        const char *e = q + 1;
+        bool exp_negative = false;
+        if (e < end && (*e == '+' || *e == '-')) exp_negative = (*e++ == '-');
+        if (e < end && *e >= '0' && *e <= '9') {
+            for (; e < end && *e >= '0' && *e <= '9'; ++e) {
+                if (exp2 < 1000000000) exp2 = exp2 * 10 + (*e - '0'); // Saturates far outside any range
+            }
+            if (exp_negative) exp2 = -exp2;
+            q = e;
         }
-        empty_buffer[0] = '\0';
-        return empty_buffer; // Return empty string "" or NULL on malloc fail
+    }
+    char *text = malloc(int_digits + frac_digits + 32);
+    if (text == NULL) return NULL;
+    size_t n = 0;
+    if (negative) text[n++] = '-';
+    text[n++] = '0'; text[n++] = 'x';
+    memcpy(text + n, digits, int_digits); n += int_digits;
+    memcpy(text + n, frac, frac_digits); n += frac_digits;
+    n += (size_t)snprintf(text + n, 32, "p%lld", exp2 - 4 * (long long)frac_digits);
+    parse_with_libc(text, n, is_float, out, range_error);
+    free(text);
+    return q;
+}
+
+// strtod/strtof without the locale: is_float rounds to float precision.
+// Returns the end of the number, or begin if there is none. Overflow to
+// inf and underflow to zero set *range_error (as ERANGE does for the
+// get_* rules); subnormal results do not.
+static const char* parse_real_prefix(const char *begin, const char *end, bool is_float, double *out, bool *range_error) {
+    const char *p = parse_skip_space(begin, end);
+    *range_error = false;
+    const char *body = p;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) negative = (*p++ == '-');
+
+    if (p < end && (*p | 0x20) != 'i' && (*p | 0x20) != 'n') {
+        if (end - p >= 2 && p[0] == '0' && (p[1] | 0x20) == 'x') { // Hex float: rare, leave it to libc
+            const char *hex_end = hex_with_libc(p, end, negative, is_float, out, range_error);
+            return (hex_end == NULL) ? begin : hex_end;
+        }
+    } else if (p < end) {
+        bool is_nan;
+        const char *special_end = parse_special(p, end, &is_nan);
+        if (special_end == p) return begin;
+        *out = is_nan ? NAN : INFINITY;
+        if (negative) *out = -*out;
+        return special_end;
     }
 
-    char *final_buffer = realloc(buffer, size + 1);
-    if (final_buffer == NULL) {
-        if (buffer != NULL) {
-            buffer[size] = '\0';
+    DecimalNumber num;
+    const char *number_end = parse_decimal(body, end, &num);
+    if (number_end == body) return begin;
+    if (num.mantissa == 0) {
+        *out = num.negative ? -0.0 : 0.0;
+        return number_end;
+    }
+#if FLT_EVAL_METHOD == 0
+    if (!is_float && !num.truncated && num.mantissa <= (1ULL << 53) && num.exp10 >= -22 && num.exp10 <= 22) {
+        double value = (double)num.mantissa;
+        value = (num.exp10 < 0) ? value / exact_pow10[-num.exp10] : value * exact_pow10[num.exp10];
+        *out = num.negative ? -value : value;
+        return number_end;
+    }
+#endif
+    const FloatFormat *format = is_float ? &float_format : &double_format;
+    uint64_t mantissa;
+    int power2;
+    eisel_lemire(num.mantissa, num.exp10, format, &mantissa, &power2);
+    if (num.truncated) { // The true mantissa is between w and w + 1
+        uint64_t mantissa_up;
+        int power2_up;
+        eisel_lemire(num.mantissa + 1, num.exp10, format, &mantissa_up, &power2_up);
+        if (mantissa != mantissa_up || power2 != power2_up) {
+            if (!decimal_with_libc(&num, is_float, out, range_error)) return begin;
+            return number_end;
         }
-        return buffer; // Return partial string or NULL on realloc fail
+    }
+    *range_error = power2 == format->infinite_power || (power2 == 0 && mantissa == 0);
+    if (is_float) {
+        uint32_t bits = (uint32_t)mantissa | ((uint32_t)power2 << 23) | ((uint32_t)num.negative << 31);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        *out = f;
+    } else {
+        uint64_t bits = mantissa | ((uint64_t)power2 << 52) | ((uint64_t)num.negative << 63);
+        memcpy(out, &bits, sizeof(*out));
+    }
+    return number_end;
+}
+
+static const char* parse_double_prefix(const char *begin, const char *end, double *out, bool *range_error) {
+    return parse_real_prefix(begin, end, false, out, range_error);
+}
+
+static const char* parse_float_prefix(const char *begin, const char *end, float *out, bool *range_error) {
+    double value;
+    const char *p = parse_real_prefix(begin, end, true, &value, range_error);
+    *out = (float)value; // Already rounded to float precision: exact
+    return p;
+}
+
+
+// --- Original Input Functions ---
+// Every get_* reads through the line reader into a stack buffer (heap only
+// for lines over LINE_STACK_SIZE bytes), so only get_string allocates.
+// The parse_*_line helpers hold the validation rules shared with the
+// aq_input_get_* functions; a NULL line (EOF) parses like an empty one.
+typedef enum ParseResult {
+    PARSE_OK,
+    PARSE_NO_NUMBER,
+    PARSE_OUT_OF_RANGE,
+    PARSE_TRAILING // A number followed by something other than whitespace
+} ParseResult;
+
+static ParseResult parse_integer_line(const char *line, long min, long max, long *out) {
+    if (line == NULL) return PARSE_NO_NUMBER;
+    const char *end = line + strlen(line);
+    bool range_error;
+    long n;
+    const char *p = parse_integer_prefix(line, end, min, max, &n, &range_error);
+    if (p == line) return PARSE_NO_NUMBER;
+    if (range_error) return PARSE_OUT_OF_RANGE;
+    if (!parse_at_end(p, end)) return PARSE_TRAILING;
+    *out = n;
+    return PARSE_OK;
+}
+
+static ParseResult parse_float_line(const char *line, float *out) {
+    if (line == NULL) return PARSE_NO_NUMBER;
+    const char *end = line + strlen(line);
+    bool range_error;
+    float f;
+    const char *p = parse_float_prefix(line, end, &f, &range_error);
+    if (p == line) return PARSE_NO_NUMBER;
+    if (range_error) return PARSE_OUT_OF_RANGE;
+    if (!parse_at_end(p, end)) return PARSE_TRAILING;
+    *out = f;
+    return PARSE_OK;
+}
+
+static ParseResult parse_double_line(const char *line, double *out) {
+    if (line == NULL) return PARSE_NO_NUMBER;
+    const char *end = line + strlen(line);
+    bool range_error;
+    double d;
+    const char *p = parse_double_prefix(line, end, &d, &range_error);
+    if (p == line) return PARSE_NO_NUMBER;
+    if (range_error) return PARSE_OUT_OF_RANGE;
+    if (!parse_at_end(p, end)) return PARSE_TRAILING;
+    *out = d;
+    return PARSE_OK;
+}
+
+string get_string(const char *prompt)
+{
+    char storage[LINE_STACK_SIZE];
+    LineBuffer lb = { storage, sizeof(storage), false };
+    if (prompt != NULL)
+    {
+        printf("%s", prompt);
+        fflush(stdout);
     }
 
-    final_buffer[size] = '\0';
-    return final_buffer; // Caller must free
+    size_t size = 0;
+    read_line_file(stdin, &lb, &size); // EOF with nothing read gives ""
+
+    char *result = malloc(size + 1);
+    if (result != NULL) {
+        memcpy(result, lb.data, size + 1);
+    }
+    line_buffer_release(&lb);
+    return result; // Caller must free
 }
 
 
 char get_char(const char *prompt)
 {
+    char storage[LINE_STACK_SIZE];
+    LineBuffer lb = { storage, sizeof(storage), false };
     const char *current_prompt = prompt;
     while (1)
     {
-        string line = get_string(current_prompt);
-        if (line == NULL)
-        {
-             fprintf(stderr, "\nInput error or EOF. Please try again.\n");
-             current_prompt = "Retry: ";
-             continue;
-        }
+        const char *line = prompt_line(current_prompt, &lb);
+        if (line == NULL) line = ""; // EOF reads as an empty line, as before
 
         if (line[0] != '\0' && line[1] == '\0')
         {
             char c = line[0];
-            free(line);
+            line_buffer_release(&lb);
             return c;
         }
 
-        free(line);
         printf("Invalid input. Please enter exactly one character.\n");
         current_prompt = "Retry: ";
     }
@@ -109,341 +1114,2103 @@ char get_char(const char *prompt)
 
 int get_int(const char *prompt)
 {
+    char storage[LINE_STACK_SIZE];
+    LineBuffer lb = { storage, sizeof(storage), false };
     const char *current_prompt = prompt;
     while (1)
     {
-        string line = get_string(current_prompt);
-        if (line == NULL) {
-             fprintf(stderr, "\nInput error or EOF. Please try again.\n");
-             current_prompt = "Retry: ";
-             continue;
-        }
-
-        char *endptr;
-        errno = 0;
-        long n = strtol(line, &endptr, 10);
-
-        if (endptr == line || errno == ERANGE || n < INT_MIN || n > INT_MAX) {
-             free(line);
-             printf("Invalid input or out of range. Please enter an integer.\n");
-             current_prompt = "Retry: ";
-             continue;
+        const char *line = prompt_line(current_prompt, &lb);
+        long value;
+        ParseResult result = parse_integer_line(line, INT_MIN, INT_MAX, &value);
+        if (result == PARSE_OK) {
+            line_buffer_release(&lb);
+            return (int) value;
         }
-
-        char *check_ptr = endptr;
-        while (isspace((unsigned char)*check_ptr)) check_ptr++;
-        if (*check_ptr != '\0') {
-             free(line);
-             printf("Invalid input. Please enter only an integer.\n");
-             current_prompt = "Retry: ";
-             continue;
-        }
-
-        free(line);
-        return (int) n;
+        if (result == PARSE_TRAILING) printf("Invalid input. Please enter only an integer.\n");
+        else printf("Invalid input or out of range. Please enter an integer.\n");
+        current_prompt = "Retry: ";
     }
 }
 
 
 long get_long(const char *prompt)
 {
+    char storage[LINE_STACK_SIZE];
+    LineBuffer lb = { storage, sizeof(storage), false };
     const char *current_prompt = prompt;
     while (1)
     {
-        string line = get_string(current_prompt);
-         if (line == NULL) {
-             fprintf(stderr, "\nInput error or EOF. Please try again.\n");
-             current_prompt = "Retry: ";
-             continue;
+        const char *line = prompt_line(current_prompt, &lb);
+        long value;
+        ParseResult result = parse_integer_line(line, LONG_MIN, LONG_MAX, &value);
+        if (result == PARSE_OK) {
+            line_buffer_release(&lb);
+            return value;
         }
-
-        char *endptr;
-        errno = 0;
-        long n = strtol(line, &endptr, 10);
-
-        if (endptr == line || errno == ERANGE) {
-            free(line);
-             printf("Invalid input or out of range. Please enter a long integer.\n");
-             current_prompt = "Retry: ";
-             continue;
-        }
-
-        char *check_ptr = endptr;
-        while (isspace((unsigned char)*check_ptr)) check_ptr++;
-        if (*check_ptr != '\0') {
-             free(line);
-             printf("Invalid input. Please enter only a long integer.\n");
-             current_prompt = "Retry: ";
-             continue;
-        }
-
-        free(line);
-        return n;
+        if (result == PARSE_TRAILING) printf("Invalid input. Please enter only a long integer.\n");
+        else printf("Invalid input or out of range. Please enter a long integer.\n");
+        current_prompt = "Retry: ";
     }
 }
 
 
 float get_float(const char *prompt)
 {
+    char storage[LINE_STACK_SIZE];
+    LineBuffer lb = { storage, sizeof(storage), false };
     const char *current_prompt = prompt;
     while (1)
     {
-        string line = get_string(current_prompt);
-        if (line == NULL) {
-             fprintf(stderr, "\nInput error or EOF. Please try again.\n");
-             current_prompt = "Retry: ";
-             continue;
-        }
-
-        char *endptr;
-        errno = 0;
-        float f = strtof(line, &endptr);
-
-        if (endptr == line || (errno == ERANGE && (f == HUGE_VALF || f == -HUGE_VALF || f == 0))) {
-            free(line);
-             printf("Invalid input or out of range. Please enter a floating-point number.\n");
-             current_prompt = "Retry: ";
-             continue;
-        }
-
-        char *check_ptr = endptr;
-        while (isspace((unsigned char)*check_ptr)) check_ptr++;
-        if (*check_ptr != '\0') {
-             free(line);
-             printf("Invalid input. Please enter only a floating-point number.\n");
-             current_prompt = "Retry: ";
-             continue;
+        const char *line = prompt_line(current_prompt, &lb);
+        float value;
+        ParseResult result = parse_float_line(line, &value);
+        if (result == PARSE_OK) {
+            line_buffer_release(&lb);
+            return value;
         }
-
-        free(line);
-        return f;
+        if (result == PARSE_TRAILING) printf("Invalid input. Please enter only a floating-point number.\n");
+        else printf("Invalid input or out of range. Please enter a floating-point number.\n");
+        current_prompt = "Retry: ";
     }
 }
 
 
 double get_double(const char *prompt)
 {
+    char storage[LINE_STACK_SIZE];
+    LineBuffer lb = { storage, sizeof(storage), false };
     const char *current_prompt = prompt;
-     while (1)
+    while (1)
     {
-        string line = get_string(current_prompt);
-        if (line == NULL) {
-             fprintf(stderr, "\nInput error or EOF. Please try again.\n");
-             current_prompt = "Retry: ";
-             continue;
+        const char *line = prompt_line(current_prompt, &lb);
+        double value;
+        ParseResult result = parse_double_line(line, &value);
+        if (result == PARSE_OK) {
+            line_buffer_release(&lb);
+            return value;
         }
+        if (result == PARSE_TRAILING) printf("Invalid input. Please enter only a double-precision number.\n");
+        else printf("Invalid input or out of range. Please enter a double-precision number.\n");
+        current_prompt = "Retry: ";
+    }
+}
 
-        char *endptr;
-        errno = 0;
-        double d = strtod(line, &endptr);
 
-        if (endptr == line || (errno == ERANGE && (d == HUGE_VAL || d == -HUGE_VAL || d == 0))) {
-            free(line);
-            printf("Invalid input or out of range. Please enter a double-precision number.\n");
-            current_prompt = "Retry: ";
-             continue;
-        }
+// --- Input Context ---
+// Non-interactive get_*: same parse rules, no prompts, no retries. Every call
+// consumes exactly one line, so after AQ_INPUT_INVALID/RANGE the caller can
+// simply move on to the next line.
+struct aq_input_ctx {
+    aq_reader *reader;
+    size_t line_number; // Lines consumed so far
+};
+
+static aq_input_ctx* input_ctx_wrap(aq_reader *reader) {
+    if (reader == NULL) return NULL;
+    aq_input_ctx *ctx = malloc(sizeof(aq_input_ctx));
+    if (ctx == NULL) { aq_reader_destroy(reader); return NULL; }
+    ctx->reader = reader;
+    ctx->line_number = 0;
+    return ctx;
+}
 
-        char *check_ptr = endptr;
-        while (isspace((unsigned char)*check_ptr)) check_ptr++;
-         if (*check_ptr != '\0') {
-             free(line);
-             printf("Invalid input. Please enter only a double-precision number.\n");
-             current_prompt = "Retry: ";
-             continue;
-        }
+aq_input_ctx* aq_input_create_file(FILE *fp) {
+    return input_ctx_wrap(aq_reader_create_file(fp));
+}
 
-        free(line);
-        return d;
-    }
+aq_input_ctx* aq_input_create_fd(int fd) {
+    return input_ctx_wrap(aq_reader_create_fd(fd));
+}
+
+aq_input_ctx* aq_input_create_buffer(const char *data, size_t size) {
+    return input_ctx_wrap(aq_reader_create_buffer(data, size));
 }
 
+void aq_input_destroy(aq_input_ctx *ctx) {
+    if (ctx == NULL) return;
+    aq_reader_destroy(ctx->reader);
+    free(ctx);
+}
 
-// --- Original Integer Array Functions ---
-// ... (array_max, array_min, array_sum, etc. - unchanged) ...
-bool array_max(const int *arr, size_t size, int *max_val) {
-    if (arr == NULL || size == 0 || max_val == NULL) return false;
-    *max_val = arr[0];
-    for (size_t i = 1; i < size; ++i) {
-        if (arr[i] > *max_val) *max_val = arr[i];
-    }
-    return true;
+size_t aq_input_line_number(const aq_input_ctx *ctx) {
+    return (ctx != NULL) ? ctx->line_number : 0;
 }
 
-bool array_min(const int *arr, size_t size, int *min_val) {
-    if (arr == NULL || size == 0 || min_val == NULL) return false;
-    *min_val = arr[0];
-    for (size_t i = 1; i < size; ++i) {
-        if (arr[i] < *min_val) *min_val = arr[i];
+static aq_input_status status_of(ParseResult result) {
+    switch (result) {
+        case PARSE_OK: return AQ_INPUT_OK;
+        case PARSE_OUT_OF_RANGE: return AQ_INPUT_RANGE;
+        default: return AQ_INPUT_INVALID;
     }
-    return true;
 }
 
-bool array_sum(const int *arr, size_t size, long long *sum) {
-    if (sum == NULL) return false;
-    if (arr == NULL || size == 0) { *sum = 0; return true; }
-    *sum = 0;
-    for (size_t i = 0; i < size; ++i) { *sum += arr[i]; }
-    return true;
+// O(L). The line is borrowed: valid until the next call on ctx.
+aq_input_status aq_input_get_line(aq_input_ctx *ctx, const char **line, size_t *length) {
+    if (ctx == NULL || line == NULL) return AQ_INPUT_ERROR;
+    *line = aq_reader_next_line(ctx->reader, length);
+    if (*line == NULL) return ctx->reader->error ? AQ_INPUT_ERROR : AQ_INPUT_EOF;
+    ctx->line_number++;
+    return AQ_INPUT_OK;
 }
 
-bool array_contains_int(const int *arr, size_t size, int value) {
-    if (arr == NULL || size == 0) return false;
-    for (size_t i = 0; i < size; ++i) {
-        if (arr[i] == value) return true;
-    }
-    return false;
+aq_input_status aq_input_get_string(aq_input_ctx *ctx, string *out) {
+    if (out == NULL) return AQ_INPUT_ERROR;
+    *out = NULL;
+    const char *line;
+    size_t length;
+    aq_input_status status = aq_input_get_line(ctx, &line, &length);
+    if (status != AQ_INPUT_OK) return status;
+    *out = malloc(length + 1);
+    if (*out == NULL) return AQ_INPUT_ERROR;
+    memcpy(*out, line, length + 1);
+    return AQ_INPUT_OK; // Caller must free
 }
 
-int array_index_of_int(const int *arr, size_t size, int value) {
-    if (arr == NULL || size == 0) return -1;
-    for (size_t i = 0; i < size; ++i) {
-        if (arr[i] == value) return (i > INT_MAX) ? -1 : (int)i; // Check index fits int
+aq_input_status aq_input_get_string_non_empty(aq_input_ctx *ctx, string *out) {
+    if (out == NULL) return AQ_INPUT_ERROR;
+    aq_input_status status = aq_input_get_string(ctx, out);
+    if (status == AQ_INPUT_OK && **out == '\0') {
+        free(*out);
+        *out = NULL;
+        return AQ_INPUT_INVALID;
     }
-    return -1;
+    return status;
 }
 
-double array_average(const int *arr, size_t size) {
-    if (arr == NULL || size == 0) return NAN;
-    long long sum;
-    if (!array_sum(arr, size, &sum)) return NAN;
-    return (double)sum / size;
+aq_input_status aq_input_get_char(aq_input_ctx *ctx, char *out) {
+    const char *line;
+    aq_input_status status = aq_input_get_line(ctx, &line, NULL);
+    if (status != AQ_INPUT_OK) return status;
+    if (line[0] == '\0' || line[1] != '\0') return AQ_INPUT_INVALID;
+    if (out != NULL) *out = line[0];
+    return AQ_INPUT_OK;
 }
 
-size_t array_count_occurrence(const int *arr, size_t size, int value) {
-    if (arr == NULL || size == 0) return 0;
-    size_t count = 0;
-    for (size_t i = 0; i < size; ++i) {
-        if (arr[i] == value) count++;
-    }
-    return count;
+aq_input_status aq_input_get_int(aq_input_ctx *ctx, int *out) {
+    return aq_input_get_int_range(ctx, INT_MIN, INT_MAX, out);
 }
 
-int* array_copy_int(const int *arr, size_t size) {
-    if (arr == NULL || size == 0) return NULL;
-    int *copy = malloc(size * sizeof(int));
-    if (copy == NULL) return NULL; // Allocation failed
-    memcpy(copy, arr, size * sizeof(int));
-    return copy; // Caller must free
+aq_input_status aq_input_get_int_range(aq_input_ctx *ctx, int min, int max, int *out) {
+    const char *line;
+    aq_input_status status = aq_input_get_line(ctx, &line, NULL);
+    if (status != AQ_INPUT_OK) return status;
+    long value;
+    status = status_of(parse_integer_line(line, INT_MIN, INT_MAX, &value));
+    if (status == AQ_INPUT_OK && (value < min || value > max)) return AQ_INPUT_RANGE;
+    if (status == AQ_INPUT_OK && out != NULL) *out = (int) value;
+    return status;
 }
 
+aq_input_status aq_input_get_long(aq_input_ctx *ctx, long *out) {
+    const char *line;
+    aq_input_status status = aq_input_get_line(ctx, &line, NULL);
+    if (status != AQ_INPUT_OK) return status;
+    long value;
+    status = status_of(parse_integer_line(line, LONG_MIN, LONG_MAX, &value));
+    if (status == AQ_INPUT_OK && out != NULL) *out = value;
+    return status;
+}
 
-// --- Hash Table Helper Functions ---
-// ... (ht_create, ht_destroy, ht_search, ht_insert, ht_contains_key - unchanged) ...
-typedef struct HashNode {
-    int key;
-    int count;
-    struct HashNode *next;
-} HashNode;
+aq_input_status aq_input_get_float(aq_input_ctx *ctx, float *out) {
+    const char *line;
+    aq_input_status status = aq_input_get_line(ctx, &line, NULL);
+    if (status != AQ_INPUT_OK) return status;
+    float value;
+    status = status_of(parse_float_line(line, &value));
+    if (status == AQ_INPUT_OK && out != NULL) *out = value;
+    return status;
+}
+
+aq_input_status aq_input_get_double(aq_input_ctx *ctx, double *out) {
+    const char *line;
+    aq_input_status status = aq_input_get_line(ctx, &line, NULL);
+    if (status != AQ_INPUT_OK) return status;
+    double value;
+    status = status_of(parse_double_line(line, &value));
+    if (status == AQ_INPUT_OK && out != NULL) *out = value;
+    return status;
+}
 
-typedef struct HashTable {
-    HashNode **buckets;
-    size_t table_size;
-} HashTable;
 
-static size_t hash_func(int key, size_t table_size) {
-    return (size_t)llabs((long long)key) % table_size;
+// --- Numeric Scanner ---
+// Reads whitespace-separated numbers to EOF in SCAN_BLOCK_SIZE chunks; a
+// token cut by the end of a chunk is moved to the front and finished by the
+// next read. Tokens go through the Number Parsing functions, so they
+// follow the get_int/get_double rules.
+#define SCAN_BLOCK_SIZE 65536
+#define SCAN_INITIAL_CAPACITY 1024
+
+typedef struct ScanArray {
+    bool is_double;
+    void *values;     // int or double elements
+    size_t count;
+    size_t capacity;
+    bool failed;      // Bad token, read error or allocation failure
+} ScanArray;
+
+// A token is valid only if the number covers all of it.
+static bool scan_parse_int(const char *p, const char *end, int *out) {
+    long value;
+    bool range_error;
+    if (parse_integer_prefix(p, end, INT_MIN, INT_MAX, &value, &range_error) != end || range_error) return false;
+    *out = (int)value;
+    return true;
 }
 
-static HashTable* ht_create(size_t initial_size) {
-    if (initial_size < 7) initial_size = 101;
-    HashTable *ht = malloc(sizeof(HashTable));
-    if (!ht) return NULL;
-    ht->buckets = calloc(initial_size, sizeof(HashNode*));
-    if (!ht->buckets) { free(ht); return NULL; }
-    ht->table_size = initial_size;
-    return ht;
+static bool scan_parse_double(const char *p, const char *end, double *out) {
+    bool range_error;
+    return parse_double_prefix(p, end, out, &range_error) == end && !range_error;
 }
 
-static void ht_destroy(HashTable *ht) {
-    if (!ht) return;
-    for (size_t i = 0; i < ht->table_size; ++i) {
-        HashNode *current = ht->buckets[i];
-        while (current) {
-            HashNode *temp = current;
-            current = current->next;
-            free(temp);
+static bool scan_push(ScanArray *arr, const char *token, const char *end) {
+    size_t elem_size = arr->is_double ? sizeof(double) : sizeof(int);
+    if (arr->count == arr->capacity) {
+        size_t new_capacity = (arr->capacity == 0) ? SCAN_INITIAL_CAPACITY : arr->capacity * 2;
+        if (new_capacity > SIZE_MAX / elem_size) return false;
+        void *temp = realloc(arr->values, new_capacity * elem_size);
+        if (temp == NULL) return false;
+        arr->values = temp;
+        arr->capacity = new_capacity;
+    }
+    if (arr->is_double) return scan_parse_double(token, end, (double*)arr->values + arr->count++);
+    return scan_parse_int(token, end, (int*)arr->values + arr->count++);
+}
+
+// Parses every token in [p, end). Unless this is the final chunk, a token
+// that runs into 'end' is left alone; returns where parsing stopped.
+static const char* scan_tokens(ScanArray *arr, const char *p, const char *end, bool final) {
+    while (1) {
+        while (p < end && parse_is_space((unsigned char)*p)) p++;
+        if (p == end) return p;
+        const char *token = p;
+        while (p < end && !parse_is_space((unsigned char)*p)) p++;
+        if (p == end && !final) return token;
+        if (!scan_push(arr, token, p)) {
+            arr->failed = true;
+            return end;
         }
     }
-    free(ht->buckets);
-    free(ht);
 }
 
-static HashNode* ht_search(HashTable *ht, int key) {
-    if (!ht) return NULL;
-    size_t index = hash_func(key, ht->table_size);
-    HashNode *current = ht->buckets[index];
-    while (current) {
-        if (current->key == key) return current;
-        current = current->next;
+// Hands back the values (shrunk to fit), or NULL with *count = 0 for empty input or failure.
+static void* scan_finish(ScanArray *arr, size_t *count) {
+    if (arr->failed || arr->count == 0) {
+        free(arr->values);
+        *count = 0;
+        return NULL;
     }
-    return NULL;
+    size_t elem_size = arr->is_double ? sizeof(double) : sizeof(int);
+    void *shrunk = realloc(arr->values, arr->count * elem_size);
+    *count = arr->count;
+    return (shrunk != NULL) ? shrunk : arr->values;
 }
 
-static bool ht_insert(HashTable *ht, int key) {
-    if (!ht) return false;
-    size_t index = hash_func(key, ht->table_size);
-    HashNode *current = ht->buckets[index];
-    while (current) {
-        if (current->key == key) { current->count++; return true; }
-        current = current->next;
-    }
-    HashNode *new_node = malloc(sizeof(HashNode));
-    if (!new_node) return false;
-    new_node->key = key;
-    new_node->count = 1;
-    new_node->next = ht->buckets[index];
-    ht->buckets[index] = new_node;
-    return true;
+// Reads fp (or fd when fp is NULL) to EOF.
+static void* scan_stream(FILE *fp, int fd, bool is_double, size_t *count) {
+    ScanArray arr = { is_double, NULL, 0, 0, false };
+    size_t capacity = SCAN_BLOCK_SIZE, length = 0;
+    char *buffer = malloc(capacity);
+    if (buffer == NULL) arr.failed = true;
+    bool eof = false;
+    while (!eof && !arr.failed) {
+        if (length == capacity) { // One token longer than the whole buffer
+            char *temp = (capacity <= SIZE_MAX / 2) ? realloc(buffer, capacity * 2) : NULL;
+            if (temp == NULL) { arr.failed = true; break; }
+            buffer = temp;
+            capacity *= 2;
+        }
+        size_t n = 0;
+        if (fp != NULL) {
+            n = fread(buffer + length, 1, capacity - length, fp);
+            if (n == 0 && ferror(fp)) arr.failed = true;
+        } else {
+#ifdef AQUANT_HAVE_POSIX_IO
+            ssize_t got;
+            do {
+                got = read(fd, buffer + length, capacity - length);
+            } while (got < 0 && errno == EINTR);
+            if (got < 0) arr.failed = true;
+            else n = (size_t)got;
+#else
+            (void)fd;
+            arr.failed = true;
+#endif
+        }
+        eof = (n == 0);
+        length += n;
+        const char *stop = scan_tokens(&arr, buffer, buffer + length, eof);
+        length -= (size_t)(stop - buffer);
+        memmove(buffer, stop, length);
+    }
+    free(buffer);
+    return scan_finish(&arr, count);
 }
 
-static bool ht_contains_key(HashTable *ht, int key) {
-    return ht_search(ht, key) != NULL;
+// O(n). Caller must free. NULL (count 0) on empty input, a token that is not an int, or a read error.
+int* aq_scan_int_array(FILE *fp, size_t *count) {
+    if (count == NULL) return NULL;
+    *count = 0;
+    if (fp == NULL) return NULL;
+    return scan_stream(fp, -1, false, count);
 }
 
+int* aq_scan_int_array_fd(int fd, size_t *count) {
+    if (count == NULL) return NULL;
+    *count = 0;
+    if (fd < 0) return NULL;
+    return scan_stream(NULL, fd, false, count);
+}
 
-// --- Pair Functions ---
-// ... (array_has_pair_sum, array_has_pair_product, array_has_pair_difference - unchanged) ...
-bool array_has_pair_sum(const int *arr, size_t size, int target) {
-    if (arr == NULL || size < 2) return false;
-    HashTable *ht = ht_create(size);
-    if (!ht) return false;
-    bool found = false;
-    for (size_t i = 0; i < size; ++i) {
-        long long complement_ll = (long long)target - arr[i];
-        if (complement_ll >= INT_MIN && complement_ll <= INT_MAX) {
-             if (ht_contains_key(ht, (int)complement_ll)) {
-                  found = true;
-                  break;
-             }
-        }
-        ht_insert(ht, arr[i]);
-    }
-    ht_destroy(ht);
-    return found;
+int* aq_scan_int_array_buffer(const char *data, size_t size, size_t *count) {
+    if (count == NULL) return NULL;
+    *count = 0;
+    if (data == NULL) return NULL;
+    ScanArray arr = { false, NULL, 0, 0, false };
+    scan_tokens(&arr, data, data + size, true);
+    return scan_finish(&arr, count);
 }
 
+// O(n). Caller must free. NULL (count 0) on empty input, a token that get_double would reject, or a read error.
+double* aq_scan_double_array(FILE *fp, size_t *count) {
+    if (count == NULL) return NULL;
+    *count = 0;
+    if (fp == NULL) return NULL;
+    return scan_stream(fp, -1, true, count);
+}
 
-bool array_has_pair_product(const int *arr, size_t size, int target) {
-    if (arr == NULL || size < (target == 0 ? 1 : 2)) return false;
-    if (target != 0 && size < 2) return false; // Ensure size >= 2 for non-zero target
+double* aq_scan_double_array_fd(int fd, size_t *count) {
+    if (count == NULL) return NULL;
+    *count = 0;
+    if (fd < 0) return NULL;
+    return scan_stream(NULL, fd, true, count);
+}
 
-    HashTable *ht = ht_create(size);
-    if (!ht) return false;
+double* aq_scan_double_array_buffer(const char *data, size_t size, size_t *count) {
+    if (count == NULL) return NULL;
+    *count = 0;
+    if (data == NULL) return NULL;
+    ScanArray arr = { true, NULL, 0, 0, false };
+    scan_tokens(&arr, data, data + size, true);
+    return scan_finish(&arr, count);
+}
 
-    bool found = false;
-    for (size_t i = 0; i < size; ++i) {
-         int current_val = arr[i];
 
-         if (target == 0) {
-             if (current_val == 0) {
-                 // Need another element (zero or non-zero) if target is 0. Size check handles this.
+// --- Binary Array Files ---
+// A 64-byte header (magic, version, byte order, element type and size,
+// count, data offset) followed by the raw elements, so the data starts
+// 64-byte aligned. aq_array_map_* maps the file read-only and returns a
+// pointer just past the header, so it can go straight into the array_*
+// functions. aq_array_unmap finds the mapping length in that header.
+// Without mmap the whole file is read into one allocation instead.
+#define ARRAY_FILE_VERSION 1
+#define ARRAY_FILE_HEADER_SIZE 64
+#define ARRAY_FILE_BYTE_ORDER 0x01020304u
+
+#ifdef AQUANT_HAVE_POSIX_IO
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#elif defined(_WIN32)
+#include <malloc.h>
+#define array_file_alloc(size) _aligned_malloc((size), ARRAY_FILE_HEADER_SIZE)
+#define array_file_free(ptr) _aligned_free(ptr)
+#else
+// C99 fallback: over-allocate with malloc, align by hand and keep the raw
+// pointer in the word just below the aligned block for array_file_free.
+static void* array_file_alloc(size_t size) {
+    if (size > SIZE_MAX - ARRAY_FILE_HEADER_SIZE - sizeof(void*)) return NULL;
+    unsigned char *raw = malloc(size + ARRAY_FILE_HEADER_SIZE + sizeof(void*));
+    if (raw == NULL) return NULL;
+    uintptr_t start = (uintptr_t)(raw + sizeof(void*));
+    unsigned char *aligned = raw + sizeof(void*) + (size_t)((ARRAY_FILE_HEADER_SIZE - start % ARRAY_FILE_HEADER_SIZE) % ARRAY_FILE_HEADER_SIZE);
+    memcpy(aligned - sizeof(void*), &raw, sizeof(void*));
+    return aligned;
+}
+
+static void array_file_free(void *ptr) {
+    void *raw;
+    memcpy(&raw, (unsigned char*)ptr - sizeof(void*), sizeof(void*));
+    free(raw);
+}
+#endif
+
+enum { ARRAY_FILE_INT = 1, ARRAY_FILE_FLOAT = 2, ARRAY_FILE_DOUBLE = 3 };
+
+typedef struct ArrayFileHeader {
+    char magic[8];          // "AQARRAY\0"
+    uint32_t version;
+    uint32_t byte_order;    // ARRAY_FILE_BYTE_ORDER as stored by the writer
+    uint32_t type;          // ARRAY_FILE_INT / _FLOAT / _DOUBLE
+    uint32_t elem_size;
+    uint64_t count;
+    uint64_t data_offset;   // ARRAY_FILE_HEADER_SIZE: the data alignment
+    unsigned char reserved[24];
+} ArrayFileHeader;
+
+static const char array_file_magic[8] = "AQARRAY";
+
+static bool array_file_save(const char *path, uint32_t type, const void *arr, size_t elem_size, size_t size) {
+    if (path == NULL || (arr == NULL && size > 0)) return false;
+    ArrayFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, array_file_magic, sizeof(header.magic));
+    header.version = ARRAY_FILE_VERSION;
+    header.byte_order = ARRAY_FILE_BYTE_ORDER;
+    header.type = type;
+    header.elem_size = (uint32_t)elem_size;
+    header.count = size;
+    header.data_offset = ARRAY_FILE_HEADER_SIZE;
+
+    // Write a temporary file next to path and rename it over path only once
+    // it is complete: a failed save leaves the old file untouched, and readers
+    // that have the old file mapped keep their pages (rename never truncates).
+    // The name is unique per process (pid) and per concurrent save (address).
+    char *tmp_path = malloc(strlen(path) + 64);
+    if (tmp_path == NULL) return false;
+#ifdef AQUANT_HAVE_POSIX_IO
+    sprintf(tmp_path, "%s.%ld.%lx.tmp", path, (long)getpid(), (unsigned long)(uintptr_t)tmp_path);
+#else
+    sprintf(tmp_path, "%s.%lx.tmp", path, (unsigned long)(uintptr_t)tmp_path);
+#endif
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) { free(tmp_path); return false; }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (ok && size > 0) ok = fwrite(arr, elem_size, size, fp) == size;
+    if (fflush(fp) != 0) ok = false;
+    if (fclose(fp) != 0) ok = false;
+    if (ok && rename(tmp_path, path) != 0) {
+#ifdef _WIN32
+        ok = remove(path) == 0 && rename(tmp_path, path) == 0; // rename does not replace there
+#else
+        ok = false;
+#endif
+    }
+    if (!ok) remove(tmp_path); // Only ever the temporary file
+    free(tmp_path);
+    return ok;
+}
+
+// Checks a header against the expected type and the actual file size.
+static bool array_file_valid(const ArrayFileHeader *header, uint64_t file_size, uint32_t type, size_t elem_size) {
+    if (memcmp(header->magic, array_file_magic, sizeof(header->magic)) != 0) return false;
+    if (header->version != ARRAY_FILE_VERSION || header->byte_order != ARRAY_FILE_BYTE_ORDER) return false;
+    if (header->type != type || header->elem_size != elem_size) return false;
+    if (header->data_offset != ARRAY_FILE_HEADER_SIZE) return false;
+    if (header->count > (file_size - ARRAY_FILE_HEADER_SIZE) / elem_size) return false;
+    return ARRAY_FILE_HEADER_SIZE + header->count * elem_size == file_size;
+}
+
+static const void* array_file_map(const char *path, uint32_t type, size_t elem_size, size_t *size) {
+    if (size == NULL) return NULL;
+    *size = 0;
+    if (path == NULL) return NULL;
+    ArrayFileHeader header;
+#ifdef AQUANT_HAVE_POSIX_IO
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < ARRAY_FILE_HEADER_SIZE || (uint64_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return NULL;
+    }
+    size_t file_size = (size_t)st.st_size;
+    void *base = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid
+    if (base == MAP_FAILED) return NULL;
+    memcpy(&header, base, sizeof(header));
+    if (!array_file_valid(&header, file_size, type, elem_size) || header.count == 0) {
+        munmap(base, file_size);
+        return NULL;
+    }
+#else
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) return NULL;
+    if (fread(&header, sizeof(header), 1, fp) != 1 || header.elem_size == 0 || header.count > (SIZE_MAX - ARRAY_FILE_HEADER_SIZE) / header.elem_size) {
+        fclose(fp);
+        return NULL;
+    }
+    size_t file_size = ARRAY_FILE_HEADER_SIZE + (size_t)header.count * header.elem_size;
+    size_t alloc_size = (file_size + ARRAY_FILE_HEADER_SIZE - 1) / ARRAY_FILE_HEADER_SIZE * ARRAY_FILE_HEADER_SIZE;
+    unsigned char *base = array_file_alloc(alloc_size); // Keeps the data 64-byte aligned
+    bool ok = base != NULL && array_file_valid(&header, file_size, type, elem_size) && header.count > 0;
+    if (ok) {
+        memcpy(base, &header, sizeof(header));
+        ok = fread(base + ARRAY_FILE_HEADER_SIZE, elem_size, (size_t)header.count, fp) == header.count && fgetc(fp) == EOF;
+    }
+    fclose(fp);
+    if (!ok) { if (base != NULL) array_file_free(base); return NULL; }
+#endif
+    *size = (size_t)header.count;
+    return (const unsigned char*)base + ARRAY_FILE_HEADER_SIZE;
+}
+
+// O(n) time: one sequential write.
+bool aq_array_save_int(const char *path, const int *arr, size_t size) {
+    return array_file_save(path, ARRAY_FILE_INT, arr, sizeof(int), size);
+}
+
+bool aq_array_save_float(const char *path, const float *arr, size_t size) {
+    return array_file_save(path, ARRAY_FILE_FLOAT, arr, sizeof(float), size);
+}
+
+bool aq_array_save_double(const char *path, const double *arr, size_t size) {
+    return array_file_save(path, ARRAY_FILE_DOUBLE, arr, sizeof(double), size);
+}
+
+// O(1) time: pages are loaded on first access. Release with aq_array_unmap.
+const int* aq_array_map_int(const char *path, size_t *size) {
+    return array_file_map(path, ARRAY_FILE_INT, sizeof(int), size);
+}
+
+const float* aq_array_map_float(const char *path, size_t *size) {
+    return array_file_map(path, ARRAY_FILE_FLOAT, sizeof(float), size);
+}
+
+const double* aq_array_map_double(const char *path, size_t *size) {
+    return array_file_map(path, ARRAY_FILE_DOUBLE, sizeof(double), size);
+}
+
+void aq_array_unmap(const void *data) {
+    if (data == NULL) return;
+    const unsigned char *base = (const unsigned char*)data - ARRAY_FILE_HEADER_SIZE;
+    ArrayFileHeader header;
+    memcpy(&header, base, sizeof(header));
+#ifdef AQUANT_HAVE_POSIX_IO
+    munmap((void*)base, (size_t)(ARRAY_FILE_HEADER_SIZE + header.count * header.elem_size));
+#else
+    array_file_free((void*)base);
+#endif
+}
+
+
+// --- Reduction Kernels (SIMD with runtime dispatch) ---
+// min/max, sum and sum of squared deviations over int, float and double
+// arrays. One implementation per instruction set; the best one the CPU
+// supports is picked once at startup (cpuid via __builtin_cpu_supports) and
+// stored in aq_kernels. All kernels require size >= 1. Integer results are
+// exact. Float/double min/max follow the scalar rules (strict compare, a NaN
+// in arr[0] propagates, later NaNs are ignored); only the sign of a zero
+// result may differ when +0 and -0 tie. Float/double sums use several partial
+// accumulators, so they can differ from a sequential left-to-right sum by
+// normal rounding (relative error on the order of size * DBL_EPSILON). Build
+// with -DAQUANT_NO_SIMD for scalar only.
+#if !defined(AQUANT_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define AQUANT_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+typedef struct ReduceKernels {
+    void (*minmax_int)(const int *arr, size_t size, int *min_val, int *max_val);
+    long long (*sum_int)(const int *arr, size_t size);
+    void (*minmax_float)(const float *arr, size_t size, float *min_val, float *max_val);
+    double (*sum_float)(const float *arr, size_t size);
+    void (*minmax_double)(const double *arr, size_t size, double *min_val, double *max_val);
+    double (*sum_double)(const double *arr, size_t size);
+    // Sum of squared deviations from `mean` (the M2 term of a variance)
+    double (*sqdev_int)(const int *arr, size_t size, double mean);
+    double (*sqdev_float)(const float *arr, size_t size, double mean);
+    double (*sqdev_double)(const double *arr, size_t size, double mean);
+} ReduceKernels;
+
+static void minmax_int_scalar(const int *arr, size_t size, int *min_val, int *max_val) {
+    int lo = arr[0], hi = arr[0];
+    for (size_t i = 1; i < size; ++i) {
+        if (arr[i] < lo) lo = arr[i];
+        if (arr[i] > hi) hi = arr[i];
+    }
+    *min_val = lo; *max_val = hi;
+}
+
+static long long sum_int_scalar(const int *arr, size_t size) {
+    long long sum = 0;
+    for (size_t i = 0; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+static void minmax_float_scalar(const float *arr, size_t size, float *min_val, float *max_val) {
+    float lo = arr[0], hi = arr[0];
+    for (size_t i = 1; i < size; ++i) {
+        if (arr[i] < lo) lo = arr[i];
+        if (arr[i] > hi) hi = arr[i];
+    }
+    *min_val = lo; *max_val = hi;
+}
+
+static double sum_float_scalar(const float *arr, size_t size) {
+    double sum = 0.0;
+    for (size_t i = 0; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+static void minmax_double_scalar(const double *arr, size_t size, double *min_val, double *max_val) {
+    double lo = arr[0], hi = arr[0];
+    for (size_t i = 1; i < size; ++i) {
+        if (arr[i] < lo) lo = arr[i];
+        if (arr[i] > hi) hi = arr[i];
+    }
+    *min_val = lo; *max_val = hi;
+}
+
+static double sum_double_scalar(const double *arr, size_t size) {
+    double sum = 0.0;
+    for (size_t i = 0; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+static double sqdev_int_scalar(const int *arr, size_t size, double mean) {
+    double m2 = 0.0;
+    for (size_t i = 0; i < size; ++i) { double d = arr[i] - mean; m2 += d * d; }
+    return m2;
+}
+
+static double sqdev_float_scalar(const float *arr, size_t size, double mean) {
+    double m2 = 0.0;
+    for (size_t i = 0; i < size; ++i) { double d = arr[i] - mean; m2 += d * d; }
+    return m2;
+}
+
+static double sqdev_double_scalar(const double *arr, size_t size, double mean) {
+    double m2 = 0.0;
+    for (size_t i = 0; i < size; ++i) { double d = arr[i] - mean; m2 += d * d; }
+    return m2;
+}
+
+#ifdef AQUANT_X86_SIMD
+// Lane results are folded with the same strict compares as the scalar loops,
+// then the tail is finished by the scalar rule. Every lane starts at arr[0].
+static void fold_minmax_int(const int *lanes_lo, const int *lanes_hi, size_t lanes,
+                            const int *tail, size_t tail_size, int *min_val, int *max_val) {
+    int lo = lanes_lo[0], hi = lanes_hi[0];
+    for (size_t i = 1; i < lanes; ++i) { if (lanes_lo[i] < lo) lo = lanes_lo[i]; if (lanes_hi[i] > hi) hi = lanes_hi[i]; }
+    for (size_t i = 0; i < tail_size; ++i) { if (tail[i] < lo) lo = tail[i]; if (tail[i] > hi) hi = tail[i]; }
+    *min_val = lo; *max_val = hi;
+}
+
+static void fold_minmax_float(const float *lanes_lo, const float *lanes_hi, size_t lanes,
+                              const float *tail, size_t tail_size, float *min_val, float *max_val) {
+    float lo = lanes_lo[0], hi = lanes_hi[0];
+    for (size_t i = 1; i < lanes; ++i) { if (lanes_lo[i] < lo) lo = lanes_lo[i]; if (lanes_hi[i] > hi) hi = lanes_hi[i]; }
+    for (size_t i = 0; i < tail_size; ++i) { if (tail[i] < lo) lo = tail[i]; if (tail[i] > hi) hi = tail[i]; }
+    *min_val = lo; *max_val = hi;
+}
+
+static void fold_minmax_double(const double *lanes_lo, const double *lanes_hi, size_t lanes,
+                               const double *tail, size_t tail_size, double *min_val, double *max_val) {
+    double lo = lanes_lo[0], hi = lanes_hi[0];
+    for (size_t i = 1; i < lanes; ++i) { if (lanes_lo[i] < lo) lo = lanes_lo[i]; if (lanes_hi[i] > hi) hi = lanes_hi[i]; }
+    for (size_t i = 0; i < tail_size; ++i) { if (tail[i] < lo) lo = tail[i]; if (tail[i] > hi) hi = tail[i]; }
+    *min_val = lo; *max_val = hi;
+}
+
+// SSE2 has no 32-bit min/max or sign-extending widen; both are built from compares.
+__attribute__((target("sse2")))
+static void minmax_int_sse2(const int *arr, size_t size, int *min_val, int *max_val) {
+    __m128i vlo = _mm_set1_epi32(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(arr + i));
+        __m128i lt = _mm_cmplt_epi32(x, vlo), gt = _mm_cmpgt_epi32(x, vhi);
+        vlo = _mm_or_si128(_mm_and_si128(lt, x), _mm_andnot_si128(lt, vlo));
+        vhi = _mm_or_si128(_mm_and_si128(gt, x), _mm_andnot_si128(gt, vhi));
+    }
+    int lo[4], hi[4];
+    _mm_storeu_si128((__m128i*)lo, vlo); _mm_storeu_si128((__m128i*)hi, vhi);
+    fold_minmax_int(lo, hi, 4, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("sse2")))
+static long long sum_int_sse2(const int *arr, size_t size) {
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(arr + i));
+        __m128i sign = _mm_srai_epi32(x, 31);
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(x, sign));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(x, sign));
+    }
+    long long lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, _mm_add_epi64(acc0, acc1));
+    long long sum = lanes[0] + lanes[1];
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("sse2")))
+static void minmax_float_sse2(const float *arr, size_t size, float *min_val, float *max_val) {
+    __m128 vlo = _mm_set1_ps(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 x = _mm_loadu_ps(arr + i);
+        vlo = _mm_min_ps(x, vlo); // x < lo ? x : lo
+        vhi = _mm_max_ps(x, vhi); // x > hi ? x : hi
+    }
+    float lo[4], hi[4];
+    _mm_storeu_ps(lo, vlo); _mm_storeu_ps(hi, vhi);
+    fold_minmax_float(lo, hi, 4, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("sse2")))
+static double sum_float_sse2(const float *arr, size_t size) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 x = _mm_loadu_ps(arr + i);
+        acc0 = _mm_add_pd(acc0, _mm_cvtps_pd(x));
+        acc1 = _mm_add_pd(acc1, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    double sum = lanes[0] + lanes[1];
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("sse2")))
+static void minmax_double_sse2(const double *arr, size_t size, double *min_val, double *max_val) {
+    __m128d vlo = _mm_set1_pd(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128d x = _mm_loadu_pd(arr + i);
+        vlo = _mm_min_pd(x, vlo);
+        vhi = _mm_max_pd(x, vhi);
+    }
+    double lo[2], hi[2];
+    _mm_storeu_pd(lo, vlo); _mm_storeu_pd(hi, vhi);
+    fold_minmax_double(lo, hi, 2, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("sse2")))
+static double sum_double_sse2(const double *arr, size_t size) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(arr + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(arr + i + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    double sum = lanes[0] + lanes[1];
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("sse2")))
+static double sqdev_int_sse2(const int *arr, size_t size, double mean) {
+    __m128d vmean = _mm_set1_pd(mean), acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(arr + i));
+        __m128d d0 = _mm_sub_pd(_mm_cvtepi32_pd(x), vmean);
+        __m128d d1 = _mm_sub_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(x, x)), vmean);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(d0, d0));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(d1, d1));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + sqdev_int_scalar(arr + i, size - i, mean);
+}
+
+__attribute__((target("sse2")))
+static double sqdev_float_sse2(const float *arr, size_t size, double mean) {
+    __m128d vmean = _mm_set1_pd(mean), acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 x = _mm_loadu_ps(arr + i);
+        __m128d d0 = _mm_sub_pd(_mm_cvtps_pd(x), vmean);
+        __m128d d1 = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), vmean);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(d0, d0));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(d1, d1));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + sqdev_float_scalar(arr + i, size - i, mean);
+}
+
+__attribute__((target("sse2")))
+static double sqdev_double_sse2(const double *arr, size_t size, double mean) {
+    __m128d vmean = _mm_set1_pd(mean), acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128d d0 = _mm_sub_pd(_mm_loadu_pd(arr + i), vmean);
+        __m128d d1 = _mm_sub_pd(_mm_loadu_pd(arr + i + 2), vmean);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(d0, d0));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(d1, d1));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + sqdev_double_scalar(arr + i, size - i, mean);
+}
+
+__attribute__((target("avx2")))
+static void minmax_int_avx2(const int *arr, size_t size, int *min_val, int *max_val) {
+    __m256i vlo = _mm256_set1_epi32(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(arr + i));
+        vlo = _mm256_min_epi32(vlo, x);
+        vhi = _mm256_max_epi32(vhi, x);
+    }
+    int lo[8], hi[8];
+    _mm256_storeu_si256((__m256i*)lo, vlo); _mm256_storeu_si256((__m256i*)hi, vhi);
+    fold_minmax_int(lo, hi, 8, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("avx2")))
+static long long sum_int_avx2(const int *arr, size_t size) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(arr + i))));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(arr + i + 4))));
+    }
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(acc0, acc1));
+    long long sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static void minmax_float_avx2(const float *arr, size_t size, float *min_val, float *max_val) {
+    __m256 vlo = _mm256_set1_ps(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256 x = _mm256_loadu_ps(arr + i);
+        vlo = _mm256_min_ps(x, vlo);
+        vhi = _mm256_max_ps(x, vhi);
+    }
+    float lo[8], hi[8];
+    _mm256_storeu_ps(lo, vlo); _mm256_storeu_ps(hi, vhi);
+    fold_minmax_float(lo, hi, 8, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("avx2")))
+static double sum_float_avx2(const float *arr, size_t size) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm_loadu_ps(arr + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm_loadu_ps(arr + i + 4)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static void minmax_double_avx2(const double *arr, size_t size, double *min_val, double *max_val) {
+    __m256d vlo = _mm256_set1_pd(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256d x = _mm256_loadu_pd(arr + i);
+        vlo = _mm256_min_pd(x, vlo);
+        vhi = _mm256_max_pd(x, vhi);
+    }
+    double lo[4], hi[4];
+    _mm256_storeu_pd(lo, vlo); _mm256_storeu_pd(hi, vhi);
+    fold_minmax_double(lo, hi, 4, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("avx2")))
+static double sum_double_avx2(const double *arr, size_t size) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(arr + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(arr + i + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static double sqdev_int_avx2(const int *arr, size_t size, double mean) {
+    __m256d vmean = _mm256_set1_pd(mean), acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256d d0 = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(arr + i))), vmean);
+        __m256d d1 = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(arr + i + 4))), vmean);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sqdev_int_scalar(arr + i, size - i, mean);
+}
+
+__attribute__((target("avx2")))
+static double sqdev_float_avx2(const float *arr, size_t size, double mean) {
+    __m256d vmean = _mm256_set1_pd(mean), acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256d d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(arr + i)), vmean);
+        __m256d d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(arr + i + 4)), vmean);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sqdev_float_scalar(arr + i, size - i, mean);
+}
+
+__attribute__((target("avx2")))
+static double sqdev_double_avx2(const double *arr, size_t size, double mean) {
+    __m256d vmean = _mm256_set1_pd(mean), acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(arr + i), vmean);
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(arr + i + 4), vmean);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sqdev_double_scalar(arr + i, size - i, mean);
+}
+
+__attribute__((target("avx512f")))
+static void minmax_int_avx512(const int *arr, size_t size, int *min_val, int *max_val) {
+    __m512i vlo = _mm512_set1_epi32(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m512i x = _mm512_loadu_si512((const void*)(arr + i));
+        vlo = _mm512_min_epi32(vlo, x);
+        vhi = _mm512_max_epi32(vhi, x);
+    }
+    int lo[16], hi[16];
+    _mm512_storeu_si512((void*)lo, vlo); _mm512_storeu_si512((void*)hi, vhi);
+    fold_minmax_int(lo, hi, 16, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("avx512f")))
+static long long sum_int_avx512(const int *arr, size_t size) {
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        acc0 = _mm512_add_epi64(acc0, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(arr + i))));
+        acc1 = _mm512_add_epi64(acc1, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(arr + i + 8))));
+    }
+    long long lanes[8];
+    _mm512_storeu_si512((void*)lanes, _mm512_add_epi64(acc0, acc1));
+    long long sum = 0;
+    for (size_t k = 0; k < 8; ++k) sum += lanes[k];
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static void minmax_float_avx512(const float *arr, size_t size, float *min_val, float *max_val) {
+    __m512 vlo = _mm512_set1_ps(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m512 x = _mm512_loadu_ps(arr + i);
+        vlo = _mm512_min_ps(x, vlo);
+        vhi = _mm512_max_ps(x, vhi);
+    }
+    float lo[16], hi[16];
+    _mm512_storeu_ps(lo, vlo); _mm512_storeu_ps(hi, vhi);
+    fold_minmax_float(lo, hi, 16, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("avx512f")))
+static double sum_float_avx512(const float *arr, size_t size) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        acc0 = _mm512_add_pd(acc0, _mm512_cvtps_pd(_mm256_loadu_ps(arr + i)));
+        acc1 = _mm512_add_pd(acc1, _mm512_cvtps_pd(_mm256_loadu_ps(arr + i + 8)));
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    double sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static void minmax_double_avx512(const double *arr, size_t size, double *min_val, double *max_val) {
+    __m512d vlo = _mm512_set1_pd(arr[0]), vhi = vlo;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m512d x = _mm512_loadu_pd(arr + i);
+        vlo = _mm512_min_pd(x, vlo);
+        vhi = _mm512_max_pd(x, vhi);
+    }
+    double lo[8], hi[8];
+    _mm512_storeu_pd(lo, vlo); _mm512_storeu_pd(hi, vhi);
+    fold_minmax_double(lo, hi, 8, arr + i, size - i, min_val, max_val);
+}
+
+__attribute__((target("avx512f")))
+static double sum_double_avx512(const double *arr, size_t size) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        acc0 = _mm512_add_pd(acc0, _mm512_loadu_pd(arr + i));
+        acc1 = _mm512_add_pd(acc1, _mm512_loadu_pd(arr + i + 8));
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    double sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    for (; i < size; ++i) sum += arr[i];
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static double sqdev_int_avx512(const int *arr, size_t size, double mean) {
+    __m512d vmean = _mm512_set1_pd(mean), acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m512d d0 = _mm512_sub_pd(_mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(arr + i))), vmean);
+        __m512d d1 = _mm512_sub_pd(_mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(arr + i + 8))), vmean);
+        acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(d0, d0));
+        acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(d1, d1));
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    double m2 = 0.0;
+    for (size_t k = 0; k < 8; ++k) m2 += lanes[k];
+    return m2 + sqdev_int_scalar(arr + i, size - i, mean);
+}
+
+__attribute__((target("avx512f")))
+static double sqdev_float_avx512(const float *arr, size_t size, double mean) {
+    __m512d vmean = _mm512_set1_pd(mean), acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m512d d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(arr + i)), vmean);
+        __m512d d1 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(arr + i + 8)), vmean);
+        acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(d0, d0));
+        acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(d1, d1));
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    double m2 = 0.0;
+    for (size_t k = 0; k < 8; ++k) m2 += lanes[k];
+    return m2 + sqdev_float_scalar(arr + i, size - i, mean);
+}
+
+__attribute__((target("avx512f")))
+static double sqdev_double_avx512(const double *arr, size_t size, double mean) {
+    __m512d vmean = _mm512_set1_pd(mean), acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(arr + i), vmean);
+        __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(arr + i + 8), vmean);
+        acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(d0, d0));
+        acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(d1, d1));
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    double m2 = 0.0;
+    for (size_t k = 0; k < 8; ++k) m2 += lanes[k];
+    return m2 + sqdev_double_scalar(arr + i, size - i, mean);
+}
+#endif // AQUANT_X86_SIMD
+
+static ReduceKernels aq_kernels = {
+    minmax_int_scalar, sum_int_scalar,
+    minmax_float_scalar, sum_float_scalar,
+    minmax_double_scalar, sum_double_scalar,
+    sqdev_int_scalar, sqdev_float_scalar, sqdev_double_scalar
+};
+
+#ifdef AQUANT_X86_SIMD
+// Runs before main(), so the table is fixed before any caller thread starts.
+__attribute__((constructor))
+static void aq_select_kernels(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        ReduceKernels k = { minmax_int_avx512, sum_int_avx512, minmax_float_avx512, sum_float_avx512,
+                             minmax_double_avx512, sum_double_avx512, sqdev_int_avx512, sqdev_float_avx512, sqdev_double_avx512 };
+        aq_kernels = k;
+    } else if (__builtin_cpu_supports("avx2")) {
+        ReduceKernels k = { minmax_int_avx2, sum_int_avx2, minmax_float_avx2, sum_float_avx2,
+                             minmax_double_avx2, sum_double_avx2, sqdev_int_avx2, sqdev_float_avx2, sqdev_double_avx2 };
+        aq_kernels = k;
+    } else if (__builtin_cpu_supports("sse2")) {
+        ReduceKernels k = { minmax_int_sse2, sum_int_sse2, minmax_float_sse2, sum_float_sse2,
+                             minmax_double_sse2, sum_double_sse2, sqdev_int_sse2, sqdev_float_sse2, sqdev_double_sse2 };
+        aq_kernels = k;
+    }
+}
+#endif
+
+
+// --- Search Kernels (SIMD with runtime dispatch) ---
+// Equality search behind array_contains_*, array_index_of_* and
+// array_count_occurrence*. find_* returns the index of the first match or
+// size; count_* returns the number of matches. Vector versions compare a
+// block of 4 vectors per step and only look at single elements once a block
+// matches. The float/double epsilon test keeps the scalar form
+// |arr[i] - value| < EPSILON (subtract, clear the sign bit, ordered compare),
+// so results, NaN handling included, are identical to the scalar loops.
+// Selected together with the reduction kernels (same -DAQUANT_NO_SIMD switch).
+#define SEARCH_COUNT_BLOCK ((size_t)1 << 24) // Elements per 32-bit lane counter flush
+
+typedef struct SearchKernels {
+    size_t (*find_int)(const int *arr, size_t size, int value);
+    size_t (*count_int)(const int *arr, size_t size, int value);
+    size_t (*find_float)(const float *arr, size_t size, float value);
+    size_t (*count_float)(const float *arr, size_t size, float value);
+    size_t (*find_double)(const double *arr, size_t size, double value);
+    size_t (*count_double)(const double *arr, size_t size, double value);
+} SearchKernels;
+
+static size_t find_int_scalar(const int *arr, size_t size, int value) {
+    for (size_t i = 0; i < size; ++i) if (arr[i] == value) return i;
+    return size;
+}
+
+static size_t count_int_scalar(const int *arr, size_t size, int value) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i) count += arr[i] == value;
+    return count;
+}
+
+static size_t find_float_scalar(const float *arr, size_t size, float value) {
+    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < FLOAT_EPSILON) return i;
+    return size;
+}
+
+static size_t count_float_scalar(const float *arr, size_t size, float value) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < FLOAT_EPSILON) count++;
+    return count;
+}
+
+static size_t find_double_scalar(const double *arr, size_t size, double value) {
+    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < DOUBLE_EPSILON) return i;
+    return size;
+}
+
+static size_t count_double_scalar(const double *arr, size_t size, double value) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < DOUBLE_EPSILON) count++;
+    return count;
+}
+
+#ifdef AQUANT_X86_SIMD
+__attribute__((target("sse2")))
+static size_t find_int_sse2(const int *arr, size_t size, int value) {
+    __m128i v = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i m0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(arr + i)), v);
+        __m128i m1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(arr + i + 4)), v);
+        __m128i m2 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(arr + i + 8)), v);
+        __m128i m3 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(arr + i + 12)), v);
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3))))
+            return i + find_int_scalar(arr + i, 16, value);
+    }
+    return i + find_int_scalar(arr + i, size - i, value);
+}
+
+// Matches are -1 per lane, so subtracting the mask counts them.
+__attribute__((target("sse2")))
+static size_t count_int_sse2(const int *arr, size_t size, int value) {
+    __m128i v = _mm_set1_epi32(value);
+    size_t count = 0, i = 0;
+    while (i + 4 <= size) {
+        size_t end = (size - i > SEARCH_COUNT_BLOCK) ? i + SEARCH_COUNT_BLOCK : size;
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 4 <= end; i += 4)
+            acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(arr + i)), v));
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        count += (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return count + count_int_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("sse2")))
+static size_t find_float_sse2(const float *arr, size_t size, float value) {
+    __m128 v = _mm_set1_ps(value), eps = _mm_set1_ps(FLOAT_EPSILON), sign = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128 m0 = _mm_cmplt_ps(_mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(arr + i), v)), eps);
+        __m128 m1 = _mm_cmplt_ps(_mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(arr + i + 4), v)), eps);
+        __m128 m2 = _mm_cmplt_ps(_mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(arr + i + 8), v)), eps);
+        __m128 m3 = _mm_cmplt_ps(_mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(arr + i + 12), v)), eps);
+        if (_mm_movemask_ps(_mm_or_ps(_mm_or_ps(m0, m1), _mm_or_ps(m2, m3))))
+            return i + find_float_scalar(arr + i, 16, value);
+    }
+    return i + find_float_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("sse2")))
+static size_t count_float_sse2(const float *arr, size_t size, float value) {
+    __m128 v = _mm_set1_ps(value), eps = _mm_set1_ps(FLOAT_EPSILON), sign = _mm_set1_ps(-0.0f);
+    size_t count = 0, i = 0;
+    while (i + 4 <= size) {
+        size_t end = (size - i > SEARCH_COUNT_BLOCK) ? i + SEARCH_COUNT_BLOCK : size;
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 4 <= end; i += 4) {
+            __m128 m = _mm_cmplt_ps(_mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(arr + i), v)), eps);
+            acc = _mm_sub_epi32(acc, _mm_castps_si128(m));
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        count += (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return count + count_float_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("sse2")))
+static size_t find_double_sse2(const double *arr, size_t size, double value) {
+    __m128d v = _mm_set1_pd(value), eps = _mm_set1_pd(DOUBLE_EPSILON), sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m128d m0 = _mm_cmplt_pd(_mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(arr + i), v)), eps);
+        __m128d m1 = _mm_cmplt_pd(_mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(arr + i + 2), v)), eps);
+        __m128d m2 = _mm_cmplt_pd(_mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(arr + i + 4), v)), eps);
+        __m128d m3 = _mm_cmplt_pd(_mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(arr + i + 6), v)), eps);
+        if (_mm_movemask_pd(_mm_or_pd(_mm_or_pd(m0, m1), _mm_or_pd(m2, m3))))
+            return i + find_double_scalar(arr + i, 8, value);
+    }
+    return i + find_double_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("sse2")))
+static size_t count_double_sse2(const double *arr, size_t size, double value) {
+    __m128d v = _mm_set1_pd(value), eps = _mm_set1_pd(DOUBLE_EPSILON), sign = _mm_set1_pd(-0.0);
+    __m128i acc = _mm_setzero_si128(); // 64-bit lanes cannot overflow
+    size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128d m = _mm_cmplt_pd(_mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(arr + i), v)), eps);
+        acc = _mm_sub_epi64(acc, _mm_castpd_si128(m));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return (size_t)(lanes[0] + lanes[1]) + count_double_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t find_int_avx2(const int *arr, size_t size, int value) {
+    __m256i v = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i m0 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(arr + i)), v);
+        __m256i m1 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(arr + i + 8)), v);
+        __m256i m2 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(arr + i + 16)), v);
+        __m256i m3 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(arr + i + 24)), v);
+        if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(m0, m1), _mm256_or_si256(m2, m3))))
+            return i + find_int_scalar(arr + i, 32, value);
+    }
+    return i + find_int_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t count_int_avx2(const int *arr, size_t size, int value) {
+    __m256i v = _mm256_set1_epi32(value);
+    size_t count = 0, i = 0;
+    while (i + 16 <= size) {
+        size_t end = (size - i > SEARCH_COUNT_BLOCK) ? i + SEARCH_COUNT_BLOCK : size;
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        for (; i + 16 <= end; i += 16) {
+            acc0 = _mm256_sub_epi32(acc0, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(arr + i)), v));
+            acc1 = _mm256_sub_epi32(acc1, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(arr + i + 8)), v));
+        }
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi32(acc0, acc1));
+        for (size_t k = 0; k < 8; ++k) count += lanes[k];
+    }
+    return count + count_int_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t find_float_avx2(const float *arr, size_t size, float value) {
+    __m256 v = _mm256_set1_ps(value), eps = _mm256_set1_ps(FLOAT_EPSILON), sign = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256 m0 = _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(arr + i), v)), eps, _CMP_LT_OQ);
+        __m256 m1 = _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(arr + i + 8), v)), eps, _CMP_LT_OQ);
+        __m256 m2 = _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(arr + i + 16), v)), eps, _CMP_LT_OQ);
+        __m256 m3 = _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(arr + i + 24), v)), eps, _CMP_LT_OQ);
+        if (_mm256_movemask_ps(_mm256_or_ps(_mm256_or_ps(m0, m1), _mm256_or_ps(m2, m3))))
+            return i + find_float_scalar(arr + i, 32, value);
+    }
+    return i + find_float_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t count_float_avx2(const float *arr, size_t size, float value) {
+    __m256 v = _mm256_set1_ps(value), eps = _mm256_set1_ps(FLOAT_EPSILON), sign = _mm256_set1_ps(-0.0f);
+    size_t count = 0, i = 0;
+    while (i + 8 <= size) {
+        size_t end = (size - i > SEARCH_COUNT_BLOCK) ? i + SEARCH_COUNT_BLOCK : size;
+        __m256i acc = _mm256_setzero_si256();
+        for (; i + 8 <= end; i += 8) {
+            __m256 m = _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(arr + i), v)), eps, _CMP_LT_OQ);
+            acc = _mm256_sub_epi32(acc, _mm256_castps_si256(m));
+        }
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, acc);
+        for (size_t k = 0; k < 8; ++k) count += lanes[k];
+    }
+    return count + count_float_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t find_double_avx2(const double *arr, size_t size, double value) {
+    __m256d v = _mm256_set1_pd(value), eps = _mm256_set1_pd(DOUBLE_EPSILON), sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m256d m0 = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(arr + i), v)), eps, _CMP_LT_OQ);
+        __m256d m1 = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(arr + i + 4), v)), eps, _CMP_LT_OQ);
+        __m256d m2 = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(arr + i + 8), v)), eps, _CMP_LT_OQ);
+        __m256d m3 = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(arr + i + 12), v)), eps, _CMP_LT_OQ);
+        if (_mm256_movemask_pd(_mm256_or_pd(_mm256_or_pd(m0, m1), _mm256_or_pd(m2, m3))))
+            return i + find_double_scalar(arr + i, 16, value);
+    }
+    return i + find_double_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t count_double_avx2(const double *arr, size_t size, double value) {
+    __m256d v = _mm256_set1_pd(value), eps = _mm256_set1_pd(DOUBLE_EPSILON), sign = _mm256_set1_pd(-0.0);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256d m = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(arr + i), v)), eps, _CMP_LT_OQ);
+        acc = _mm256_sub_epi64(acc, _mm256_castpd_si256(m));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + count_double_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t find_int_avx512(const int *arr, size_t size, int value) {
+    __m512i v = _mm512_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __mmask16 m = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*)(arr + i)), v)
+                    | _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*)(arr + i + 16)), v)
+                    | _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*)(arr + i + 32)), v)
+                    | _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*)(arr + i + 48)), v);
+        if (m) return i + find_int_scalar(arr + i, 64, value);
+    }
+    return i + find_int_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t count_int_avx512(const int *arr, size_t size, int value) {
+    __m512i v = _mm512_set1_epi32(value), one = _mm512_set1_epi32(1);
+    size_t count = 0, i = 0;
+    while (i + 16 <= size) {
+        size_t end = (size - i > SEARCH_COUNT_BLOCK) ? i + SEARCH_COUNT_BLOCK : size;
+        __m512i acc = _mm512_setzero_si512();
+        for (; i + 16 <= end; i += 16) {
+            __mmask16 m = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*)(arr + i)), v);
+            acc = _mm512_mask_add_epi32(acc, m, acc, one);
+        }
+        count += (uint32_t)_mm512_reduce_add_epi32(acc);
+    }
+    return count + count_int_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t find_float_avx512(const float *arr, size_t size, float value) {
+    __m512 v = _mm512_set1_ps(value), eps = _mm512_set1_ps(FLOAT_EPSILON);
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __mmask16 m = _mm512_cmp_ps_mask(_mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(arr + i), v)), eps, _CMP_LT_OQ)
+                    | _mm512_cmp_ps_mask(_mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(arr + i + 16), v)), eps, _CMP_LT_OQ)
+                    | _mm512_cmp_ps_mask(_mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(arr + i + 32), v)), eps, _CMP_LT_OQ)
+                    | _mm512_cmp_ps_mask(_mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(arr + i + 48), v)), eps, _CMP_LT_OQ);
+        if (m) return i + find_float_scalar(arr + i, 64, value);
+    }
+    return i + find_float_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t count_float_avx512(const float *arr, size_t size, float value) {
+    __m512 v = _mm512_set1_ps(value), eps = _mm512_set1_ps(FLOAT_EPSILON);
+    __m512i one = _mm512_set1_epi32(1);
+    size_t count = 0, i = 0;
+    while (i + 16 <= size) {
+        size_t end = (size - i > SEARCH_COUNT_BLOCK) ? i + SEARCH_COUNT_BLOCK : size;
+        __m512i acc = _mm512_setzero_si512();
+        for (; i + 16 <= end; i += 16) {
+            __mmask16 m = _mm512_cmp_ps_mask(_mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(arr + i), v)), eps, _CMP_LT_OQ);
+            acc = _mm512_mask_add_epi32(acc, m, acc, one);
+        }
+        count += (uint32_t)_mm512_reduce_add_epi32(acc);
+    }
+    return count + count_float_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t find_double_avx512(const double *arr, size_t size, double value) {
+    __m512d v = _mm512_set1_pd(value), eps = _mm512_set1_pd(DOUBLE_EPSILON);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __mmask8 m = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(arr + i), v)), eps, _CMP_LT_OQ)
+                   | _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(arr + i + 8), v)), eps, _CMP_LT_OQ)
+                   | _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(arr + i + 16), v)), eps, _CMP_LT_OQ)
+                   | _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(arr + i + 24), v)), eps, _CMP_LT_OQ);
+        if (m) return i + find_double_scalar(arr + i, 32, value);
+    }
+    return i + find_double_scalar(arr + i, size - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t count_double_avx512(const double *arr, size_t size, double value) {
+    __m512d v = _mm512_set1_pd(value), eps = _mm512_set1_pd(DOUBLE_EPSILON);
+    __m512i acc = _mm512_setzero_si512(), one = _mm512_set1_epi64(1);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __mmask8 m = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(arr + i), v)), eps, _CMP_LT_OQ);
+        acc = _mm512_mask_add_epi64(acc, m, acc, one);
+    }
+    return (size_t)_mm512_reduce_add_epi64(acc) + count_double_scalar(arr + i, size - i, value);
+}
+#endif // AQUANT_X86_SIMD
+
+static SearchKernels aq_search = {
+    find_int_scalar, count_int_scalar,
+    find_float_scalar, count_float_scalar,
+    find_double_scalar, count_double_scalar
+};
+
+#ifdef AQUANT_X86_SIMD
+__attribute__((constructor))
+static void aq_select_search_kernels(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        SearchKernels k = { find_int_avx512, count_int_avx512, find_float_avx512, count_float_avx512,
+                            find_double_avx512, count_double_avx512 };
+        aq_search = k;
+    } else if (__builtin_cpu_supports("avx2")) {
+        SearchKernels k = { find_int_avx2, count_int_avx2, find_float_avx2, count_float_avx2,
+                            find_double_avx2, count_double_avx2 };
+        aq_search = k;
+    } else if (__builtin_cpu_supports("sse2")) {
+        SearchKernels k = { find_int_sse2, count_int_sse2, find_float_sse2, count_float_sse2,
+                            find_double_sse2, count_double_sse2 };
+        aq_search = k;
+    }
+}
+#endif
+
+
+// --- String Kernels (SIMD with runtime dispatch) ---
+// Byte scans behind the string functions, selected with the other kernels
+// (same -DAQUANT_NO_SIMD switch). set_mask turns 64 bytes into a bitmask of
+// positions holding any byte of a set (SSE2/AVX2 compares against each set
+// byte for sets of up to AQ_SET_SIMD_MAX bytes, a 256-bit membership table
+// otherwise). find is a first/last-byte filter substring search: a vector
+// compare of the needle's first byte at i and last byte at i + len - 1 picks
+// candidates, and only those are compared in full. convert_case and
+// class_span handle ASCII 16/32 bytes at a time with range compares; a block
+// holding any byte >= 0x80 goes through the scalar code, which leaves those
+// bytes to the locale-aware ctype functions exactly as before.
+#define AQ_SET_SIMD_MAX 16
+#define SET_MASK_WINDOW 64
+
+typedef struct StringKernels {
+    // Bit i set when p[i] is in the set, for i < n (n <= SET_MASK_WINDOW)
+    uint64_t (*set_mask)(const char *p, size_t n, const char *set, size_t set_len, const unsigned char *bits);
+    // First occurrence of needle (needle_len >= 2) in hay[0..hay_len), or NULL
+    const char* (*find)(const char *hay, size_t hay_len, const char *needle, size_t needle_len);
+    // dst[i] = tolower/toupper(src[i]) for i < n; dst may equal src
+    void (*convert_case)(char *dst, const char *src, size_t n, bool upper);
+    // Length of the leading run of ASCII bytes in any of the ASCII_* classes
+    size_t (*class_span)(const char *p, size_t n, unsigned classes);
+} StringKernels;
+
+enum { ASCII_ALPHA = 1, ASCII_DIGIT = 2, ASCII_SPACE = 4, ASCII_HIGH = 8 };
+
+// isalpha/isdigit/isspace for ASCII bytes, which agree in every locale.
+// Bytes >= 0x80 are ASCII_HIGH: only the locale's ctype functions can classify them.
+static const unsigned char ascii_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 4, 4, 4, 4, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+};
+
+static inline bool byte_in_set(const unsigned char *bits, unsigned char c) {
+    return (bits[c >> 3] >> (c & 7)) & 1;
+}
+
+static inline int trailing_zeros_64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    while (!(x & 1)) { x >>= 1; n++; }
+    return n;
+#endif
+}
+
+static uint64_t set_mask_scalar(const char *p, size_t n, const char *set, size_t set_len, const unsigned char *bits) {
+    (void)set; (void)set_len;
+    uint64_t mask = 0;
+    for (size_t i = 0; i < n; ++i) mask |= (uint64_t)byte_in_set(bits, (unsigned char)p[i]) << i;
+    return mask;
+}
+
+static void convert_case_scalar(char *dst, const char *src, size_t n, bool upper) {
+    unsigned char from = upper ? 'a' : 'A';
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)src[i];
+        if (c < 0x80) dst[i] = (char)(c ^ (((unsigned char)(c - from) < 26) << 5));
+        else dst[i] = (char)(upper ? toupper(c) : tolower(c));
+    }
+}
+
+static size_t class_span_scalar(const char *p, size_t n, unsigned classes) {
+    size_t i = 0;
+    while (i < n && (ascii_class[(unsigned char)p[i]] & classes)) i++;
+    return i;
+}
+
+static const char* find_scalar(const char *hay, size_t hay_len, const char *needle, size_t needle_len) {
+    const char *p = hay, *end = hay + hay_len;
+    while ((size_t)(end - p) >= needle_len) {
+        const char *hit = memchr(p, (unsigned char)needle[0], (size_t)(end - p) - needle_len + 1);
+        if (hit == NULL) return NULL;
+        if (memcmp(hit + 1, needle + 1, needle_len - 1) == 0) return hit;
+        p = hit + 1;
+    }
+    return NULL;
+}
+
+#ifdef AQUANT_X86_SIMD
+__attribute__((target("sse2")))
+static uint64_t set_mask_sse2(const char *p, size_t n, const char *set, size_t set_len, const unsigned char *bits) {
+    if (n < SET_MASK_WINDOW || set_len > AQ_SET_SIMD_MAX) return set_mask_scalar(p, n, set, set_len, bits);
+    __m128i x0 = _mm_loadu_si128((const __m128i*)p), x1 = _mm_loadu_si128((const __m128i*)(p + 16));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(p + 32)), x3 = _mm_loadu_si128((const __m128i*)(p + 48));
+    __m128i h0 = _mm_setzero_si128(), h1 = h0, h2 = h0, h3 = h0;
+    for (size_t k = 0; k < set_len; ++k) {
+        __m128i c = _mm_set1_epi8(set[k]);
+        h0 = _mm_or_si128(h0, _mm_cmpeq_epi8(x0, c)); h1 = _mm_or_si128(h1, _mm_cmpeq_epi8(x1, c));
+        h2 = _mm_or_si128(h2, _mm_cmpeq_epi8(x2, c)); h3 = _mm_or_si128(h3, _mm_cmpeq_epi8(x3, c));
+    }
+    return (uint64_t)(uint16_t)_mm_movemask_epi8(h0) | ((uint64_t)(uint16_t)_mm_movemask_epi8(h1) << 16)
+         | ((uint64_t)(uint16_t)_mm_movemask_epi8(h2) << 32) | ((uint64_t)(uint16_t)_mm_movemask_epi8(h3) << 48);
+}
+
+__attribute__((target("avx2")))
+static uint64_t set_mask_avx2(const char *p, size_t n, const char *set, size_t set_len, const unsigned char *bits) {
+    if (n < SET_MASK_WINDOW || set_len > AQ_SET_SIMD_MAX) return set_mask_scalar(p, n, set, set_len, bits);
+    __m256i x0 = _mm256_loadu_si256((const __m256i*)p), x1 = _mm256_loadu_si256((const __m256i*)(p + 32));
+    __m256i h0 = _mm256_setzero_si256(), h1 = h0;
+    for (size_t k = 0; k < set_len; ++k) {
+        __m256i c = _mm256_set1_epi8(set[k]);
+        h0 = _mm256_or_si256(h0, _mm256_cmpeq_epi8(x0, c)); h1 = _mm256_or_si256(h1, _mm256_cmpeq_epi8(x1, c));
+    }
+    return (uint64_t)(uint32_t)_mm256_movemask_epi8(h0) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(h1) << 32);
+}
+
+// Verifies a candidate inline: a memcmp call would force the broadcast needle
+// vectors out of registers for the whole scan loop.
+static inline bool tail_equal(const char *a, const char *b, size_t n) {
+    for (size_t k = 0; k < n; ++k) if (a[k] != b[k]) return false;
+    return true;
+}
+
+// Candidates are positions where both the first and the last needle byte
+// match; only those are verified. The AVX2 loop takes 64 bytes per step and
+// tests both halves with one vptest before extracting masks. The final block is loaded flush
+// with the end of the haystack and masks off positions already examined, so
+// short haystacks need no scalar tail.
+__attribute__((target("sse2")))
+static const char* find_sse2(const char *hay, size_t hay_len, const char *needle, size_t needle_len) {
+    if (hay_len < needle_len - 1 + 16) return find_scalar(hay, hay_len, needle, needle_len);
+    __m128i first = _mm_set1_epi8(needle[0]), last = _mm_set1_epi8(needle[needle_len - 1]);
+    size_t last_start = hay_len - (needle_len - 1) - 16;
+    for (size_t i = 0;; i += 16) {
+        unsigned skip = 0;
+        if (i > last_start) { skip = (unsigned)(i - last_start); i = last_start; }
+        __m128i head = _mm_loadu_si128((const __m128i*)(hay + i));
+        __m128i tail = _mm_loadu_si128((const __m128i*)(hay + i + needle_len - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))) & (0xFFFFu << skip);
+        while (mask) {
+            size_t at = i + (size_t)__builtin_ctz(mask);
+            if (tail_equal(hay + at + 1, needle + 1, needle_len - 2)) return hay + at;
+            mask &= mask - 1;
+        }
+        if (i == last_start) return NULL;
+    }
+}
+
+__attribute__((target("avx2")))
+static const char* find_avx2(const char *hay, size_t hay_len, const char *needle, size_t needle_len) {
+    if (hay_len < needle_len - 1 + 32) return find_sse2(hay, hay_len, needle, needle_len);
+    __m256i first = _mm256_set1_epi8(needle[0]), last = _mm256_set1_epi8(needle[needle_len - 1]);
+    size_t last_start = hay_len - (needle_len - 1) - 32, i = 0;
+    for (; i + 32 <= last_start; i += 64) {
+        __m256i h0 = _mm256_loadu_si256((const __m256i*)(hay + i)), h1 = _mm256_loadu_si256((const __m256i*)(hay + i + 32));
+        __m256i t0 = _mm256_loadu_si256((const __m256i*)(hay + i + needle_len - 1)), t1 = _mm256_loadu_si256((const __m256i*)(hay + i + needle_len - 1 + 32));
+        __m256i m0 = _mm256_and_si256(_mm256_cmpeq_epi8(h0, first), _mm256_cmpeq_epi8(t0, last));
+        __m256i m1 = _mm256_and_si256(_mm256_cmpeq_epi8(h1, first), _mm256_cmpeq_epi8(t1, last));
+        __m256i any = _mm256_or_si256(m0, m1);
+        if (_mm256_testz_si256(any, any)) continue;
+        uint64_t mask = (uint32_t)_mm256_movemask_epi8(m0) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(m1) << 32);
+        while (mask) {
+            size_t at = i + (size_t)trailing_zeros_64(mask);
+            if (tail_equal(hay + at + 1, needle + 1, needle_len - 2)) return hay + at;
+            mask &= mask - 1;
+        }
+    }
+    for (;; i += 32) {
+        unsigned skip = 0;
+        if (i > last_start) { skip = (unsigned)(i - last_start); i = last_start; }
+        __m256i head = _mm256_loadu_si256((const __m256i*)(hay + i));
+        __m256i tail = _mm256_loadu_si256((const __m256i*)(hay + i + needle_len - 1));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last))) & (unsigned)(0xFFFFFFFFull << skip);
+        while (mask) {
+            size_t at = i + (size_t)__builtin_ctz(mask);
+            if (tail_equal(hay + at + 1, needle + 1, needle_len - 2)) return hay + at;
+            mask &= mask - 1;
+        }
+        if (i == last_start) return NULL;
+    }
+}
+
+// ASCII blocks only: all bytes are 0..127, so signed byte compares are range
+// checks. The last block is loaded flush with the end and overlaps the one
+// before it: converting an ASCII byte twice gives the same result, and a block
+// with non-ASCII bytes is finished by the scalar code from where the previous
+// block stopped. Likewise the bytes a span block rechecks are already known to
+// be in the class.
+__attribute__((target("sse2")))
+static void convert_case_sse2(char *dst, const char *src, size_t n, bool upper) {
+    if (n < 16) { convert_case_scalar(dst, src, n, upper); return; }
+    __m128i lo = _mm_set1_epi8((char)(upper ? 'a' - 1 : 'A' - 1)), hi = _mm_set1_epi8((char)(upper ? 'z' + 1 : 'Z' + 1));
+    __m128i flip = _mm_set1_epi8(0x20);
+    for (size_t i = 0, done = 0;; i += 16) {
+        if (i + 16 > n) i = n - 16;
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(x) != 0) {
+            convert_case_scalar(dst + done, src + done, i + 16 - done, upper);
+        } else {
+            __m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(x, lo), _mm_cmplt_epi8(x, hi));
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(x, _mm_and_si128(in_range, flip)));
+        }
+        done = i + 16;
+        if (done == n) return;
+    }
+}
+
+__attribute__((target("avx2")))
+static void convert_case_avx2(char *dst, const char *src, size_t n, bool upper) {
+    if (n < 32) { convert_case_sse2(dst, src, n, upper); return; }
+    __m256i lo = _mm256_set1_epi8((char)(upper ? 'a' - 1 : 'A' - 1)), hi = _mm256_set1_epi8((char)(upper ? 'z' + 1 : 'Z' + 1));
+    __m256i flip = _mm256_set1_epi8(0x20);
+    for (size_t i = 0, done = 0;; i += 32) {
+        if (i + 32 > n) i = n - 32;
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (_mm256_movemask_epi8(x) != 0) {
+            convert_case_scalar(dst + done, src + done, i + 32 - done, upper);
+        } else {
+            __m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi8(x, lo), _mm256_cmpgt_epi8(hi, x));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(x, _mm256_and_si256(in_range, flip)));
+        }
+        done = i + 32;
+        if (done == n) return;
+    }
+}
+
+// Bytes >= 0x80 are negative as signed bytes, so they fall outside every range and end the span.
+__attribute__((target("sse2")))
+static size_t class_span_sse2(const char *p, size_t n, unsigned classes) {
+    if (n < 16) return class_span_scalar(p, n, classes);
+    for (size_t i = 0;; i += 16) {
+        if (i + 16 > n) i = n - 16;
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i)), m = _mm_setzero_si128();
+        if (classes & ASCII_ALPHA) {
+            __m128i folded = _mm_or_si128(x, _mm_set1_epi8(0x20));
+            m = _mm_or_si128(m, _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1))));
+        }
+        if (classes & ASCII_DIGIT) m = _mm_or_si128(m, _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(x, _mm_set1_epi8('9' + 1))));
+        if (classes & ASCII_SPACE) {
+            __m128i ctrl = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(x, _mm_set1_epi8('\r' + 1)));
+            m = _mm_or_si128(m, _mm_or_si128(ctrl, _mm_cmpeq_epi8(x, _mm_set1_epi8(' '))));
+        }
+        unsigned bits = (unsigned)_mm_movemask_epi8(m);
+        if (bits != 0xFFFF) return i + (size_t)__builtin_ctz(~bits);
+        if (i + 16 == n) return n;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t class_span_avx2(const char *p, size_t n, unsigned classes) {
+    if (n < 32) return class_span_sse2(p, n, classes);
+    for (size_t i = 0;; i += 32) {
+        if (i + 32 > n) i = n - 32;
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i)), m = _mm256_setzero_si256();
+        if (classes & ASCII_ALPHA) {
+            __m256i folded = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+            m = _mm256_or_si256(m, _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded)));
+        }
+        if (classes & ASCII_DIGIT) m = _mm256_or_si256(m, _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), x)));
+        if (classes & ASCII_SPACE) {
+            __m256i ctrl = _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('\t' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), x));
+            m = _mm256_or_si256(m, _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '))));
+        }
+        unsigned bits = (unsigned)_mm256_movemask_epi8(m);
+        if (bits != 0xFFFFFFFFu) return i + (size_t)__builtin_ctz(~bits);
+        if (i + 32 == n) return n;
+    }
+}
+#endif // AQUANT_X86_SIMD
+
+static StringKernels aq_string_kernels = { set_mask_scalar, find_scalar, convert_case_scalar, class_span_scalar };
+
+#ifdef AQUANT_X86_SIMD
+__attribute__((constructor))
+static void aq_select_string_kernels(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        StringKernels k = { set_mask_avx2, find_avx2, convert_case_avx2, class_span_avx2 };
+        aq_string_kernels = k;
+    } else if (__builtin_cpu_supports("sse2")) {
+        StringKernels k = { set_mask_sse2, find_sse2, convert_case_sse2, class_span_sse2 };
+        aq_string_kernels = k;
+    }
+}
+#endif
+
+// Case conversion entry point; short strings skip the vector setup.
+static inline void convert_case(char *dst, const char *src, size_t n, bool upper) {
+    if (n < 16) convert_case_scalar(dst, src, n, upper);
+    else aq_string_kernels.convert_case(dst, src, n, upper);
+}
+
+// First occurrence of needle (needle_len >= 1) in [p, end), or NULL.
+static inline const char* find_bytes(const char *p, const char *end, const char *needle, size_t needle_len) {
+    if ((size_t)(end - p) < needle_len) return NULL;
+    if (needle_len == 1) return memchr(p, (unsigned char)needle[0], (size_t)(end - p));
+    return aq_string_kernels.find(p, (size_t)(end - p), needle, needle_len);
+}
+
+
+// --- Random Number Engine ---
+// xoshiro256** (Blackman & Vigna), seeded through splitmix64. Callers either
+// own an aq_rng or use the calling thread's generator, which array_shuffle_*
+// and get_random_* draw from. Bounded integers use Lemire's multiply-shift
+// with rejection, so every value in [0, bound) is equally likely.
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define AQ_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+#define AQ_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define AQ_THREAD_LOCAL __declspec(thread)
+#else
+#define AQ_THREAD_LOCAL // No TLS: one shared generator
+#endif
+
+static AQ_THREAD_LOCAL aq_rng thread_rng;
+static AQ_THREAD_LOCAL bool thread_rng_seeded = false;
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+// O(1). Any seed (including 0) gives a valid, well-mixed state.
+void aq_rng_seed(aq_rng *rng, uint64_t seed) {
+    if (rng == NULL) return;
+    for (int i = 0; i < 4; ++i) rng->s[i] = splitmix64(&seed);
+}
+
+// O(1). Next 64 random bits; 0 if rng is NULL.
+uint64_t aq_rng_next(aq_rng *rng) {
+    if (rng == NULL) return 0;
+    uint64_t *s = rng->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+// O(1) expected. Uniform in [0, bound); 0 if bound is 0 or rng is NULL.
+uint64_t aq_rng_bounded(aq_rng *rng, uint64_t bound) {
+    if (rng == NULL || bound == 0) return 0;
+    uint64_t lo, hi = mul_hi_64(aq_rng_next(rng), bound, &lo);
+    if (lo < bound) {
+        uint64_t threshold = (0 - bound) % bound; // 2^64 mod bound
+        while (lo < threshold) hi = mul_hi_64(aq_rng_next(rng), bound, &lo);
+    }
+    return hi;
+}
+
+// O(1). Uniform in [0, 1) with 53 random bits; 0.0 if rng is NULL.
+double aq_rng_double(aq_rng *rng) {
+    if (rng == NULL) return 0.0;
+    return (double)(aq_rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+// The calling thread's generator; seeded from the clock and its own address on first use.
+static aq_rng* current_rng(void) {
+    if (!thread_rng_seeded) {
+        aq_rng_seed(&thread_rng, (uint64_t)time(NULL) ^ ((uint64_t)clock() << 32) ^ (uint64_t)(uintptr_t)&thread_rng);
+        thread_rng_seeded = true;
+    }
+    return &thread_rng;
+}
+
+// O(1). Makes the calling thread's random sequence reproducible.
+void aq_seed_random(uint64_t seed) {
+    aq_rng_seed(&thread_rng, seed);
+    thread_rng_seeded = true;
+}
+
+
+// --- Original Integer Array Functions ---
+// ... (array_max, array_min, array_sum, etc. - unchanged) ...
+bool array_max(const int *arr, size_t size, int *max_val) {
+    if (arr == NULL || size == 0 || max_val == NULL) return false;
+    int min_unused;
+    aq_kernels.minmax_int(arr, size, &min_unused, max_val);
+    return true;
+}
+
+bool array_min(const int *arr, size_t size, int *min_val) {
+    if (arr == NULL || size == 0 || min_val == NULL) return false;
+    int max_unused;
+    aq_kernels.minmax_int(arr, size, min_val, &max_unused);
+    return true;
+}
+
+bool array_sum(const int *arr, size_t size, long long *sum) {
+    if (sum == NULL) return false;
+    if (arr == NULL || size == 0) { *sum = 0; return true; }
+    *sum = aq_kernels.sum_int(arr, size);
+    return true;
+}
+
+bool array_contains_int(const int *arr, size_t size, int value) {
+    if (arr == NULL || size == 0) return false;
+    return aq_search.find_int(arr, size, value) < size;
+}
+
+int array_index_of_int(const int *arr, size_t size, int value) {
+    if (arr == NULL || size == 0) return -1;
+    size_t i = aq_search.find_int(arr, size, value);
+    return (i >= size || i > INT_MAX) ? -1 : (int)i; // Check index fits int
+}
+
+double array_average(const int *arr, size_t size) {
+    if (arr == NULL || size == 0) return NAN;
+    long long sum;
+    if (!array_sum(arr, size, &sum)) return NAN;
+    return (double)sum / size;
+}
+
+// Block length for the array_stats_* functions. Each block stays in L1 while
+// the min/max, sum and squared-deviation kernels run over it, so the array
+// itself is streamed from memory only once.
+#define STATS_BLOCK_SIZE 4096
+
+// Folds one block's (count, mean, M2) into the running totals (Chan et al.).
+static void stats_merge_block(size_t *count, double *mean, double *m2, size_t block_count, double block_mean, double block_m2) {
+    size_t total = *count + block_count;
+    double delta = block_mean - *mean;
+    *mean += delta * ((double)block_count / total);
+    *m2 += block_m2 + delta * delta * ((double)*count * block_count / total);
+    *count = total;
+}
+
+// O(n) time, one pass over memory. Population variance.
+bool array_stats_int(const int *arr, size_t size, aq_stats *stats) {
+    if (arr == NULL || size == 0 || stats == NULL) return false;
+    int lo = arr[0], hi = arr[0];
+    size_t argmin = 0, argmax = 0, count = 0;
+    long long total = 0;
+    double mean = 0.0, m2 = 0.0;
+    for (size_t start = 0; start < size; start += STATS_BLOCK_SIZE) {
+        const int *block = arr + start;
+        size_t len = (size - start < STATS_BLOCK_SIZE) ? size - start : STATS_BLOCK_SIZE;
+        int block_lo, block_hi;
+        aq_kernels.minmax_int(block, len, &block_lo, &block_hi);
+        if (block_lo < lo) { lo = block_lo; argmin = start; while (arr[argmin] != lo) argmin++; }
+        if (block_hi > hi) { hi = block_hi; argmax = start; while (arr[argmax] != hi) argmax++; }
+        long long block_sum = aq_kernels.sum_int(block, len);
+        double block_mean = (double)block_sum / len;
+        total += block_sum;
+        stats_merge_block(&count, &mean, &m2, len, block_mean, aq_kernels.sqdev_int(block, len, block_mean));
+    }
+    stats->count = size;
+    stats->min = lo; stats->max = hi;
+    stats->argmin = argmin; stats->argmax = argmax;
+    stats->sum = (double)total;
+    stats->mean = (double)total / size;
+    stats->variance = m2 / size;
+    return true;
+}
+
+size_t array_count_occurrence(const int *arr, size_t size, int value) {
+    if (arr == NULL || size == 0) return 0;
+    return aq_search.count_int(arr, size, value);
+}
+
+int* array_copy_int(const int *arr, size_t size) {
+    if (arr == NULL || size == 0) return NULL;
+    int *copy = malloc(size * sizeof(int));
+    if (copy == NULL) return NULL; // Allocation failed
+    memcpy(copy, arr, size * sizeof(int));
+    return copy; // Caller must free
+}
+
+
+// --- Hash Table Helper Functions ---
+// Open-addressing (linear probing) set of ints with per-key counts. All slots
+// live in one contiguous allocation; a slot with count == 0 is empty.
+typedef struct HashSlot {
+    int key;
+    int count;
+} HashSlot;
+
+typedef struct HashTable {
+    HashSlot *slots;
+    size_t mask;   // capacity - 1 (capacity is a power of two)
+    size_t used;   // Number of occupied slots
+} HashTable;
+
+// 64-bit finalizer (splitmix64). Spreads x and -x, and runs of nearby keys, across the table.
+static size_t hash_func(int key, size_t mask) {
+    uint64_t h = (uint64_t)(uint32_t)key;
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return (size_t)h & mask;
+}
+
+// Sizes the table for `expected` keys at <= 50% load. Returns false on allocation failure.
+static bool ht_init(HashTable *ht, size_t expected) {
+    size_t capacity = 16;
+    while (capacity < expected * 2 && capacity < ((size_t)1 << (sizeof(size_t) * 8 - 2))) capacity <<= 1;
+    ht->slots = calloc(capacity, sizeof(HashSlot));
+    if (!ht->slots) return false;
+    ht->mask = capacity - 1;
+    ht->used = 0;
+    return true;
+}
+
+static void ht_destroy(HashTable *ht) {
+    if (!ht) return;
+    free(ht->slots);
+    ht->slots = NULL;
+}
+
+static HashSlot* ht_search(const HashTable *ht, int key) {
+    size_t index = hash_func(key, ht->mask);
+    while (ht->slots[index].count != 0) {
+        if (ht->slots[index].key == key) return &ht->slots[index];
+        index = (index + 1) & ht->mask;
+    }
+    return NULL;
+}
+
+// Doubles the capacity and reinserts every occupied slot.
+static bool ht_grow(HashTable *ht) {
+    size_t old_capacity = ht->mask + 1;
+    HashSlot *old_slots = ht->slots;
+    HashSlot *new_slots = calloc(old_capacity * 2, sizeof(HashSlot));
+    if (!new_slots) return false;
+    ht->slots = new_slots;
+    ht->mask = old_capacity * 2 - 1;
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_slots[i].count == 0) continue;
+        size_t index = hash_func(old_slots[i].key, ht->mask);
+        while (new_slots[index].count != 0) index = (index + 1) & ht->mask;
+        new_slots[index] = old_slots[i];
+    }
+    free(old_slots);
+    return true;
+}
+
+static bool ht_insert(HashTable *ht, int key) {
+    if ((ht->used + 1) * 4 > (ht->mask + 1) * 3 && !ht_grow(ht)) return false; // Keep load <= 75%
+    size_t index = hash_func(key, ht->mask);
+    while (ht->slots[index].count != 0) {
+        if (ht->slots[index].key == key) { ht->slots[index].count++; return true; }
+        index = (index + 1) & ht->mask;
+    }
+    ht->slots[index].key = key;
+    ht->slots[index].count = 1;
+    ht->used++;
+    return true;
+}
+
+static bool ht_contains_key(const HashTable *ht, int key) {
+    return ht_search(ht, key) != NULL;
+}
+
+
+// --- Pair Functions ---
+// ... (array_has_pair_sum, array_has_pair_product, array_has_pair_difference - unchanged) ...
+bool array_has_pair_sum(const int *arr, size_t size, int target) {
+    if (arr == NULL || size < 2) return false;
+    HashTable table;
+    if (!ht_init(&table, size)) return false;
+    HashTable *ht = &table;
+    bool found = false;
+    for (size_t i = 0; i < size; ++i) {
+        long long complement_ll = (long long)target - arr[i];
+        if (complement_ll >= INT_MIN && complement_ll <= INT_MAX) {
+             if (ht_contains_key(ht, (int)complement_ll)) {
+                  found = true;
+                  break;
+             }
+        }
+        ht_insert(ht, arr[i]);
+    }
+    ht_destroy(ht);
+    return found;
+}
+
+
+bool array_has_pair_product(const int *arr, size_t size, int target) {
+    if (arr == NULL || size < (target == 0 ? 1 : 2)) return false;
+    if (target != 0 && size < 2) return false; // Ensure size >= 2 for non-zero target
+
+    HashTable table;
+    if (!ht_init(&table, size)) return false;
+    HashTable *ht = &table;
+
+    bool found = false;
+    for (size_t i = 0; i < size; ++i) {
+         int current_val = arr[i];
+
+         if (target == 0) {
+             if (current_val == 0) {
+                 // Need another element (zero or non-zero) if target is 0. Size check handles this.
                  if (size > 1) { found = true; break; }
              } else if (ht_contains_key(ht, 0)) { // If non-zero found a zero previously
                   found = true; break;
              }
          } else { // target != 0, current_val must be non-zero
-              if (current_val != 0 && target % current_val == 0) {
+              if (current_val != 0 && (long long)target % current_val == 0) { // long long: INT_MIN % -1 traps in int
                  long long needed_ll = (long long)target / current_val;
                  if (needed_ll >= INT_MIN && needed_ll <= INT_MAX) {
                      if (ht_contains_key(ht, (int)needed_ll)) {
@@ -456,49 +3223,1312 @@ bool array_has_pair_product(const int *arr, size_t size, int target) {
          ht_insert(ht, current_val);
     }
 
-    ht_destroy(ht);
-    return found;
+    ht_destroy(ht);
+    return found;
+}
+
+bool array_has_pair_difference(const int *arr, size_t size, int target) {
+    if (arr == NULL || size < 1) return false;
+    long long abs_target = (target < 0) ? -(long long)target : target; // -INT_MIN overflows int
+
+    // Need size >= 2 for non-zero difference with distinct indices
+    if (abs_target != 0 && size < 2) return false;
+
+    HashTable table;
+    if (!ht_init(&table, size)) return false;
+    HashTable *ht = &table;
+    bool found = false;
+
+    for (size_t i = 0; i < size; ++i) {
+        int current_val = arr[i];
+        long long needed1_ll = (long long)current_val - abs_target;
+        long long needed2_ll = (long long)current_val + abs_target;
+
+        if ((needed1_ll >= INT_MIN && needed1_ll <= INT_MAX && ht_contains_key(ht, (int)needed1_ll)) ||
+            (needed2_ll >= INT_MIN && needed2_ll <= INT_MAX && ht_contains_key(ht, (int)needed2_ll))) {
+             found = true;
+             break;
+        }
+        ht_insert(ht, current_val);
+    }
+
+    ht_destroy(ht);
+    return found;
+}
+
+
+// --- String Hash Table ---
+// Open-addressing table behind aq_strset, aq_strmap, array_unique_string and the
+// string histogram. Entries (cached hash, key, length, value) are stored densely
+// in insertion order. The probe array holds one 64-bit word per slot: entry
+// number + 1 in the low half (0 = empty slot) and the top 32 hash bits in the
+// high half, so probing walks 8 slots per cache line and only reads an entry,
+// and then its key, when the tag matches. Linear probing at load <= 75%;
+// growing rehashes from the cached hashes without touching the keys.
+#define STRING_TABLE_TAG 0xFFFFFFFF00000000ULL
+#define STRING_TABLE_MAX_ENTRIES ((size_t)UINT32_MAX - 1)
+#define STRING_TABLE_BATCH 16 // Keys hashed (and their slots prefetched) ahead of probing
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AQ_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define AQ_PREFETCH(p) ((void)0)
+#endif
+
+typedef struct StringEntry {
+    uint64_t hash;
+    const char *key;
+    size_t length;
+    size_t value;
+} StringEntry;
+
+typedef struct StringTable {
+    uint64_t *slots;
+    size_t mask;          // Slot capacity - 1 (a power of two)
+    StringEntry *entries; // count used, capacity allocated
+    size_t count;
+    size_t capacity;
+} StringTable;
+
+static inline uint64_t hash_read64(const unsigned char *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint64_t hash_read32(const unsigned char *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+static inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+    uint64_t lo, hi = mul_hi_64(a, b, &lo);
+    return lo ^ hi;
+}
+
+// wyhash-style hash (after Wang Yi's public-domain wyhash, seed 0): 8 bytes per
+// multiply-mix, keys up to 16 bytes in two overlapping reads, no per-byte loop.
+static uint64_t hash_bytes(const char *data, size_t len) {
+    static const uint64_t secret[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
+    const unsigned char *p = (const unsigned char*)data;
+    uint64_t seed = hash_mix(secret[0], secret[1]);
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t shift = (len >> 3) << 2;
+            a = (hash_read32(p) << 32) | hash_read32(p + shift);
+            b = (hash_read32(p + len - 4) << 32) | hash_read32(p + len - 4 - shift);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i >= 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = hash_mix(hash_read64(p) ^ secret[1], hash_read64(p + 8) ^ seed);
+                see1 = hash_mix(hash_read64(p + 16) ^ secret[2], hash_read64(p + 24) ^ see1);
+                see2 = hash_mix(hash_read64(p + 32) ^ secret[3], hash_read64(p + 40) ^ see2);
+                p += 48; i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = hash_mix(hash_read64(p) ^ secret[1], hash_read64(p + 8) ^ seed);
+            p += 16; i -= 16;
+        }
+        a = hash_read64(p + i - 16);
+        b = hash_read64(p + i - 8);
+    }
+    a ^= secret[1]; b ^= seed;
+    uint64_t lo, hi = mul_hi_64(a, b, &lo);
+    return hash_mix(lo ^ secret[0] ^ (uint64_t)len, hi ^ secret[1]);
+}
+
+// Sizes the table for `expected` keys at <= 50% load. Returns false on allocation failure.
+static bool st_init(StringTable *t, size_t expected) {
+    size_t capacity = 16;
+    if (expected > STRING_TABLE_MAX_ENTRIES) expected = STRING_TABLE_MAX_ENTRIES;
+    while (capacity < expected * 2 && capacity < ((size_t)1 << (sizeof(size_t) * 8 - 2))) capacity <<= 1;
+    t->slots = calloc(capacity, sizeof(uint64_t));
+    t->entries = malloc((expected < 8 ? 8 : expected) * sizeof(StringEntry));
+    if (t->slots == NULL || t->entries == NULL) { free(t->slots); free(t->entries); t->slots = NULL; t->entries = NULL; return false; }
+    t->mask = capacity - 1;
+    t->count = 0;
+    t->capacity = (expected < 8) ? 8 : expected;
+    return true;
+}
+
+static void st_destroy(StringTable *t) {
+    free(t->slots);
+    free(t->entries);
+    t->slots = NULL;
+    t->entries = NULL;
+}
+
+// Index of the slot holding key, or of the empty slot where it would go.
+static inline size_t st_probe(const StringTable *t, const char *key, size_t length, uint64_t hash) {
+    uint64_t tag = hash & STRING_TABLE_TAG;
+    size_t index = (size_t)hash & t->mask;
+    for (;;) {
+        uint64_t slot = t->slots[index];
+        if (slot == 0) return index;
+        if ((slot & STRING_TABLE_TAG) == tag) {
+            const StringEntry *e = &t->entries[(uint32_t)slot - 1];
+            if (e->hash == hash && e->length == length && memcmp(e->key, key, length) == 0) return index;
+        }
+        index = (index + 1) & t->mask;
+    }
+}
+
+static inline StringEntry* st_find(const StringTable *t, const char *key, size_t length, uint64_t hash) {
+    uint64_t slot = t->slots[st_probe(t, key, length, hash)];
+    return (slot == 0) ? NULL : &t->entries[(uint32_t)slot - 1];
+}
+
+// Doubles the slot capacity and re-places every entry by its cached hash.
+static bool st_grow(StringTable *t) {
+    size_t capacity = (t->mask + 1) * 2;
+    uint64_t *slots = calloc(capacity, sizeof(uint64_t));
+    if (slots == NULL) return false;
+    free(t->slots);
+    t->slots = slots;
+    t->mask = capacity - 1;
+    for (size_t i = 0; i < t->count; ++i) {
+        uint64_t hash = t->entries[i].hash;
+        size_t index = (size_t)hash & t->mask;
+        while (slots[index] != 0) index = (index + 1) & t->mask;
+        slots[index] = (hash & STRING_TABLE_TAG) | (uint64_t)(i + 1);
+    }
+    return true;
+}
+
+// Finds key or appends it with value 0; *added tells which. A new key is copied
+// into arena (null-terminated) when one is given and borrowed otherwise.
+// Returns NULL on allocation failure. Entry pointers last until the next insertion.
+static StringEntry* st_insert(StringTable *t, aq_arena *arena, const char *key, size_t length, uint64_t hash, bool *added) {
+    size_t index = st_probe(t, key, length, hash);
+    *added = false;
+    if (t->slots[index] != 0) return &t->entries[(uint32_t)t->slots[index] - 1];
+    if (t->count == STRING_TABLE_MAX_ENTRIES) return NULL;
+    if ((t->count + 1) * 4 > (t->mask + 1) * 3) {
+        if (!st_grow(t)) return NULL;
+        index = st_probe(t, key, length, hash);
+    }
+    if (t->count == t->capacity) {
+        size_t capacity = t->capacity * 2;
+        StringEntry *entries = realloc(t->entries, capacity * sizeof(StringEntry));
+        if (entries == NULL) return NULL;
+        t->entries = entries;
+        t->capacity = capacity;
+    }
+    if (arena != NULL) {
+        char *copy = aq_arena_alloc(arena, length + 1);
+        if (copy == NULL) return NULL;
+        if (length > 0) memcpy(copy, key, length);
+        copy[length] = '\0';
+        key = copy;
+    }
+    StringEntry *e = &t->entries[t->count];
+    e->hash = hash; e->key = key; e->length = length; e->value = 0;
+    t->slots[index] = (hash & STRING_TABLE_TAG) | (uint64_t)(++t->count);
+    *added = true;
+    return e;
+}
+
+// Removes key if present. Later slots of the probe run shift back into the gap
+// (no tombstones), and the last entry moves into the freed entry.
+static bool st_remove(StringTable *t, const char *key, size_t length, uint64_t hash) {
+    size_t hole = st_probe(t, key, length, hash);
+    if (t->slots[hole] == 0) return false;
+    size_t entry = (uint32_t)t->slots[hole] - 1;
+    for (size_t next = (hole + 1) & t->mask; t->slots[next] != 0; next = (next + 1) & t->mask) {
+        size_t home = (size_t)t->entries[(uint32_t)t->slots[next] - 1].hash & t->mask;
+        if (((next - home) & t->mask) >= ((next - hole) & t->mask)) { t->slots[hole] = t->slots[next]; hole = next; }
+    }
+    t->slots[hole] = 0;
+    size_t last = --t->count;
+    if (entry != last) {
+        t->entries[entry] = t->entries[last];
+        size_t index = (size_t)t->entries[entry].hash & t->mask;
+        while ((uint32_t)t->slots[index] != last + 1) index = (index + 1) & t->mask;
+        t->slots[index] = (t->slots[index] & STRING_TABLE_TAG) | (uint64_t)(entry + 1);
+    }
+    return true;
+}
+
+enum { ST_COUNT, ST_FIRST_INDEX, ST_CANONICAL };
+
+// Inserts the non-NULL strings of arr one batch at a time: the batch's strings
+// are hashed and their slots prefetched before any is probed, so the cache misses
+// of neighbouring keys overlap instead of queueing. New keys are copied into arena
+// when one is given (see st_insert). ST_COUNT adds 1 to each key's value;
+// ST_FIRST_INDEX stores the index of its first occurrence; ST_CANONICAL stores
+// the table's copy of arr[i] in out[i] (NULL stays NULL).
+static bool st_insert_all(StringTable *t, aq_arena *arena, const string *arr, size_t size, int mode, string *out) {
+    size_t lengths[STRING_TABLE_BATCH];
+    uint64_t hashes[STRING_TABLE_BATCH];
+    for (size_t base = 0; base < size; base += STRING_TABLE_BATCH) {
+        size_t n = (size - base < STRING_TABLE_BATCH) ? size - base : STRING_TABLE_BATCH;
+        for (size_t j = 0; j < n; ++j) {
+            if (base + STRING_TABLE_BATCH + j < size) AQ_PREFETCH(arr[base + STRING_TABLE_BATCH + j]);
+            const char *s = arr[base + j];
+            if (s == NULL) continue;
+            lengths[j] = strlen(s);
+            hashes[j] = hash_bytes(s, lengths[j]);
+            AQ_PREFETCH(&t->slots[(size_t)hashes[j] & t->mask]);
+        }
+        for (size_t j = 0; j < n; ++j) {
+            const char *s = arr[base + j];
+            if (s == NULL) { if (mode == ST_CANONICAL) out[base + j] = NULL; continue; }
+            bool added;
+            StringEntry *e = st_insert(t, arena, s, lengths[j], hashes[j], &added);
+            if (e == NULL) return false;
+            if (mode == ST_COUNT) e->value++;
+            else if (mode == ST_CANONICAL) out[base + j] = (string)e->key;
+            else if (added) e->value = base + j;
+        }
+    }
+    return true;
+}
+
+static void st_clear(StringTable *t) {
+    memset(t->slots, 0, (t->mask + 1) * sizeof(uint64_t));
+    t->count = 0;
+}
+
+// aq_strset and aq_strmap own their keys: each distinct key is copied once into
+// the container's arena, so insertion costs no malloc per key.
+struct aq_strset {
+    StringTable table;
+    aq_arena *keys;
+};
+
+struct aq_strmap {
+    StringTable table;
+    aq_arena *keys;
+};
+
+static bool string_container_init(StringTable *t, aq_arena **keys, size_t expected) {
+    if (!st_init(t, expected)) return false;
+    *keys = aq_arena_create(0);
+    if (*keys == NULL) { st_destroy(t); return false; }
+    return true;
+}
+
+// O(expected) time. expected is a sizing hint; the set grows as needed. NULL on allocation failure.
+aq_strset* aq_strset_create(size_t expected) {
+    aq_strset *set = malloc(sizeof(aq_strset));
+    if (set == NULL) return NULL;
+    if (!string_container_init(&set->table, &set->keys, expected)) { free(set); return NULL; }
+    return set;
+}
+
+void aq_strset_destroy(aq_strset *set) {
+    if (set == NULL) return;
+    st_destroy(&set->table);
+    aq_arena_destroy(set->keys);
+    free(set);
+}
+
+// O(capacity) time. Keeps the table and key storage for reuse.
+void aq_strset_clear(aq_strset *set) {
+    if (set == NULL) return;
+    st_clear(&set->table);
+    aq_arena_reset(set->keys);
+}
+
+// O(L) average time. Adding a present key is a no-op. False for NULL or on allocation failure.
+bool aq_strset_add(aq_strset *set, const string s) {
+    if (s == NULL) return false;
+    return aq_strset_add_view(set, (aq_strview){ s, strlen(s) });
+}
+
+bool aq_strset_add_view(aq_strset *set, aq_strview s) {
+    if (set == NULL || (s.ptr == NULL && s.len > 0)) return false;
+    bool added;
+    return st_insert(&set->table, set->keys, s.ptr ? s.ptr : "", s.len, hash_bytes(s.ptr, s.len), &added) != NULL;
+}
+
+// O(L) average time.
+bool aq_strset_contains(const aq_strset *set, const string s) {
+    if (s == NULL) return false;
+    return aq_strset_contains_view(set, (aq_strview){ s, strlen(s) });
+}
+
+bool aq_strset_contains_view(const aq_strset *set, aq_strview s) {
+    if (set == NULL || (s.ptr == NULL && s.len > 0)) return false;
+    return st_find(&set->table, s.ptr ? s.ptr : "", s.len, hash_bytes(s.ptr, s.len)) != NULL;
+}
+
+// O(L) average time. Returns false if s was not in the set.
+bool aq_strset_remove(aq_strset *set, const string s) {
+    if (set == NULL || s == NULL) return false;
+    size_t len = strlen(s);
+    return st_remove(&set->table, s, len, hash_bytes(s, len));
+}
+
+size_t aq_strset_size(const aq_strset *set) {
+    return (set == NULL) ? 0 : set->table.count;
+}
+
+// Iterates the keys: start with *cursor = 0, call until it returns false. Keys come
+// in insertion order until the first removal. The key belongs to the set.
+bool aq_strset_next(const aq_strset *set, size_t *cursor, string *value) {
+    if (set == NULL || cursor == NULL || *cursor >= set->table.count) return false;
+    if (value) *value = (string)set->table.entries[*cursor].key;
+    (*cursor)++;
+    return true;
+}
+
+// O(expected) time. expected is a sizing hint; the map grows as needed. NULL on allocation failure.
+aq_strmap* aq_strmap_create(size_t expected) {
+    aq_strmap *map = malloc(sizeof(aq_strmap));
+    if (map == NULL) return NULL;
+    if (!string_container_init(&map->table, &map->keys, expected)) { free(map); return NULL; }
+    return map;
+}
+
+void aq_strmap_destroy(aq_strmap *map) {
+    if (map == NULL) return;
+    st_destroy(&map->table);
+    aq_arena_destroy(map->keys);
+    free(map);
+}
+
+// O(capacity) time. Keeps the table and key storage for reuse.
+void aq_strmap_clear(aq_strmap *map) {
+    if (map == NULL) return;
+    st_clear(&map->table);
+    aq_arena_reset(map->keys);
+}
+
+// O(L) average time. Pointer to key's value, inserting the key with value 0 if it is
+// absent, e.g. (*aq_strmap_ref(map, word))++ to count. Valid until the next insertion.
+// NULL for a NULL key or on allocation failure.
+size_t* aq_strmap_ref(aq_strmap *map, const string key) {
+    if (key == NULL) return NULL;
+    return aq_strmap_ref_view(map, (aq_strview){ key, strlen(key) });
+}
+
+size_t* aq_strmap_ref_view(aq_strmap *map, aq_strview key) {
+    if (map == NULL || (key.ptr == NULL && key.len > 0)) return NULL;
+    bool added;
+    StringEntry *e = st_insert(&map->table, map->keys, key.ptr ? key.ptr : "", key.len, hash_bytes(key.ptr, key.len), &added);
+    return (e == NULL) ? NULL : &e->value;
+}
+
+// O(L) average time. Inserts or overwrites. False for a NULL key or on allocation failure.
+bool aq_strmap_put(aq_strmap *map, const string key, size_t value) {
+    size_t *ref = aq_strmap_ref(map, key);
+    if (ref == NULL) return false;
+    *ref = value;
+    return true;
+}
+
+// O(L) average time. Returns false (leaving *value alone) if key is absent. value may be NULL.
+bool aq_strmap_get(const aq_strmap *map, const string key, size_t *value) {
+    if (key == NULL) return false;
+    return aq_strmap_get_view(map, (aq_strview){ key, strlen(key) }, value);
+}
+
+bool aq_strmap_get_view(const aq_strmap *map, aq_strview key, size_t *value) {
+    if (map == NULL || (key.ptr == NULL && key.len > 0)) return false;
+    const StringEntry *e = st_find(&map->table, key.ptr ? key.ptr : "", key.len, hash_bytes(key.ptr, key.len));
+    if (e == NULL) return false;
+    if (value) *value = e->value;
+    return true;
+}
+
+// O(L) average time. Returns false if key was not in the map.
+bool aq_strmap_remove(aq_strmap *map, const string key) {
+    if (map == NULL || key == NULL) return false;
+    size_t len = strlen(key);
+    return st_remove(&map->table, key, len, hash_bytes(key, len));
+}
+
+size_t aq_strmap_size(const aq_strmap *map) {
+    return (map == NULL) ? 0 : map->table.count;
+}
+
+// Same protocol as aq_strset_next; key and value may be NULL.
+bool aq_strmap_next(const aq_strmap *map, size_t *cursor, string *key, size_t *value) {
+    if (map == NULL || cursor == NULL || *cursor >= map->table.count) return false;
+    const StringEntry *e = &map->table.entries[*cursor];
+    if (key) *key = (string)e->key;
+    if (value) *value = e->value;
+    (*cursor)++;
+    return true;
+}
+
+
+// --- Histogram ---
+// aq_histogram counts every distinct value once so later count queries are O(1).
+// Int arrays whose value range is at most 2 * size (or HISTOGRAM_DENSE_RANGE)
+// use a plain array of counts indexed by value - min; others use the hash table
+// above. String histograms count in the string hash table, borrowing the keys.
+#define HISTOGRAM_DENSE_RANGE 4096
+#define HISTOGRAM_INITIAL_KEYS 1024
+
+enum { HISTOGRAM_DENSE, HISTOGRAM_SPARSE, HISTOGRAM_STRING };
+
+struct aq_histogram {
+    int mode;
+    size_t distinct;         // Number of distinct values (NULL counts as one)
+    int min;                 // Dense: value of counts[0]
+    size_t range;            // Dense: number of counters
+    size_t *counts;          // Dense
+    HashTable table;         // Sparse
+    StringTable strings;     // String: value is the count
+    size_t null_count;       // String: number of NULL elements
+};
+
+// O(n) time. Returns NULL on NULL/empty input or allocation failure.
+aq_histogram* aq_histogram_create_int(const int *arr, size_t size) {
+    if (arr == NULL || size == 0) return NULL;
+    aq_histogram *hist = calloc(1, sizeof(aq_histogram));
+    if (hist == NULL) return NULL;
+    int min_val, max_val;
+    aq_kernels.minmax_int(arr, size, &min_val, &max_val);
+    uint64_t range = (uint64_t)((long long)max_val - min_val) + 1;
+    if (range <= HISTOGRAM_DENSE_RANGE || range <= 2 * (uint64_t)size) {
+        hist->mode = HISTOGRAM_DENSE;
+        hist->min = min_val;
+        hist->range = (size_t)range;
+        hist->counts = calloc(hist->range, sizeof(size_t));
+        if (hist->counts == NULL) { free(hist); return NULL; }
+        for (size_t i = 0; i < size; ++i) hist->counts[(size_t)((long long)arr[i] - min_val)]++;
+        for (size_t v = 0; v < hist->range; ++v) hist->distinct += hist->counts[v] != 0;
+        return hist;
+    }
+    // Sparse counts are int: more than INT_MAX copies of one value cannot be represented
+    if (size > INT_MAX) { free(hist); return NULL; }
+    hist->mode = HISTOGRAM_SPARSE;
+    if (!ht_init(&hist->table, size < HISTOGRAM_INITIAL_KEYS ? size : HISTOGRAM_INITIAL_KEYS)) { free(hist); return NULL; }
+    for (size_t i = 0; i < size; ++i) {
+        if (!ht_insert(&hist->table, arr[i])) { aq_histogram_destroy(hist); return NULL; }
+    }
+    hist->distinct = hist->table.used;
+    return hist;
+}
+
+// O(n * L) time. The strings are not copied: they must outlive the histogram.
+aq_histogram* aq_histogram_create_string(const string *arr, size_t size) {
+    if (arr == NULL || size == 0) return NULL;
+    aq_histogram *hist = calloc(1, sizeof(aq_histogram));
+    if (hist == NULL) return NULL;
+    hist->mode = HISTOGRAM_STRING;
+    if (!st_init(&hist->strings, size < HISTOGRAM_INITIAL_KEYS ? size : HISTOGRAM_INITIAL_KEYS)) { free(hist); return NULL; }
+    if (!st_insert_all(&hist->strings, NULL, arr, size, ST_COUNT, NULL)) { aq_histogram_destroy(hist); return NULL; }
+    for (size_t i = 0; i < size; ++i) hist->null_count += (arr[i] == NULL);
+    hist->distinct = hist->strings.count + (hist->null_count != 0);
+    return hist;
+}
+
+void aq_histogram_destroy(aq_histogram *hist) {
+    if (hist == NULL) return;
+    free(hist->counts);
+    ht_destroy(&hist->table);
+    st_destroy(&hist->strings);
+    free(hist);
+}
+
+// O(1). Number of distinct values (a NULL string counts as one value).
+size_t aq_histogram_distinct(const aq_histogram *hist) {
+    return (hist == NULL) ? 0 : hist->distinct;
+}
+
+// O(1) time (average for sparse histograms). Returns 0 for absent values.
+size_t aq_histogram_count_int(const aq_histogram *hist, int value) {
+    if (hist == NULL) return 0;
+    if (hist->mode == HISTOGRAM_DENSE) {
+        long long offset = (long long)value - hist->min;
+        return (offset >= 0 && (unsigned long long)offset < hist->range) ? hist->counts[offset] : 0;
+    }
+    if (hist->mode == HISTOGRAM_SPARSE) {
+        HashSlot *slot = ht_search(&hist->table, value);
+        return slot ? (size_t)slot->count : 0;
+    }
+    return 0;
+}
+
+// O(L) time. NULL counts the NULL elements, like array_count_occurrence_string.
+size_t aq_histogram_count_string(const aq_histogram *hist, const string value) {
+    if (hist == NULL || hist->mode != HISTOGRAM_STRING) return 0;
+    if (value == NULL) return hist->null_count;
+    size_t len = strlen(value);
+    const StringEntry *e = st_find(&hist->strings, value, len, hash_bytes(value, len));
+    return (e == NULL) ? 0 : e->value;
 }
 
-bool array_has_pair_difference(const int *arr, size_t size, int target) {
-    if (arr == NULL || size < 1) return false;
-    int abs_target = (target < 0) ? -target : target;
+// Iterates (value, count) pairs: start with *cursor = 0, call until it returns false.
+// Dense histograms yield values in ascending order, sparse ones in table order.
+bool aq_histogram_next_int(const aq_histogram *hist, size_t *cursor, int *value, size_t *count) {
+    if (hist == NULL || cursor == NULL) return false;
+    if (hist->mode == HISTOGRAM_DENSE) {
+        for (size_t i = *cursor; i < hist->range; ++i) {
+            if (hist->counts[i] == 0) continue;
+            if (value) *value = (int)((long long)hist->min + (long long)i);
+            if (count) *count = hist->counts[i];
+            *cursor = i + 1;
+            return true;
+        }
+    } else if (hist->mode == HISTOGRAM_SPARSE) {
+        for (size_t i = *cursor; i <= hist->table.mask; ++i) {
+            if (hist->table.slots[i].count == 0) continue;
+            if (value) *value = hist->table.slots[i].key;
+            if (count) *count = (size_t)hist->table.slots[i].count;
+            *cursor = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
 
-    // Need size >= 2 for non-zero difference with distinct indices
-    if (abs_target != 0 && size < 2) return false;
+// Same protocol as aq_histogram_next_int, in order of first occurrence. The NULL entry (if any) comes first.
+bool aq_histogram_next_string(const aq_histogram *hist, size_t *cursor, string *value, size_t *count) {
+    if (hist == NULL || cursor == NULL || hist->mode != HISTOGRAM_STRING) return false;
+    if (*cursor == 0) {
+        *cursor = 1;
+        if (hist->null_count != 0) {
+            if (value) *value = NULL;
+            if (count) *count = hist->null_count;
+            return true;
+        }
+    }
+    size_t i = *cursor - 1;
+    if (i >= hist->strings.count) return false;
+    if (value) *value = (string)hist->strings.entries[i].key;
+    if (count) *count = hist->strings.entries[i].value;
+    *cursor = i + 2;
+    return true;
+}
 
-    HashTable *ht = ht_create(size);
-    if (!ht) return false;
-    bool found = false;
 
+// --- Sort Engine ---
+// sort_array, sort_array_float and sort_array_double map each element to an
+// unsigned key whose integer order is the sort order, then run an LSD radix
+// sort (8-bit digits, one histogram pass, passes whose digit is constant are
+// skipped). Ints flip the sign bit. Floats/doubles flip the sign bit of
+// non-negative values and every bit of negative ones, which gives the IEEE
+// total order: -NaN < -inf < ... < -0.0 < +0.0 < ... < +inf < +NaN.
+// Inputs up to RADIX_SORT_THRESHOLD elements are copied to a stack buffer of
+// keys and sorted with an inlined quicksort instead.
+#define RADIX_SORT_THRESHOLD 256
+#define SMALL_SORT_INSERTION 16
+
+static uint32_t int_to_key(int v) { uint32_t u; memcpy(&u, &v, 4); return u ^ 0x80000000u; }
+static int key_to_int(uint32_t k) { int v; k ^= 0x80000000u; memcpy(&v, &k, 4); return v; }
+static uint32_t float_to_key(float f) {
+    uint32_t u; memcpy(&u, &f, 4);
+    return u ^ ((uint32_t)-(int32_t)(u >> 31) | 0x80000000u);
+}
+static float key_to_float(uint32_t k) {
+    float f; k ^= ((k >> 31) - 1) | 0x80000000u;
+    memcpy(&f, &k, 4); return f;
+}
+static uint64_t double_to_key(double d) {
+    uint64_t u; memcpy(&u, &d, 8);
+    return u ^ ((uint64_t)-(int64_t)(u >> 63) | 0x8000000000000000ULL);
+}
+static double key_to_double(uint64_t k) {
+    double d; k ^= ((k >> 63) - 1) | 0x8000000000000000ULL;
+    memcpy(&d, &k, 8); return d;
+}
+
+// Quicksort (median of three, insertion sort below SMALL_SORT_INSERTION).
+// Recurses into the smaller side only. Used for n <= RADIX_SORT_THRESHOLD.
+static void small_sort_u32(uint32_t *a, size_t n) {
+    while (n > SMALL_SORT_INSERTION) {
+        size_t mid = n / 2;
+        uint32_t x = a[0], y = a[mid], z = a[n - 1];
+        uint32_t pivot = (x < y) ? ((y < z) ? y : (x < z ? z : x)) : ((x < z) ? x : (y < z ? z : y));
+        size_t i = 0, j = n - 1;
+        for (;;) {
+            while (a[i] < pivot) i++;
+            while (pivot < a[j]) j--;
+            if (i >= j) break;
+            uint32_t t = a[i]; a[i] = a[j]; a[j] = t;
+            i++; j--;
+        }
+        // [0, j] <= pivot <= [j + 1, n)
+        if (j + 1 < n - j - 1) { small_sort_u32(a, j + 1); a += j + 1; n -= j + 1; }
+        else { small_sort_u32(a + j + 1, n - j - 1); n = j + 1; }
+    }
+    for (size_t i = 1; i < n; ++i) {
+        uint32_t v = a[i]; size_t k = i;
+        while (k > 0 && a[k - 1] > v) { a[k] = a[k - 1]; k--; }
+        a[k] = v;
+    }
+}
+
+static void small_sort_u64(uint64_t *a, size_t n) {
+    while (n > SMALL_SORT_INSERTION) {
+        size_t mid = n / 2;
+        uint64_t x = a[0], y = a[mid], z = a[n - 1];
+        uint64_t pivot = (x < y) ? ((y < z) ? y : (x < z ? z : x)) : ((x < z) ? x : (y < z ? z : y));
+        size_t i = 0, j = n - 1;
+        for (;;) {
+            while (a[i] < pivot) i++;
+            while (pivot < a[j]) j--;
+            if (i >= j) break;
+            uint64_t t = a[i]; a[i] = a[j]; a[j] = t;
+            i++; j--;
+        }
+        if (j + 1 < n - j - 1) { small_sort_u64(a, j + 1); a += j + 1; n -= j + 1; }
+        else { small_sort_u64(a + j + 1, n - j - 1); n = j + 1; }
+    }
+    for (size_t i = 1; i < n; ++i) {
+        uint64_t v = a[i]; size_t k = i;
+        while (k > 0 && a[k - 1] > v) { a[k] = a[k - 1]; k--; }
+        a[k] = v;
+    }
+}
+
+// LSD radix sort of n 32-bit keys stored at `data`; `scratch` holds n keys.
+// Both buffers are accessed with memcpy so int and float storage can hold keys.
+static void radix_sort_32(void *data, void *scratch, size_t n) {
+    size_t counts[4][256];
+    memset(counts, 0, sizeof(counts));
+    unsigned char *src = data, *dst = scratch;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t k; memcpy(&k, src + i * 4, 4);
+        counts[0][k & 0xFF]++; counts[1][(k >> 8) & 0xFF]++;
+        counts[2][(k >> 16) & 0xFF]++; counts[3][k >> 24]++;
+    }
+    for (unsigned pass = 0; pass < 4; ++pass) {
+        size_t *count = counts[pass];
+        unsigned shift = pass * 8;
+        uint32_t first; memcpy(&first, src, 4);
+        if (count[(first >> shift) & 0xFF] == n) continue; // Every key has the same digit
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; ++d) { size_t c = count[d]; count[d] = offset; offset += c; }
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t k; memcpy(&k, src + i * 4, 4);
+            memcpy(dst + count[(k >> shift) & 0xFF]++ * 4, &k, 4);
+        }
+        unsigned char *t = src; src = dst; dst = t;
+    }
+    if (src != (unsigned char*)data) memcpy(data, src, n * 4);
+}
+
+static void radix_sort_64(void *data, void *scratch, size_t n) {
+    size_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    unsigned char *src = data, *dst = scratch;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t k; memcpy(&k, src + i * 8, 8);
+        for (unsigned pass = 0; pass < 8; ++pass) counts[pass][(k >> (pass * 8)) & 0xFF]++;
+    }
+    for (unsigned pass = 0; pass < 8; ++pass) {
+        size_t *count = counts[pass];
+        unsigned shift = pass * 8;
+        uint64_t first; memcpy(&first, src, 8);
+        if (count[(first >> shift) & 0xFF] == n) continue;
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; ++d) { size_t c = count[d]; count[d] = offset; offset += c; }
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t k; memcpy(&k, src + i * 8, 8);
+            memcpy(dst + count[(k >> shift) & 0xFF]++ * 8, &k, 8);
+        }
+        unsigned char *t = src; src = dst; dst = t;
+    }
+    if (src != (unsigned char*)data) memcpy(data, src, n * 8);
+}
+
+
+// --- String Sort Engine ---
+// sort_array_string moves NULLs to the front, then runs a multikey quicksort
+// (Bentley & Sedgewick) on (key, pointer) entries. key caches the next 8 bytes
+// of each string, big-endian and zero-padded past the terminator, so
+// partitioning compares integers in a contiguous array instead of chasing
+// pointers and re-reading shared prefixes. Only a run of equal keys that
+// has no terminator among its 8 bytes reloads its keys 8 bytes deeper.
+// Inputs up to STRING_SORT_STACK strings keep their entries on the stack.
+#define STRING_SORT_STACK 256
+#define STRING_SORT_PREFETCH 8 // Entries ahead when reloading keys
+
+typedef struct StringSortEntry {
+    uint64_t key; // 8 bytes of s starting at the current depth
+    string s;
+} StringSortEntry;
+
+static uint64_t string_prefix_key(const char *s) {
+    uint64_t key = 0;
+    if (s == NULL) return 0;
+    for (size_t i = 0; i < 8 && s[i] != '\0'; ++i) key |= (uint64_t)(unsigned char)s[i] << (56 - 8 * i);
+    return key;
+}
+
+// Order of two entries whose keys were loaded at `depth`.
+static inline int string_entry_compare(const StringSortEntry *a, const StringSortEntry *b, size_t depth) {
+    if (a->key != b->key) return (a->key < b->key) ? -1 : 1;
+    if ((a->key & 0xFF) == 0) return 0; // Both strings end inside these 8 bytes
+    return strcmp(a->s + depth + 8, b->s + depth + 8);
+}
+
+static void string_insertion_sort(StringSortEntry *a, size_t n, size_t depth) {
+    for (size_t i = 1; i < n; ++i) {
+        StringSortEntry x = a[i];
+        size_t j = i;
+        while (j > 0 && string_entry_compare(&x, &a[j - 1], depth) < 0) { a[j] = a[j - 1]; j--; }
+        a[j] = x;
+    }
+}
+
+// Three-way partition on the cached keys; the equal run goes 8 bytes deeper.
+// Recurses into the smaller outer side and loops on the larger.
+static void multikey_quicksort(StringSortEntry *a, size_t n, size_t depth) {
+    while (n > SMALL_SORT_INSERTION) {
+        uint64_t x = a[0].key, y = a[n / 2].key, z = a[n - 1].key;
+        uint64_t pivot = (x < y) ? ((y < z) ? y : (x < z ? z : x)) : ((x < z) ? x : (y < z ? z : y));
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            if (a[i].key < pivot) { StringSortEntry t = a[i]; a[i++] = a[lt]; a[lt++] = t; }
+            else if (a[i].key > pivot) { StringSortEntry t = a[i]; a[i] = a[--gt]; a[gt] = t; }
+            else i++;
+        }
+        if ((pivot & 0xFF) != 0 && gt - lt > 1) {
+            for (size_t k = lt; k < gt; ++k) {
+                if (k + STRING_SORT_PREFETCH < gt) AQ_PREFETCH(a[k + STRING_SORT_PREFETCH].s + depth + 8);
+                a[k].key = string_prefix_key(a[k].s + depth + 8);
+            }
+            multikey_quicksort(a + lt, gt - lt, depth + 8);
+        }
+        if (lt < n - gt) { multikey_quicksort(a, lt, depth); a += gt; n -= gt; }
+        else { multikey_quicksort(a + gt, n - gt, depth); n = lt; }
+    }
+    string_insertion_sort(a, n, depth);
+}
+
+
+// --- String Interning ---
+// An aq_intern pool keeps one copy of each distinct string (in its own arena,
+// indexed by the string hash table), so interned strings compare equal exactly
+// when their pointers do. The ID of a string is its entry number: IDs are dense
+// and assigned in interning order. by_address maps canonical pointers back to
+// IDs without reading the strings; it and the rank table are brought up to date
+// lazily, when an ID or a sort is asked for.
+struct aq_intern {
+    StringTable table;
+    aq_arena *keys;
+    uint64_t *by_address; // Same slot format as StringTable, keyed by pointer
+    size_t address_mask;
+    size_t addressed;     // Entries [0, addressed) are in by_address
+    uint32_t *ranks;      // ranks[id]: position of the string in sort_array_string order
+    size_t ranked;        // Number of entries ranks covers (stale when != table.count)
+};
+
+// splitmix64 finalizer of the address.
+static inline uint64_t address_hash(const void *p) {
+    uint64_t h = (uint64_t)(uintptr_t)p;
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+static void intern_address_add(aq_intern *pool, size_t id) {
+    uint64_t hash = address_hash(pool->table.entries[id].key);
+    size_t index = (size_t)hash & pool->address_mask;
+    while (pool->by_address[index] != 0) index = (index + 1) & pool->address_mask;
+    pool->by_address[index] = (hash & STRING_TABLE_TAG) | (uint64_t)(id + 1);
+}
+
+// Adds the entries interned since the last call; rebuilds at the string table's
+// capacity when that has grown. Returns false on allocation failure.
+static bool intern_sync_addresses(aq_intern *pool) {
+    if (pool->addressed == pool->table.count) return true;
+    if (pool->address_mask != pool->table.mask) {
+        uint64_t *slots = calloc(pool->table.mask + 1, sizeof(uint64_t));
+        if (slots == NULL) return false;
+        free(pool->by_address);
+        pool->by_address = slots;
+        pool->address_mask = pool->table.mask;
+        pool->addressed = 0;
+    }
+    for (; pool->addressed < pool->table.count; ++pool->addressed) intern_address_add(pool, pool->addressed);
+    return true;
+}
+
+// ID of a canonical pointer, or AQ_INTERN_NONE. by_address must be in sync.
+static size_t intern_address_find(const aq_intern *pool, const char *p) {
+    if (pool->by_address == NULL) return AQ_INTERN_NONE;
+    uint64_t hash = address_hash(p), tag = hash & STRING_TABLE_TAG;
+    size_t index = (size_t)hash & pool->address_mask;
+    for (uint64_t slot; (slot = pool->by_address[index]) != 0; index = (index + 1) & pool->address_mask) {
+        if ((slot & STRING_TABLE_TAG) == tag && pool->table.entries[(uint32_t)slot - 1].key == p) return (uint32_t)slot - 1;
+    }
+    return AQ_INTERN_NONE;
+}
+
+// Ranks every distinct string by sorting the canonical pointers once.
+static bool intern_rank(aq_intern *pool) {
+    size_t n = pool->table.count;
+    if (pool->ranked == n) return true;
+    if (!intern_sync_addresses(pool)) return false;
+    uint32_t *ranks = realloc(pool->ranks, (n ? n : 1) * sizeof(uint32_t));
+    string *sorted = malloc((n ? n : 1) * sizeof(string));
+    if (ranks == NULL || sorted == NULL) { if (ranks) pool->ranks = ranks; free(sorted); return false; }
+    pool->ranks = ranks;
+    for (size_t i = 0; i < n; ++i) sorted[i] = (string)pool->table.entries[i].key;
+    sort_array_string(sorted, n);
+    for (size_t r = 0; r < n; ++r) ranks[intern_address_find(pool, sorted[r])] = (uint32_t)r;
+    free(sorted);
+    pool->ranked = n;
+    return true;
+}
+
+// O(expected) time. expected is a sizing hint; the pool grows as needed. NULL on allocation failure.
+aq_intern* aq_intern_create(size_t expected) {
+    aq_intern *pool = calloc(1, sizeof(aq_intern));
+    if (pool == NULL) return NULL;
+    if (!string_container_init(&pool->table, &pool->keys, expected)) { free(pool); return NULL; }
+    return pool;
+}
+
+// Frees the pool and every canonical string it returned.
+void aq_intern_destroy(aq_intern *pool) {
+    if (pool == NULL) return;
+    st_destroy(&pool->table);
+    aq_arena_destroy(pool->keys);
+    free(pool->by_address);
+    free(pool->ranks);
+    free(pool);
+}
+
+// O(L) average time. The pool's copy of s, made on first sight. NULL for NULL or on allocation failure.
+string aq_intern_string(aq_intern *pool, const string s) {
+    if (s == NULL) return NULL;
+    return aq_intern_view(pool, (aq_strview){ s, strlen(s) });
+}
+
+string aq_intern_view(aq_intern *pool, aq_strview s) {
+    if (pool == NULL || (s.ptr == NULL && s.len > 0)) return NULL;
+    bool added;
+    StringEntry *e = st_insert(&pool->table, pool->keys, s.ptr ? s.ptr : "", s.len, hash_bytes(s.ptr, s.len), &added);
+    return (e == NULL) ? NULL : (string)e->key;
+}
+
+size_t aq_intern_size(const aq_intern *pool) {
+    return (pool == NULL) ? 0 : pool->table.count;
+}
+
+// O(1) average for canonical pointers, O(L) for other strings. AQ_INTERN_NONE if
+// no equal string has been interned (or s is NULL).
+size_t aq_intern_id(aq_intern *pool, const string s) {
+    if (pool == NULL || s == NULL) return AQ_INTERN_NONE;
+    if (intern_sync_addresses(pool)) {
+        size_t id = intern_address_find(pool, s);
+        if (id != AQ_INTERN_NONE) return id;
+    }
+    size_t len = strlen(s);
+    const StringEntry *e = st_find(&pool->table, s, len, hash_bytes(s, len));
+    return (e == NULL) ? AQ_INTERN_NONE : (size_t)(e - pool->table.entries);
+}
+
+// O(1). The canonical string with this ID, or NULL if there is none.
+string aq_intern_lookup(const aq_intern *pool, size_t id) {
+    if (pool == NULL || id >= pool->table.count) return NULL;
+    return (string)pool->table.entries[id].key;
+}
+
+// O(n * L) average time. Array of canonical pointers (NULL elements stay NULL):
+// repeated values share one copy. Free the array with free(), never free_string_array.
+string* aq_intern_copy_string_array(aq_intern *pool, const string *arr, size_t size) {
+    if (pool == NULL || arr == NULL || size == 0) return NULL;
+    string *copy = malloc(size * sizeof(string));
+    if (copy == NULL) return NULL;
+    if (!st_insert_all(&pool->table, pool->keys, arr, size, ST_CANONICAL, copy)) { free(copy); return NULL; }
+    return copy;
+}
+
+// Like array_concat_string, but the result holds canonical pointers. Free it with free().
+string* aq_intern_concat_string(aq_intern *pool, const string *arr1, size_t size1, const string *arr2, size_t size2, size_t *new_size) {
+    if (new_size == NULL) return NULL;
+    *new_size = 0;
+    if (pool == NULL || size1 + size2 == 0 || (arr1 == NULL && size1 > 0) || (arr2 == NULL && size2 > 0)) return NULL;
+    string *concat_arr = malloc((size1 + size2) * sizeof(string));
+    if (concat_arr == NULL) return NULL;
+    if (!st_insert_all(&pool->table, pool->keys, arr1, size1, ST_CANONICAL, concat_arr) ||
+        !st_insert_all(&pool->table, pool->keys, arr2, size2, ST_CANONICAL, concat_arr + size1)) { free(concat_arr); return NULL; }
+    *new_size = size1 + size2;
+    return concat_arr;
+}
+
+// Stable LSD radix sort of strings by their 32-bit ranks, 8 bits per pass and only
+// as many passes as max_rank has bytes. The result ends up in rank/s; the *_tmp
+// arrays are scratch of the same size.
+static void intern_radix_sort(uint32_t *rank, string *s, uint32_t *rank_tmp, string *s_tmp, size_t n, uint32_t max_rank) {
+    size_t counts[4][256];
+    unsigned passes = 1;
+    while (passes < 4 && (max_rank >> (passes * 8)) != 0) passes++;
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; ++i) {
+        for (unsigned pass = 0; pass < passes; ++pass) counts[pass][(rank[i] >> (pass * 8)) & 0xFF]++;
+    }
+    uint32_t *rank_src = rank, *rank_dst = rank_tmp;
+    string *s_src = s, *s_dst = s_tmp;
+    for (unsigned pass = 0; pass < passes; ++pass) {
+        size_t *count = counts[pass];
+        unsigned shift = pass * 8;
+        if (count[(rank_src[0] >> shift) & 0xFF] == n) continue; // Every rank has the same digit
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; ++d) { size_t c = count[d]; count[d] = offset; offset += c; }
+        for (size_t i = 0; i < n; ++i) {
+            size_t at = count[(rank_src[i] >> shift) & 0xFF]++;
+            rank_dst[at] = rank_src[i];
+            s_dst[at] = s_src[i];
+        }
+        uint32_t *rt = rank_src; rank_src = rank_dst; rank_dst = rt;
+        string *st = s_src; s_src = s_dst; s_dst = st;
+    }
+    if (s_src != s) memcpy(s, s_src, n * sizeof(string));
+}
+
+// Sorts like sort_array_string (NULLs first, then strcmp order; equal strings keep
+// their relative order) by radix sorting integer ranks instead of comparing
+// strings: O(n) once the pool's strings are ranked, which takes one string sort
+// of the distinct values after the pool has grown. Elements need not be canonical
+// pointers; if one is not in the pool at all, this falls back to sort_array_string.
+void aq_intern_sort(aq_intern *pool, string arr[], size_t size) {
+    if (arr == NULL || size < 2) return;
+    if (pool == NULL || size > UINT32_MAX || !intern_rank(pool)) { sort_array_string(arr, size); return; }
+    if (size <= RADIX_SORT_THRESHOLD) {
+        uint64_t keys[RADIX_SORT_THRESHOLD]; // (rank << 32) | position, so the sort is stable
+        string sorted[RADIX_SORT_THRESHOLD];
+        for (size_t i = 0; i < size; ++i) {
+            size_t id = (arr[i] == NULL) ? 0 : aq_intern_id(pool, arr[i]);
+            if (id == AQ_INTERN_NONE) { sort_array_string(arr, size); return; }
+            keys[i] = ((arr[i] == NULL) ? 0 : ((uint64_t)pool->ranks[id] + 1) << 32) | i;
+        }
+        small_sort_u64(keys, size);
+        for (size_t i = 0; i < size; ++i) sorted[i] = arr[(uint32_t)keys[i]];
+        memcpy(arr, sorted, size * sizeof(string));
+        return;
+    }
+    uint32_t *ranks = malloc(size * 2 * sizeof(uint32_t));
+    string *scratch = malloc(size * sizeof(string));
+    if (ranks == NULL || scratch == NULL) { free(ranks); free(scratch); sort_array_string(arr, size); return; }
     for (size_t i = 0; i < size; ++i) {
-        int current_val = arr[i];
-        long long needed1_ll = (long long)current_val - abs_target;
-        long long needed2_ll = (long long)current_val + abs_target;
+        if (arr[i] == NULL) { ranks[i] = 0; continue; }
+        size_t id = intern_address_find(pool, arr[i]);
+        if (id == AQ_INTERN_NONE) id = aq_intern_id(pool, arr[i]); // An equal but not canonical pointer
+        if (id == AQ_INTERN_NONE) { free(ranks); free(scratch); sort_array_string(arr, size); return; }
+        ranks[i] = pool->ranks[id] + 1;
+    }
+    intern_radix_sort(ranks, arr, ranks + size, scratch, size, (uint32_t)pool->table.count);
+    free(ranks);
+    free(scratch);
+}
 
-        if ((needed1_ll >= INT_MIN && needed1_ll <= INT_MAX && ht_contains_key(ht, (int)needed1_ll)) ||
-            (needed2_ll >= INT_MIN && needed2_ll <= INT_MAX && ht_contains_key(ht, (int)needed2_ll))) {
-             found = true;
-             break;
+
+// --- Selection ---
+// array_nth_*, array_median_*, array_percentiles_* and array_top_k_* copy the
+// elements into one scratch buffer of sort keys (same order as sort_array_*,
+// so NaNs sit at the ends) and run an introselect that serves several ranks
+// in one pass: Hoare partition around a median of three, descend only into
+// parts that still hold a wanted rank, heapsort once the depth limit is hit.
+
+static void heap_sort_u32(uint32_t *a, size_t n) {
+    for (size_t end = n, start = n / 2; end > 1;) {
+        if (start > 0) start--;            // Heapify phase
+        else { end--; uint32_t t = a[0]; a[0] = a[end]; a[end] = t; } // Pop max
+        size_t root = start;
+        for (size_t child; (child = 2 * root + 1) < end; root = child) {
+            if (child + 1 < end && a[child] < a[child + 1]) child++;
+            if (a[root] >= a[child]) break;
+            uint32_t t = a[root]; a[root] = a[child]; a[child] = t;
         }
-        ht_insert(ht, current_val);
     }
+}
 
-    ht_destroy(ht);
-    return found;
+static void heap_sort_u64(uint64_t *a, size_t n) {
+    for (size_t end = n, start = n / 2; end > 1;) {
+        if (start > 0) start--;
+        else { end--; uint64_t t = a[0]; a[0] = a[end]; a[end] = t; }
+        size_t root = start;
+        for (size_t child; (child = 2 * root + 1) < end; root = child) {
+            if (child + 1 < end && a[child] < a[child + 1]) child++;
+            if (a[root] >= a[child]) break;
+            uint64_t t = a[root]; a[root] = a[child]; a[child] = t;
+        }
+    }
+}
+
+// 2 * floor(log2(n)): partition rounds allowed before falling back to heapsort.
+static unsigned select_depth(size_t n) {
+    unsigned depth = 0;
+    while (n > 1) { n >>= 1; depth += 2; }
+    return depth;
+}
+
+// Afterwards a[r] is the element of rank r for every r in ranks[0..count)
+// (ascending, within [lo, hi)); smaller elements precede it and larger follow.
+// O(n) expected time for a few ranks.
+static void select_u32(uint32_t *a, size_t lo, size_t hi, const size_t *ranks, size_t count, unsigned depth) {
+    while (count > 0) {
+        uint32_t *b = a + lo;
+        size_t n = hi - lo;
+        if (n <= SMALL_SORT_INSERTION) { small_sort_u32(b, n); return; }
+        if (depth-- == 0) { heap_sort_u32(b, n); return; }
+        uint32_t x = b[0], y = b[n / 2], z = b[n - 1];
+        uint32_t pivot = (x < y) ? ((y < z) ? y : (x < z ? z : x)) : ((x < z) ? x : (y < z ? z : y));
+        size_t i = 0, j = n - 1;
+        for (;;) {
+            while (b[i] < pivot) i++;
+            while (pivot < b[j]) j--;
+            if (i >= j) break;
+            uint32_t t = b[i]; b[i] = b[j]; b[j] = t;
+            i++; j--;
+        }
+        size_t split = lo + j + 1, left = 0; // [lo, split) <= pivot <= [split, hi)
+        while (left < count && ranks[left] < split) left++;
+        if (left == count) { hi = split; continue; }
+        if (left > 0) select_u32(a, lo, split, ranks, left, depth);
+        ranks += left; count -= left; lo = split;
+    }
+}
+
+static void select_u64(uint64_t *a, size_t lo, size_t hi, const size_t *ranks, size_t count, unsigned depth) {
+    while (count > 0) {
+        uint64_t *b = a + lo;
+        size_t n = hi - lo;
+        if (n <= SMALL_SORT_INSERTION) { small_sort_u64(b, n); return; }
+        if (depth-- == 0) { heap_sort_u64(b, n); return; }
+        uint64_t x = b[0], y = b[n / 2], z = b[n - 1];
+        uint64_t pivot = (x < y) ? ((y < z) ? y : (x < z ? z : x)) : ((x < z) ? x : (y < z ? z : y));
+        size_t i = 0, j = n - 1;
+        for (;;) {
+            while (b[i] < pivot) i++;
+            while (pivot < b[j]) j--;
+            if (i >= j) break;
+            uint64_t t = b[i]; b[i] = b[j]; b[j] = t;
+            i++; j--;
+        }
+        size_t split = lo + j + 1, left = 0;
+        while (left < count && ranks[left] < split) left++;
+        if (left == count) { hi = split; continue; }
+        if (left > 0) select_u64(a, lo, split, ranks, left, depth);
+        ranks += left; count -= left; lo = split;
+    }
+}
+
+// Sorts the top k keys a[n - k .. n) ascending, using scratch (k keys) for large k.
+static void top_k_sort_u32(uint32_t *a, size_t n, size_t k, uint32_t *scratch) {
+    size_t first = n - k;
+    select_u32(a, 0, n, &first, 1, select_depth(n));
+    if (k <= RADIX_SORT_THRESHOLD) small_sort_u32(a + first, k);
+    else radix_sort_32(a + first, scratch, k);
+}
+
+static void top_k_sort_u64(uint64_t *a, size_t n, size_t k, uint64_t *scratch) {
+    size_t first = n - k;
+    select_u64(a, 0, n, &first, 1, select_depth(n));
+    if (k <= RADIX_SORT_THRESHOLD) small_sort_u64(a + first, k);
+    else radix_sort_64(a + first, scratch, k);
+}
+
+static int compare_size(const void *a, const void *b) {
+    size_t sa = *(const size_t*)a, sb = *(const size_t*)b;
+    return (sa > sb) - (sa < sb);
+}
+
+// Checks that every percent is in [0, 100] and writes the ranks that linear
+// interpolation needs (floor and ceil of p / 100 * (size - 1)) to ranks,
+// sorted and de-duplicated. ranks needs room for 2 * count entries.
+static bool percentile_ranks(size_t size, const double *percents, size_t count, size_t *ranks, size_t *num_ranks) {
+    size_t n = 0;
+    for (size_t q = 0; q < count; ++q) {
+        if (!(percents[q] >= 0.0 && percents[q] <= 100.0)) return false; // Also rejects NaN
+        double pos = percents[q] / 100.0 * (double)(size - 1);
+        size_t lo = (size_t)pos;
+        ranks[n++] = lo;
+        if (pos > (double)lo) ranks[n++] = lo + 1;
+    }
+    qsort(ranks, n, sizeof(size_t), compare_size);
+    size_t unique = 0;
+    for (size_t i = 0; i < n; ++i) if (unique == 0 || ranks[unique - 1] != ranks[i]) ranks[unique++] = ranks[i];
+    *num_ranks = unique;
+    return true;
+}
+
+// Value at fractional rank lo + frac, interpolating between the neighbours a and b.
+static double percentile_lerp(double a, double b, double frac) {
+    if (frac == 0.0 || a == b) return a;
+    double diff = b - a;
+    if (isfinite(diff)) return a + diff * frac;
+    return a * (1.0 - frac) + b * frac; // Avoids overflow for far-apart finite values
+}
+
+// O(n) expected time, O(n) extra space. result = element that would be at index n after sort_array.
+bool array_nth_int(const int *arr, size_t size, size_t n, int *result) {
+    if (arr == NULL || result == NULL || n >= size) return false;
+    uint32_t *keys = malloc(size * sizeof(uint32_t));
+    if (keys == NULL) return false;
+    for (size_t i = 0; i < size; ++i) keys[i] = int_to_key(arr[i]);
+    select_u32(keys, 0, size, &n, 1, select_depth(size));
+    *result = key_to_int(keys[n]);
+    free(keys);
+    return true;
+}
+
+// O(n + count log count) expected time, one allocation. results[q] = percents[q]-th percentile
+// (0..100, linear interpolation between closest ranks).
+bool array_percentiles_int(const int *arr, size_t size, const double *percents, size_t count, double *results) {
+    if (arr == NULL || size == 0 || percents == NULL || results == NULL) return false;
+    size_t *ranks = malloc(2 * count * sizeof(size_t) + size * sizeof(uint32_t));
+    if (ranks == NULL) return false;
+    uint32_t *keys = (uint32_t*)(ranks + 2 * count);
+    size_t num_ranks;
+    if (!percentile_ranks(size, percents, count, ranks, &num_ranks)) { free(ranks); return false; }
+    for (size_t i = 0; i < size; ++i) keys[i] = int_to_key(arr[i]);
+    select_u32(keys, 0, size, ranks, num_ranks, select_depth(size));
+    for (size_t q = 0; q < count; ++q) {
+        double pos = percents[q] / 100.0 * (double)(size - 1);
+        size_t lo = (size_t)pos, hi = (pos > (double)lo) ? lo + 1 : lo;
+        results[q] = percentile_lerp(key_to_int(keys[lo]), key_to_int(keys[hi]), pos - (double)lo);
+    }
+    free(ranks);
+    return true;
+}
+
+// O(n) expected time. Mean of the two middle elements for even sizes. NAN on error.
+double array_median_int(const int *arr, size_t size) {
+    double median;
+    return array_percentiles_int(arr, size, &(double){50.0}, 1, &median) ? median : NAN;
+}
+
+// O(n + k log k) expected time. Writes the k largest elements to out in descending order.
+bool array_top_k_int(const int *arr, size_t size, size_t k, int *out) {
+    if (arr == NULL || out == NULL || k > size) return false;
+    if (k == 0) return true;
+    uint32_t *keys = malloc((size + k) * sizeof(uint32_t));
+    if (keys == NULL) return false;
+    for (size_t i = 0; i < size; ++i) keys[i] = int_to_key(arr[i]);
+    top_k_sort_u32(keys, size, k, keys + size);
+    for (size_t i = 0; i < k; ++i) out[i] = key_to_int(keys[size - 1 - i]);
+    free(keys);
+    return true;
+}
+
+// O(n) expected time. Same order as sort_array_float.
+bool array_nth_float(const float *arr, size_t size, size_t n, float *result) {
+    if (arr == NULL || result == NULL || n >= size) return false;
+    uint32_t *keys = malloc(size * sizeof(uint32_t));
+    if (keys == NULL) return false;
+    for (size_t i = 0; i < size; ++i) keys[i] = float_to_key(arr[i]);
+    select_u32(keys, 0, size, &n, 1, select_depth(size));
+    *result = key_to_float(keys[n]);
+    free(keys);
+    return true;
+}
+
+// O(n + count log count) expected time, one allocation.
+bool array_percentiles_float(const float *arr, size_t size, const double *percents, size_t count, double *results) {
+    if (arr == NULL || size == 0 || percents == NULL || results == NULL) return false;
+    size_t *ranks = malloc(2 * count * sizeof(size_t) + size * sizeof(uint32_t));
+    if (ranks == NULL) return false;
+    uint32_t *keys = (uint32_t*)(ranks + 2 * count);
+    size_t num_ranks;
+    if (!percentile_ranks(size, percents, count, ranks, &num_ranks)) { free(ranks); return false; }
+    for (size_t i = 0; i < size; ++i) keys[i] = float_to_key(arr[i]);
+    select_u32(keys, 0, size, ranks, num_ranks, select_depth(size));
+    for (size_t q = 0; q < count; ++q) {
+        double pos = percents[q] / 100.0 * (double)(size - 1);
+        size_t lo = (size_t)pos, hi = (pos > (double)lo) ? lo + 1 : lo;
+        results[q] = percentile_lerp(key_to_float(keys[lo]), key_to_float(keys[hi]), pos - (double)lo);
+    }
+    free(ranks);
+    return true;
+}
+
+// O(n) expected time. NAN on error.
+double array_median_float(const float *arr, size_t size) {
+    double median;
+    return array_percentiles_float(arr, size, &(double){50.0}, 1, &median) ? median : NAN;
+}
+
+// O(n + k log k) expected time. k largest, descending.
+bool array_top_k_float(const float *arr, size_t size, size_t k, float *out) {
+    if (arr == NULL || out == NULL || k > size) return false;
+    if (k == 0) return true;
+    uint32_t *keys = malloc((size + k) * sizeof(uint32_t));
+    if (keys == NULL) return false;
+    for (size_t i = 0; i < size; ++i) keys[i] = float_to_key(arr[i]);
+    top_k_sort_u32(keys, size, k, keys + size);
+    for (size_t i = 0; i < k; ++i) out[i] = key_to_float(keys[size - 1 - i]);
+    free(keys);
+    return true;
+}
+
+// O(n) expected time. Same order as sort_array_double.
+bool array_nth_double(const double *arr, size_t size, size_t n, double *result) {
+    if (arr == NULL || result == NULL || n >= size) return false;
+    uint64_t *keys = malloc(size * sizeof(uint64_t));
+    if (keys == NULL) return false;
+    for (size_t i = 0; i < size; ++i) keys[i] = double_to_key(arr[i]);
+    select_u64(keys, 0, size, &n, 1, select_depth(size));
+    *result = key_to_double(keys[n]);
+    free(keys);
+    return true;
+}
+
+// O(n + count log count) expected time, one allocation.
+bool array_percentiles_double(const double *arr, size_t size, const double *percents, size_t count, double *results) {
+    if (arr == NULL || size == 0 || percents == NULL || results == NULL) return false;
+    size_t *ranks = malloc(2 * count * sizeof(size_t) + size * sizeof(uint64_t));
+    if (ranks == NULL) return false;
+    uint64_t *keys = (uint64_t*)(ranks + 2 * count);
+    size_t num_ranks;
+    if (!percentile_ranks(size, percents, count, ranks, &num_ranks)) { free(ranks); return false; }
+    for (size_t i = 0; i < size; ++i) keys[i] = double_to_key(arr[i]);
+    select_u64(keys, 0, size, ranks, num_ranks, select_depth(size));
+    for (size_t q = 0; q < count; ++q) {
+        double pos = percents[q] / 100.0 * (double)(size - 1);
+        size_t lo = (size_t)pos, hi = (pos > (double)lo) ? lo + 1 : lo;
+        results[q] = percentile_lerp(key_to_double(keys[lo]), key_to_double(keys[hi]), pos - (double)lo);
+    }
+    free(ranks);
+    return true;
+}
+
+// O(n) expected time. NAN on error.
+double array_median_double(const double *arr, size_t size) {
+    double median;
+    return array_percentiles_double(arr, size, &(double){50.0}, 1, &median) ? median : NAN;
+}
+
+// O(n + k log k) expected time. k largest, descending.
+bool array_top_k_double(const double *arr, size_t size, size_t k, double *out) {
+    if (arr == NULL || out == NULL || k > size) return false;
+    if (k == 0) return true;
+    uint64_t *keys = malloc((size + k) * sizeof(uint64_t));
+    if (keys == NULL) return false;
+    for (size_t i = 0; i < size; ++i) keys[i] = double_to_key(arr[i]);
+    top_k_sort_u64(keys, size, k, keys + size);
+    for (size_t i = 0; i < k; ++i) out[i] = key_to_double(keys[size - 1 - i]);
+    free(keys);
+    return true;
 }
 
 
 // --- Sort and Print ---
-// ... (compare_int, sort_array, print_array - unchanged) ...
 static int compare_int(const void *a, const void *b) {
-    return (*(const int*)a - *(const int*)b);
+    int ia = *(const int*)a; int ib = *(const int*)b;
+    return (ia > ib) - (ia < ib); // Subtraction overflows near INT_MIN/INT_MAX
 }
 
-// O(n log n) time complexity
+// O(n) time (radix), O(n) extra space. Falls back to qsort if the scratch buffer cannot be allocated.
 void sort_array(int arr[], size_t size) {
     if (arr == NULL || size < 2) return;
-    qsort(arr, size, sizeof(int), compare_int);
+    if (size <= RADIX_SORT_THRESHOLD) {
+        uint32_t keys[RADIX_SORT_THRESHOLD];
+        for (size_t i = 0; i < size; ++i) keys[i] = int_to_key(arr[i]);
+        small_sort_u32(keys, size);
+        for (size_t i = 0; i < size; ++i) arr[i] = key_to_int(keys[i]);
+        return;
+    }
+    uint32_t *scratch = malloc(size * sizeof(uint32_t));
+    if (scratch == NULL) { qsort(arr, size, sizeof(int), compare_int); return; }
+    for (size_t i = 0; i < size; ++i) { uint32_t k = int_to_key(arr[i]); memcpy(&arr[i], &k, 4); }
+    radix_sort_32(arr, scratch, size);
+    for (size_t i = 0; i < size; ++i) { uint32_t k; memcpy(&k, &arr[i], 4); arr[i] = key_to_int(k); }
+    free(scratch);
 }
 
 void print_array(const int arr[], size_t size) {
@@ -512,6 +4542,341 @@ void print_array(const int arr[], size_t size) {
 }
 
 
+// --- Arena Allocator ---
+// Bump allocator for the string_*_a functions. Blocks are kept on reset and reused,
+// so a request-scoped arena stops calling malloc once it has warmed up.
+#define ARENA_DEFAULT_BLOCK_SIZE ((size_t)64 * 1024)
+#define ARENA_ALIGN AQ_ARENA_ALIGN
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;       // Usable bytes in data
+    aq_max_align data[]; // Aligned for any object type
+} ArenaBlock;
+
+struct aq_arena {
+    ArenaBlock *first;   // All blocks, in the order they are used
+    ArenaBlock *current; // Block being bumped into (NULL before the first allocation)
+    size_t used;         // Bytes used in current
+    size_t block_size;
+};
+
+// O(1) time. block_size 0 selects the 64 KiB default.
+aq_arena* aq_arena_create(size_t block_size) {
+    aq_arena *arena = malloc(sizeof(aq_arena));
+    if (arena == NULL) return NULL;
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->used = 0;
+    arena->block_size = (block_size == 0) ? ARENA_DEFAULT_BLOCK_SIZE : block_size;
+    return arena;
+}
+
+// O(blocks) time. Releases every allocation made from the arena.
+void aq_arena_destroy(aq_arena *arena) {
+    if (arena == NULL) return;
+    ArenaBlock *block = arena->first;
+    while (block != NULL) { ArenaBlock *next = block->next; free(block); block = next; }
+    free(arena);
+}
+
+// O(1) time. Invalidates every allocation; blocks are kept for reuse.
+void aq_arena_reset(aq_arena *arena) {
+    if (arena == NULL) return;
+    arena->current = NULL;
+    arena->used = 0;
+}
+
+// O(1) amortized. Aligned like malloc; NULL on overflow or allocation failure.
+void* aq_arena_alloc(aq_arena *arena, size_t size) {
+    if (arena == NULL) return NULL;
+    size_t rounded = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (rounded < size) return NULL; // Overflow
+    if (rounded == 0) rounded = ARENA_ALIGN; // Distinct pointers for zero-size requests
+    ArenaBlock *block = arena->current;
+    if (block != NULL && block->size - arena->used >= rounded) {
+        void *p = (char*)block->data + arena->used;
+        arena->used += rounded;
+        return p;
+    }
+    // Move to the next kept block that fits; blocks skipped here come back on reset
+    block = (block != NULL) ? block->next : arena->first;
+    while (block != NULL && block->size < rounded) block = block->next;
+    if (block == NULL) {
+        size_t capacity = (rounded > arena->block_size) ? rounded : arena->block_size;
+        if (capacity > SIZE_MAX - sizeof(ArenaBlock)) return NULL;
+        block = malloc(sizeof(ArenaBlock) + capacity);
+        if (block == NULL) return NULL;
+        block->size = capacity;
+        if (arena->current != NULL) { block->next = arena->current->next; arena->current->next = block; }
+        else { block->next = arena->first; arena->first = block; }
+    }
+    arena->current = block;
+    arena->used = rounded;
+    return block->data;
+}
+
+// Allocation used by the string functions: the arena when given, malloc otherwise.
+static inline void* str_alloc(aq_arena *arena, size_t size) {
+    return (arena != NULL) ? aq_arena_alloc(arena, size) : malloc(size);
+}
+
+// Length-based cores shared by the string_* and aq_str_* functions. The input
+// bytes need not be null-terminated; results always are.
+static string copy_bytes(aq_arena *arena, const char *s, size_t len) {
+    string copy = str_alloc(arena, len + 1);
+    if (copy == NULL) return NULL;
+    if (len > 0) memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+// isspace without the locale call for ASCII bytes.
+static inline bool space_byte(unsigned char c) {
+    return (ascii_class[c] & ASCII_SPACE) || ((ascii_class[c] & ASCII_HIGH) && isspace(c));
+}
+
+// Trimmed length of s[0..len); *start receives the offset of the first non-space byte.
+static size_t trim_bounds(const char *s, size_t len, size_t *start) {
+    size_t lo = 0, hi = len;
+    while (lo < hi && space_byte((unsigned char)s[lo])) lo++;
+    while (hi > lo && space_byte((unsigned char)s[hi - 1])) hi--;
+    *start = lo;
+    return hi - lo;
+}
+
+// true when s is non-empty and every byte is in classes (ASCII fast path) or, for bytes >= 0x80, passes is_class.
+// The first bytes are checked one at a time, so strings that fail early are not measured with strlen.
+#define CLASS_SCALAR_PREFIX 64
+static bool all_bytes_in_class(const char *s, unsigned classes, int (*is_class)(int)) {
+    if (s == NULL || *s == '\0') return false;
+    size_t i = 0;
+    for (; i < CLASS_SCALAR_PREFIX; ++i) {
+        unsigned char c = (unsigned char)s[i];
+        if (ascii_class[c] & classes) continue;
+        if (c == '\0') return true;
+        if (!(ascii_class[c] & ASCII_HIGH) || !is_class(c)) return false;
+    }
+    size_t len = i + strlen(s + i);
+    for (;;) {
+        i += aq_string_kernels.class_span(s + i, len - i, classes);
+        if (i == len) return true;
+        unsigned char c = (unsigned char)s[i];
+        if (c < 0x80 || !is_class(c)) return false;
+        i++;
+    }
+}
+
+static string case_bytes(aq_arena *arena, const char *s, size_t len, bool upper) {
+    string new_s = str_alloc(arena, len + 1);
+    if (new_s == NULL) return NULL;
+    convert_case(new_s, s, len, upper);
+    new_s[len] = '\0';
+    return new_s;
+}
+
+// Replaces every non-overlapping from (from_len >= 1) in s[0..len) with to.
+// The counting pass remembers the first REPLACE_STACK_HITS match offsets, so
+// the fill pass only searches again past them; the output is sized exactly and
+// allocated once. *out_len receives the result length.
+#define REPLACE_STACK_HITS 64
+static string replace_bytes(aq_arena *arena, const char *s, size_t len, const char *from, size_t from_len, const char *to, size_t to_len, size_t *out_len) {
+    size_t hits[REPLACE_STACK_HITS], count = 0;
+    const char *end = s + len, *p = s, *hit;
+    while ((hit = find_bytes(p, end, from, from_len)) != NULL) {
+        if (count < REPLACE_STACK_HITS) hits[count] = (size_t)(hit - s);
+        count++;
+        p = hit + from_len;
+    }
+    if (count == 0) { *out_len = len; return copy_bytes(arena, s, len); }
+    size_t result_len;
+    if (to_len >= from_len) {
+        if (to_len - from_len > (SIZE_MAX - len - 1) / count) return NULL; // Result too large
+        result_len = len + count * (to_len - from_len);
+    } else {
+        result_len = len - count * (from_len - to_len);
+    }
+    string out = str_alloc(arena, result_len + 1);
+    if (out == NULL) return NULL;
+    char *w = out;
+    p = s;
+    for (size_t k = 0; k < count; ++k) {
+        hit = (k < REPLACE_STACK_HITS) ? s + hits[k] : find_bytes(p, end, from, from_len);
+        memcpy(w, p, (size_t)(hit - p)); w += hit - p;
+        if (to_len > 0) { memcpy(w, to, to_len); w += to_len; }
+        p = hit + from_len;
+    }
+    memcpy(w, p, (size_t)(end - p)); w += end - p;
+    *w = '\0';
+    *out_len = result_len;
+    return out;
+}
+
+
+// --- String Builder ---
+// aq_strbuf appends into one buffer that doubles when full, so building a
+// string of n bytes copies O(n) bytes in total. A builder set up with
+// aq_strbuf_init_a grows inside an arena instead (old buffers stay in the
+// arena until it is reset). data is null-terminated whenever cap > 0.
+#define STRBUF_MIN_CAPACITY 32
+
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// O(1) time. No allocation until the first append.
+void aq_strbuf_init(aq_strbuf *sb) {
+    aq_strbuf_init_a(sb, NULL);
+}
+
+// O(1) time. Buffers come from arena (malloc when arena is NULL).
+void aq_strbuf_init_a(aq_strbuf *sb, aq_arena *arena) {
+    if (sb == NULL) return;
+    sb->data = NULL; sb->len = 0; sb->cap = 0; sb->arena = arena;
+}
+
+// Grows to hold needed bytes (terminator included); exact when asked for, else geometric.
+static bool strbuf_grow(aq_strbuf *sb, size_t needed, bool exact) {
+    size_t new_cap = needed;
+    if (!exact) {
+        if (new_cap < STRBUF_MIN_CAPACITY) new_cap = STRBUF_MIN_CAPACITY;
+        if (sb->cap <= SIZE_MAX / 2 && new_cap < sb->cap * 2) new_cap = sb->cap * 2;
+    }
+    char *data;
+    if (sb->arena != NULL) {
+        data = aq_arena_alloc(sb->arena, new_cap);
+        if (data != NULL && sb->cap > 0) memcpy(data, sb->data, sb->len + 1);
+    } else {
+        data = realloc(sb->data, new_cap);
+    }
+    if (data == NULL) return false;
+    if (sb->cap == 0) data[0] = '\0';
+    sb->data = data; sb->cap = new_cap;
+    return true;
+}
+
+// Makes room for `additional` more bytes plus the terminator.
+static inline bool strbuf_room(aq_strbuf *sb, size_t additional, bool exact) {
+    if (additional > SIZE_MAX - 1 - sb->len) return false; // Length overflow
+    size_t needed = sb->len + additional + 1;
+    return needed <= sb->cap || strbuf_grow(sb, needed, exact);
+}
+
+// O(L) time. Ensures `additional` bytes can be appended without reallocating.
+bool aq_strbuf_reserve(aq_strbuf *sb, size_t additional) {
+    if (sb == NULL) return false;
+    return strbuf_room(sb, additional, true);
+}
+
+// O(L) amortized. On failure the buffer is unchanged and false is returned.
+bool aq_strbuf_append(aq_strbuf *sb, const char *data, size_t len) {
+    if (sb == NULL || (data == NULL && len > 0)) return false;
+    if (!strbuf_room(sb, len, false)) return false;
+    if (len > 0) memcpy(sb->data + sb->len, data, len);
+    sb->len += len;
+    sb->data[sb->len] = '\0';
+    return true;
+}
+
+// O(L) amortized. A NULL string appends nothing.
+bool aq_strbuf_append_string(aq_strbuf *sb, const string s) {
+    return aq_strbuf_append(sb, s, (s == NULL) ? 0 : strlen(s));
+}
+
+// O(L) amortized; uses the cached length.
+bool aq_strbuf_append_str(aq_strbuf *sb, aq_str s) {
+    return aq_strbuf_append(sb, s.ptr, s.len);
+}
+
+// O(1) amortized.
+bool aq_strbuf_append_char(aq_strbuf *sb, char c) {
+    if (sb == NULL || !strbuf_room(sb, 1, false)) return false;
+    sb->data[sb->len++] = c;
+    sb->data[sb->len] = '\0';
+    return true;
+}
+
+// O(digits) time. Two digits per step from a lookup table.
+bool aq_strbuf_append_int(aq_strbuf *sb, long long value) {
+    char digits[20];
+    char *p = digits + sizeof(digits);
+    unsigned long long v = (value < 0) ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    while (v >= 100) {
+        unsigned pair = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--p = digit_pairs[pair + 1]; *--p = digit_pairs[pair];
+    }
+    if (v >= 10) { *--p = digit_pairs[v * 2 + 1]; *--p = digit_pairs[v * 2]; }
+    else *--p = (char)('0' + v);
+    if (sb == NULL || !strbuf_room(sb, (size_t)(digits + sizeof(digits) - p) + 1, false)) return false;
+    if (value < 0) sb->data[sb->len++] = '-';
+    return aq_strbuf_append(sb, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+// Shortest of %.15g, %.16g and %.17g that reads back as the same double.
+// Whole numbers below 1e15 skip printf (same text as %.15g).
+bool aq_strbuf_append_double(aq_strbuf *sb, double value) {
+    if (value == trunc(value) && fabs(value) < 1e15 && !(value == 0.0 && signbit(value))) {
+        return aq_strbuf_append_int(sb, (long long)value);
+    }
+    char text[32];
+    int n = snprintf(text, sizeof(text), "%.15g", value);
+    if (isfinite(value)) {
+        for (int precision = 16; precision <= 17; ++precision) {
+            double back;
+            bool range_error;
+            const char *end = parse_double_prefix(text, text + n, &back, &range_error);
+            if (end == text + n && back == value) break;
+            n = snprintf(text, sizeof(text), "%.*g", precision, value);
+        }
+    }
+    return n > 0 && aq_strbuf_append(sb, text, (size_t)n);
+}
+
+// O(1) time. Keeps the capacity.
+void aq_strbuf_clear(aq_strbuf *sb) {
+    if (sb == NULL) return;
+    sb->len = 0;
+    if (sb->cap > 0) sb->data[0] = '\0';
+}
+
+// O(1) time. Caller must free (unless the builder uses an arena); the builder is reset.
+string aq_strbuf_release(aq_strbuf *sb) {
+    if (sb == NULL) return NULL;
+    if (sb->cap == 0 && !strbuf_grow(sb, 1, true)) return NULL; // Empty result is still a string
+    string result = sb->data;
+    sb->data = NULL; sb->len = 0; sb->cap = 0;
+    return result;
+}
+
+// O(1) time. Like aq_strbuf_release, keeping the length and capacity (arena results are borrowed, cap 0).
+aq_str aq_strbuf_release_str(aq_strbuf *sb) {
+    aq_str result = { NULL, 0, 0 };
+    if (sb == NULL) return result;
+    size_t len = sb->len, cap = sb->cap;
+    result.ptr = aq_strbuf_release(sb);
+    if (result.ptr != NULL) { result.len = len; result.cap = (sb->arena != NULL) ? 0 : (cap > 0) ? cap : 1; }
+    return result;
+}
+
+// O(1) time. Frees the buffer (arena buffers are left to the arena); the builder is reset.
+void aq_strbuf_free(aq_strbuf *sb) {
+    if (sb == NULL) return;
+    if (sb->arena == NULL) free(sb->data);
+    sb->data = NULL; sb->len = 0; sb->cap = 0;
+}
+
+static string concat_bytes(aq_arena *arena, const char *s1, size_t len1, const char *s2, size_t len2) {
+    aq_strbuf sb;
+    aq_strbuf_init_a(&sb, arena);
+    if (len1 > SIZE_MAX - len2 || !aq_strbuf_reserve(&sb, len1 + len2)) return NULL; // Exact size
+    aq_strbuf_append(&sb, s1, len1);
+    aq_strbuf_append(&sb, s2, len2);
+    return aq_strbuf_release(&sb);
+}
+
+
 // --- Original String Functions ---
 // ... (find_string, string_copy, string_equals, string_trim, string_is_int, free_string_array - unchanged) ...
 int find_string(const string names[], size_t size, const string target_name) {
@@ -524,12 +4889,13 @@ int find_string(const string names[], size_t size, const string target_name) {
 
 // O(L) time. Caller must free.
 string string_copy(const string s) {
+    return string_copy_a(NULL, s);
+}
+
+// O(L) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_copy_a(aq_arena *arena, const string s) {
     if (s == NULL) return NULL;
-    size_t len = strlen(s);
-    string copy = malloc(len + 1);
-    if (copy == NULL) return NULL;
-    memcpy(copy, s, len + 1);
-    return copy;
+    return copy_bytes(arena, s, strlen(s));
 }
 
 // O(L) time.
@@ -541,29 +4907,36 @@ bool string_equals(const string s1, const string s2) {
 
 // O(L) time. Caller must free.
 string string_trim(const string s) {
+    return string_trim_a(NULL, s);
+}
+
+// O(L) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_trim_a(aq_arena *arena, const string s) {
     if (s == NULL) return NULL;
-    const char *start = s;
-    while (*start != '\0' && isspace((unsigned char)*start)) start++;
-    if (*start == '\0') { string empty_s = malloc(1); if(empty_s) *empty_s = '\0'; return empty_s;}
-    const char *end = s + strlen(s) - 1;
-    while (end > start && isspace((unsigned char)*end)) end--;
-    size_t trimmed_len = end - start + 1;
-    string trimmed_s = malloc(trimmed_len + 1);
-    if (trimmed_s == NULL) return NULL;
-    memcpy(trimmed_s, start, trimmed_len);
-    trimmed_s[trimmed_len] = '\0';
-    return trimmed_s;
+    size_t start;
+    size_t trimmed_len = trim_bounds(s, strlen(s), &start);
+    return copy_bytes(arena, s + start, trimmed_len);
+}
+
+// O(L) time, no allocation. Shifts the trimmed text to the front of s; returns its length.
+size_t string_trim_in_place(string s) {
+    if (s == NULL) return 0;
+    size_t start;
+    size_t trimmed_len = trim_bounds(s, strlen(s), &start);
+    if (start > 0) memmove(s, s + start, trimmed_len);
+    s[trimmed_len] = '\0';
+    return trimmed_len;
 }
 
 // O(L) time.
 bool string_is_int(const string s) {
     if (s == NULL || *s == '\0') return false;
-    char *endptr;
-    errno = 0;
-    (void)strtol(s, &endptr, 10);
-    if (endptr == s) return false; // No digits found
-    while (isspace((unsigned char)*endptr)) endptr++;
-    return *endptr == '\0'; // Only whitespace or null remaining
+    const char *end = s + strlen(s);
+    long value;
+    bool range_error; // Ignored: any digit string counts, as before
+    const char *p = parse_integer_prefix(s, end, LONG_MIN, LONG_MAX, &value, &range_error);
+    if (p == s) return false; // No digits found
+    return parse_at_end(p, end); // Only whitespace or null remaining
 }
 
 // O(n * L) time (deep free). Caller must free array AND strings.
@@ -582,23 +4955,22 @@ void free_string_array(string *arr, size_t size) {
 // ... (all float array functions - unchanged) ...
 bool array_max_float(const float *arr, size_t size, float *max_val) {
     if (arr == NULL || size == 0 || max_val == NULL) return false;
-    *max_val = arr[0];
-    for (size_t i = 1; i < size; ++i) if (arr[i] > *max_val) *max_val = arr[i];
+    float min_unused;
+    aq_kernels.minmax_float(arr, size, &min_unused, max_val);
     return true;
 }
 
 bool array_min_float(const float *arr, size_t size, float *min_val) {
     if (arr == NULL || size == 0 || min_val == NULL) return false;
-    *min_val = arr[0];
-    for (size_t i = 1; i < size; ++i) if (arr[i] < *min_val) *min_val = arr[i];
+    float max_unused;
+    aq_kernels.minmax_float(arr, size, min_val, &max_unused);
     return true;
 }
 
 bool array_sum_float(const float *arr, size_t size, double *sum) {
     if (sum == NULL) return false;
     if (arr == NULL || size == 0) { *sum = 0.0; return true; }
-    *sum = 0.0;
-    for (size_t i = 0; i < size; ++i) *sum += arr[i];
+    *sum = aq_kernels.sum_float(arr, size);
     return true;
 }
 
@@ -609,36 +4981,78 @@ double array_average_float(const float *arr, size_t size) {
     return sum / size;
 }
 
+// O(n) time, one pass over memory. Population variance. NaN handling for
+// min/max matches array_min_float/array_max_float; a NaN makes sum/mean/variance NaN.
+bool array_stats_float(const float *arr, size_t size, aq_stats *stats) {
+    if (arr == NULL || size == 0 || stats == NULL) return false;
+    float lo = arr[0], hi = arr[0];
+    size_t argmin = 0, argmax = 0, count = 0;
+    double total = 0.0, mean = 0.0, m2 = 0.0;
+    for (size_t start = 0; start < size; start += STATS_BLOCK_SIZE) {
+        const float *block = arr + start;
+        size_t len = (size - start < STATS_BLOCK_SIZE) ? size - start : STATS_BLOCK_SIZE;
+        size_t skip = 0; // The kernel lets a leading NaN win; only arr[0] may do that.
+        if (start > 0) while (skip < len && isnan(block[skip])) skip++;
+        if (skip < len) {
+            float block_lo, block_hi;
+            aq_kernels.minmax_float(block + skip, len - skip, &block_lo, &block_hi);
+            if (block_lo < lo) { lo = block_lo; argmin = start + skip; while (arr[argmin] != lo) argmin++; }
+            if (block_hi > hi) { hi = block_hi; argmax = start + skip; while (arr[argmax] != hi) argmax++; }
+        }
+        double block_sum = aq_kernels.sum_float(block, len);
+        double block_mean = block_sum / len;
+        total += block_sum;
+        stats_merge_block(&count, &mean, &m2, len, block_mean, aq_kernels.sqdev_float(block, len, block_mean));
+    }
+    stats->count = size;
+    stats->min = lo; stats->max = hi;
+    stats->argmin = argmin; stats->argmax = argmax;
+    stats->sum = total;
+    stats->mean = total / size;
+    stats->variance = m2 / size;
+    return true;
+}
+
+// Same total order as the radix keys, so both sort paths agree on -0.0 and NaN.
 static int compare_float(const void *a, const void *b) {
-    float fa = *(const float*)a; float fb = *(const float*)b;
-    if (fa < fb) return -1; if (fa > fb) return 1; return 0;
+    uint32_t ka = float_to_key(*(const float*)a); uint32_t kb = float_to_key(*(const float*)b);
+    return (ka > kb) - (ka < kb);
 }
-// O(n log n) time
+// O(n) time (radix), O(n) extra space. NaNs go to the ends (see Sort Engine).
 void sort_array_float(float arr[], size_t size) {
     if (arr == NULL || size < 2) return;
-    qsort(arr, size, sizeof(float), compare_float);
+    if (size <= RADIX_SORT_THRESHOLD) {
+        uint32_t keys[RADIX_SORT_THRESHOLD];
+        for (size_t i = 0; i < size; ++i) keys[i] = float_to_key(arr[i]);
+        small_sort_u32(keys, size);
+        for (size_t i = 0; i < size; ++i) arr[i] = key_to_float(keys[i]);
+        return;
+    }
+    uint32_t *scratch = malloc(size * sizeof(uint32_t));
+    if (scratch == NULL) { qsort(arr, size, sizeof(float), compare_float); return; }
+    for (size_t i = 0; i < size; ++i) { uint32_t k = float_to_key(arr[i]); memcpy(&arr[i], &k, 4); }
+    radix_sort_32(arr, scratch, size);
+    for (size_t i = 0; i < size; ++i) { uint32_t k; memcpy(&k, &arr[i], 4); arr[i] = key_to_float(k); }
+    free(scratch);
 }
 
 // Uses FLOAT_EPSILON
 bool array_contains_float(const float *arr, size_t size, float value) {
     if (arr == NULL || size == 0) return false;
-    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < FLOAT_EPSILON) return true;
-    return false;
+    return aq_search.find_float(arr, size, value) < size;
 }
 
 // Uses FLOAT_EPSILON. Returns -1 or index (if fits int).
 int array_index_of_float(const float *arr, size_t size, float value) {
     if (arr == NULL || size == 0) return -1;
-    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < FLOAT_EPSILON) return (i > INT_MAX) ? -1 : (int)i;
-    return -1;
+    size_t i = aq_search.find_float(arr, size, value);
+    return (i >= size || i > INT_MAX) ? -1 : (int)i;
 }
 
 // Uses FLOAT_EPSILON
 size_t array_count_occurrence_float(const float *arr, size_t size, float value) {
     if (arr == NULL || size == 0) return 0;
-    size_t count = 0;
-    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < FLOAT_EPSILON) count++;
-    return count;
+    return aq_search.count_float(arr, size, value);
 }
 
 // Caller must free.
@@ -655,23 +5069,22 @@ float* array_copy_float(const float *arr, size_t size) {
 // ... (all double array functions - unchanged) ...
 bool array_max_double(const double *arr, size_t size, double *max_val) {
     if (arr == NULL || size == 0 || max_val == NULL) return false;
-    *max_val = arr[0];
-    for (size_t i = 1; i < size; ++i) if (arr[i] > *max_val) *max_val = arr[i];
+    double min_unused;
+    aq_kernels.minmax_double(arr, size, &min_unused, max_val);
     return true;
 }
 
 bool array_min_double(const double *arr, size_t size, double *min_val) {
     if (arr == NULL || size == 0 || min_val == NULL) return false;
-    *min_val = arr[0];
-    for (size_t i = 1; i < size; ++i) if (arr[i] < *min_val) *min_val = arr[i];
+    double max_unused;
+    aq_kernels.minmax_double(arr, size, min_val, &max_unused);
     return true;
 }
 
 bool array_sum_double(const double *arr, size_t size, double *sum) {
     if (sum == NULL) return false;
     if (arr == NULL || size == 0) { *sum = 0.0; return true; }
-    *sum = 0.0;
-    for (size_t i = 0; i < size; ++i) *sum += arr[i];
+    *sum = aq_kernels.sum_double(arr, size);
     return true;
 }
 
@@ -682,36 +5095,77 @@ double array_average_double(const double *arr, size_t size) {
     return sum / size;
 }
 
+// O(n) time, one pass over memory. Population variance. NaN handling for
+// min/max matches array_min_double/array_max_double; a NaN makes sum/mean/variance NaN.
+bool array_stats_double(const double *arr, size_t size, aq_stats *stats) {
+    if (arr == NULL || size == 0 || stats == NULL) return false;
+    double lo = arr[0], hi = arr[0];
+    size_t argmin = 0, argmax = 0, count = 0;
+    double total = 0.0, mean = 0.0, m2 = 0.0;
+    for (size_t start = 0; start < size; start += STATS_BLOCK_SIZE) {
+        const double *block = arr + start;
+        size_t len = (size - start < STATS_BLOCK_SIZE) ? size - start : STATS_BLOCK_SIZE;
+        size_t skip = 0; // The kernel lets a leading NaN win; only arr[0] may do that.
+        if (start > 0) while (skip < len && isnan(block[skip])) skip++;
+        if (skip < len) {
+            double block_lo, block_hi;
+            aq_kernels.minmax_double(block + skip, len - skip, &block_lo, &block_hi);
+            if (block_lo < lo) { lo = block_lo; argmin = start + skip; while (arr[argmin] != lo) argmin++; }
+            if (block_hi > hi) { hi = block_hi; argmax = start + skip; while (arr[argmax] != hi) argmax++; }
+        }
+        double block_sum = aq_kernels.sum_double(block, len);
+        double block_mean = block_sum / len;
+        total += block_sum;
+        stats_merge_block(&count, &mean, &m2, len, block_mean, aq_kernels.sqdev_double(block, len, block_mean));
+    }
+    stats->count = size;
+    stats->min = lo; stats->max = hi;
+    stats->argmin = argmin; stats->argmax = argmax;
+    stats->sum = total;
+    stats->mean = total / size;
+    stats->variance = m2 / size;
+    return true;
+}
+
 static int compare_double(const void *a, const void *b) {
-    double da = *(const double*)a; double db = *(const double*)b;
-    if (da < db) return -1; if (da > db) return 1; return 0;
+    uint64_t ka = double_to_key(*(const double*)a); uint64_t kb = double_to_key(*(const double*)b);
+    return (ka > kb) - (ka < kb);
 }
-// O(n log n) time
+// O(n) time (radix), O(n) extra space. NaNs go to the ends (see Sort Engine).
 void sort_array_double(double arr[], size_t size) {
-     if (arr == NULL || size < 2) return;
-    qsort(arr, size, sizeof(double), compare_double);
+    if (arr == NULL || size < 2) return;
+    if (size <= RADIX_SORT_THRESHOLD) {
+        uint64_t keys[RADIX_SORT_THRESHOLD];
+        for (size_t i = 0; i < size; ++i) keys[i] = double_to_key(arr[i]);
+        small_sort_u64(keys, size);
+        for (size_t i = 0; i < size; ++i) arr[i] = key_to_double(keys[i]);
+        return;
+    }
+    uint64_t *scratch = malloc(size * sizeof(uint64_t));
+    if (scratch == NULL) { qsort(arr, size, sizeof(double), compare_double); return; }
+    for (size_t i = 0; i < size; ++i) { uint64_t k = double_to_key(arr[i]); memcpy(&arr[i], &k, 8); }
+    radix_sort_64(arr, scratch, size);
+    for (size_t i = 0; i < size; ++i) { uint64_t k; memcpy(&k, &arr[i], 8); arr[i] = key_to_double(k); }
+    free(scratch);
 }
 
 // Uses DOUBLE_EPSILON
 bool array_contains_double(const double *arr, size_t size, double value) {
     if (arr == NULL || size == 0) return false;
-    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < DOUBLE_EPSILON) return true;
-    return false;
+    return aq_search.find_double(arr, size, value) < size;
 }
 
 // Uses DOUBLE_EPSILON. Returns -1 or index (if fits int).
 int array_index_of_double(const double *arr, size_t size, double value) {
     if (arr == NULL || size == 0) return -1;
-    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < DOUBLE_EPSILON) return (i > INT_MAX) ? -1 : (int)i;
-    return -1;
+    size_t i = aq_search.find_double(arr, size, value);
+    return (i >= size || i > INT_MAX) ? -1 : (int)i;
 }
 
 // Uses DOUBLE_EPSILON
 size_t array_count_occurrence_double(const double *arr, size_t size, double value) {
     if (arr == NULL || size == 0) return 0;
-    size_t count = 0;
-    for (size_t i = 0; i < size; ++i) if (fabs(arr[i] - value) < DOUBLE_EPSILON) count++;
-    return count;
+    return aq_search.count_double(arr, size, value);
 }
 
 // Caller must free.
@@ -769,10 +5223,24 @@ static int compare_string(const void *a, const void *b) {
     if (*sa == NULL) return -1; if (*sb == NULL) return 1;
     return strcmp(*sa, *sb);
 }
-// O(n log n * L) time
+// O(n log n + total distinguishing prefix length) expected time. NULLs sort first.
 void sort_array_string(string arr[], size_t size) {
-     if (arr == NULL || size < 2) return;
-    qsort(arr, size, sizeof(string), compare_string);
+    if (arr == NULL || size < 2) return;
+    size_t nulls = 0;
+    for (size_t i = 0; i < size; ++i) if (arr[i] == NULL) { arr[i] = arr[nulls]; arr[nulls++] = NULL; }
+    string *rest = arr + nulls;
+    size_t n = size - nulls;
+    if (n < 2) return;
+    StringSortEntry stack_entries[STRING_SORT_STACK];
+    StringSortEntry *entries = (n <= STRING_SORT_STACK) ? stack_entries : malloc(n * sizeof(StringSortEntry));
+    if (entries == NULL) { qsort(rest, n, sizeof(string), compare_string); return; } // Allocation failed
+    for (size_t i = 0; i < n; ++i) {
+        if (i + STRING_SORT_PREFETCH < n) AQ_PREFETCH(rest[i + STRING_SORT_PREFETCH]);
+        entries[i].key = string_prefix_key(rest[i]); entries[i].s = rest[i];
+    }
+    multikey_quicksort(entries, n, 0);
+    for (size_t i = 0; i < n; ++i) rest[i] = entries[i].s;
+    if (entries != stack_entries) free(entries);
 }
 
 // O(n * L) time. Handles NULLs.
@@ -831,98 +5299,841 @@ void array_reverse_string(string arr[], size_t size) {
     }
 }
 
-// Needs srand() called once at program start. O(n) time.
-void array_shuffle_int(int arr[], size_t size) {
-    if (arr == NULL || size < 2) return;
-    for (size_t i = size - 1; i > 0; --i) {
-        size_t j = (size_t)rand() % (i + 1); // Random index from 0 to i
-        int temp = arr[i]; arr[i] = arr[j]; arr[j] = temp; // Swap
+// Unbiased Fisher-Yates on the calling thread's generator. O(n) time.
+void array_shuffle_int(int arr[], size_t size) {
+    if (arr == NULL || size < 2) return;
+    aq_rng *rng = current_rng();
+    for (size_t i = size - 1; i > 0; --i) {
+        size_t j = (size_t)aq_rng_bounded(rng, (uint64_t)i + 1); // Random index from 0 to i
+        int temp = arr[i]; arr[i] = arr[j]; arr[j] = temp; // Swap
+    }
+}
+// Unbiased Fisher-Yates on the calling thread's generator. O(n) time.
+void array_shuffle_float(float arr[], size_t size) {
+    if (arr == NULL || size < 2) return;
+    aq_rng *rng = current_rng();
+    for (size_t i = size - 1; i > 0; --i) { size_t j = (size_t)aq_rng_bounded(rng, (uint64_t)i + 1); float temp = arr[i]; arr[i] = arr[j]; arr[j] = temp;}
+}
+// Unbiased Fisher-Yates on the calling thread's generator. O(n) time.
+void array_shuffle_double(double arr[], size_t size) {
+     if (arr == NULL || size < 2) return;
+    aq_rng *rng = current_rng();
+    for (size_t i = size - 1; i > 0; --i) { size_t j = (size_t)aq_rng_bounded(rng, (uint64_t)i + 1); double temp = arr[i]; arr[i] = arr[j]; arr[j] = temp;}
+}
+// Unbiased Fisher-Yates on the calling thread's generator. O(n) time.
+void array_shuffle_string(string arr[], size_t size) {
+     if (arr == NULL || size < 2) return;
+    aq_rng *rng = current_rng();
+    for (size_t i = size - 1; i > 0; --i) { size_t j = (size_t)aq_rng_bounded(rng, (uint64_t)i + 1); string temp = arr[i]; arr[i] = arr[j]; arr[j] = temp;}
+}
+
+// O(n) average time, O(n) space. Caller must free returned array.
+int* array_unique_int(const int *arr, size_t size, size_t *new_size) {
+    if (new_size == NULL) return NULL;
+    if (arr == NULL || size == 0) { *new_size = 0; return NULL; }
+    HashTable table;
+    if (!ht_init(&table, size)) { *new_size = 0; return NULL; } // Allocation failed
+    HashTable *ht = &table;
+    for (size_t i = 0; i < size; ++i) {
+        if (!ht_insert(ht, arr[i])) { ht_destroy(ht); *new_size = 0; return NULL; } // Populate counts
+    }
+    size_t unique_count = ht->used;
+    *new_size = unique_count;
+    if (unique_count == 0) { ht_destroy(ht); return NULL; }
+    int *unique_arr = malloc(unique_count * sizeof(int));
+    if (unique_arr == NULL) { ht_destroy(ht); *new_size = 0; return NULL; } // Allocation failed
+    size_t k = 0;
+    for (size_t i = 0; i <= ht->mask; ++i) {
+        if (ht->slots[i].count != 0) unique_arr[k++] = ht->slots[i].key;
+    }
+    ht_destroy(ht);
+    return unique_arr; // Caller must free
+}
+
+// O(n * L) average time. Deep copies of the distinct strings in order of first
+// occurrence; a NULL element is kept once. Caller must free using free_string_array.
+string* array_unique_string(const string *arr, size_t size, size_t *new_size) {
+    if (new_size == NULL) return NULL;
+    *new_size = 0;
+    if (arr == NULL || size == 0) return NULL;
+    StringTable table;
+    if (!st_init(&table, size)) return NULL;
+    if (!st_insert_all(&table, NULL, arr, size, ST_FIRST_INDEX, NULL)) { st_destroy(&table); return NULL; } // value: first occurrence, to place the NULL
+    size_t first_null = SIZE_MAX;
+    for (size_t i = 0; i < size && first_null == SIZE_MAX; ++i) if (arr[i] == NULL) first_null = i;
+    size_t unique_count = table.count + (first_null != SIZE_MAX);
+    string *unique_arr = malloc(unique_count * sizeof(string));
+    if (unique_arr == NULL) { st_destroy(&table); return NULL; }
+    size_t k = 0;
+    for (size_t i = 0; i < table.count; ++i) {
+        const StringEntry *e = &table.entries[i];
+        if (first_null < e->value) { unique_arr[k++] = NULL; first_null = SIZE_MAX; }
+        unique_arr[k] = copy_bytes(NULL, e->key, e->length);
+        if (unique_arr[k] == NULL) { free_string_array(unique_arr, k); st_destroy(&table); return NULL; }
+        k++;
+    }
+    if (k < unique_count) unique_arr[k] = NULL;
+    st_destroy(&table);
+    *new_size = unique_count;
+    return unique_arr;
+}
+
+// O(size1 + size2) time. Caller must free.
+int* array_concat_int(const int *arr1, size_t size1, const int *arr2, size_t size2, size_t *new_size) {
+    if (new_size == NULL) return NULL;
+    size_t total_size = size1 + size2; *new_size = total_size;
+    if (total_size == 0) return NULL; // Cannot create empty array
+    int *concat_arr = malloc(total_size * sizeof(int));
+    if (concat_arr == NULL) { *new_size = 0; return NULL;} // Allocation failed
+    if (arr1 && size1 > 0) memcpy(concat_arr, arr1, size1 * sizeof(int));
+    if (arr2 && size2 > 0) memcpy(concat_arr + size1, arr2, size2 * sizeof(int));
+    return concat_arr; // Caller must free
+}
+
+// O(size1 + size2) time. Caller must free.
+float* array_concat_float(const float *arr1, size_t size1, const float *arr2, size_t size2, size_t *new_size) {
+    if (new_size == NULL) return NULL;
+    size_t total_size = size1 + size2; *new_size = total_size;
+    if (total_size == 0) return NULL;
+    float *concat_arr = malloc(total_size * sizeof(float));
+    if (concat_arr == NULL) { *new_size = 0; return NULL;}
+    if (arr1 && size1 > 0) memcpy(concat_arr, arr1, size1 * sizeof(float));
+    if (arr2 && size2 > 0) memcpy(concat_arr + size1, arr2, size2 * sizeof(float));
+    return concat_arr; // Caller must free
+}
+
+// O(size1 + size2) time. Caller must free.
+double* array_concat_double(const double *arr1, size_t size1, const double *arr2, size_t size2, size_t *new_size) {
+    if (new_size == NULL) return NULL;
+    size_t total_size = size1 + size2; *new_size = total_size;
+    if (total_size == 0) return NULL;
+    double *concat_arr = malloc(total_size * sizeof(double));
+    if (concat_arr == NULL) { *new_size = 0; return NULL;}
+    if (arr1 && size1 > 0) memcpy(concat_arr, arr1, size1 * sizeof(double));
+    if (arr2 && size2 > 0) memcpy(concat_arr + size1, arr2, size2 * sizeof(double));
+    return concat_arr; // Caller must free
+}
+
+// O((size1 + size2) * L) time (deep copy). Caller must free using free_string_array.
+string* array_concat_string(const string *arr1, size_t size1, const string *arr2, size_t size2, size_t *new_size) {
+    if (new_size == NULL) return NULL;
+    size_t total_size = size1 + size2; *new_size = total_size;
+    if (total_size == 0) return NULL;
+    string *concat_arr = malloc(total_size * sizeof(string));
+    if (concat_arr == NULL) { *new_size = 0; return NULL;}
+    for(size_t i=0; i < size1; ++i) { concat_arr[i] = string_copy(arr1 ? arr1[i] : NULL); if (concat_arr[i] == NULL && (arr1 ? arr1[i] : NULL) != NULL) { for(size_t k=0; k<i; ++k) free(concat_arr[k]); free(concat_arr); *new_size=0; return NULL;} } // Copy arr1, handle fail
+    for(size_t i=0; i < size2; ++i) { concat_arr[size1 + i] = string_copy(arr2 ? arr2[i] : NULL); if (concat_arr[size1+i] == NULL && (arr2 ? arr2[i] : NULL) != NULL) { for(size_t k=0; k<(size1+i); ++k) free(concat_arr[k]); free(concat_arr); *new_size=0; return NULL;} } // Copy arr2, handle fail
+    return concat_arr; // Caller must free using free_string_array
+}
+
+
+// --- Sorted Index ---
+// aq_index keeps the array's order-preserving keys (see Sort Engine) sorted,
+// with each key's original position, in blocks of INDEX_BLOCK_SIZE. The first
+// key of every block is stored again in Eytzinger (BFS) order, padded with
+// UINT64_MAX to a perfect tree. A lookup descends that tree without branches,
+// always for the same number of levels, prefetching four levels ahead, and
+// then counts keys inside one block. Float/double zeros are stored as +0.0
+// so -0.0 and 0.0 compare equal in every query. String indexes key on the
+// first 8 bytes and binary-search the (usually tiny) run sharing a prefix.
+#define INDEX_BLOCK_SIZE 16
+#define INDEX_BATCH 16
+
+enum { INDEX_INT, INDEX_FLOAT, INDEX_DOUBLE, INDEX_STRING };
+
+struct aq_index {
+    int type;
+    size_t size;
+    uint64_t *keys;        // Sorted keys
+    uint32_t *positions;   // Original index of keys[i], UINT32_MAX if it does not fit an int
+    size_t blocks;         // Number of INDEX_BLOCK_SIZE blocks in keys
+    unsigned levels;       // Depth of the padded tree
+    size_t tree_mask;      // Tree capacity - 1 (capacity is a power of two)
+    uint64_t *tree;        // 1-based Eytzinger layout of the block separators
+    string *strings;       // String index only: sorted pointers into the caller's strings
+};
+
+static uint64_t index_float_key(float f) { return float_to_key(f == 0.0f ? 0.0f : f); }
+static uint64_t index_double_key(double d) { return double_to_key(d == 0.0 ? 0.0 : d); }
+
+// Stable LSD radix sort of keys with a 32-bit payload. Constant digits are skipped,
+// so 32-bit keys stored in the low half cost four passes.
+static void radix_sort_pairs(uint64_t *keys, uint32_t *pos, uint64_t *key_tmp, uint32_t *pos_tmp, size_t n) {
+    size_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; ++i)
+        for (unsigned pass = 0; pass < 8; ++pass) counts[pass][(keys[i] >> (pass * 8)) & 0xFF]++;
+    uint64_t *ksrc = keys, *kdst = key_tmp;
+    uint32_t *psrc = pos, *pdst = pos_tmp;
+    for (unsigned pass = 0; pass < 8; ++pass) {
+        size_t *count = counts[pass];
+        unsigned shift = pass * 8;
+        if (count[(ksrc[0] >> shift) & 0xFF] == n) continue;
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; ++d) { size_t c = count[d]; count[d] = offset; offset += c; }
+        for (size_t i = 0; i < n; ++i) {
+            size_t dest = count[(ksrc[i] >> shift) & 0xFF]++;
+            kdst[dest] = ksrc[i]; pdst[dest] = psrc[i];
+        }
+        uint64_t *kt = ksrc; ksrc = kdst; kdst = kt;
+        uint32_t *pt = psrc; psrc = pdst; pdst = pt;
+    }
+    if (ksrc != keys) { memcpy(keys, ksrc, n * sizeof(uint64_t)); memcpy(pos, psrc, n * sizeof(uint32_t)); }
+}
+
+// In-order fill of the tree rooted at slot k; `next` is the next separator number.
+static size_t index_fill_tree(aq_index *index, size_t k, size_t next) {
+    if (k > index->tree_mask) return next;
+    next = index_fill_tree(index, 2 * k, next);
+    index->tree[k] = (next < index->blocks) ? index->keys[next * INDEX_BLOCK_SIZE] : UINT64_MAX;
+    return index_fill_tree(index, 2 * k + 1, next + 1);
+}
+
+// Builds the separator tree over index->keys (already sorted). Returns false on allocation failure.
+static bool index_layout(aq_index *index) {
+    index->blocks = (index->size + INDEX_BLOCK_SIZE - 1) / INDEX_BLOCK_SIZE;
+    size_t capacity = 2;
+    index->levels = 1;
+    while (capacity - 1 < index->blocks) { capacity <<= 1; index->levels++; }
+    index->tree_mask = capacity - 1;
+    index->tree = malloc(capacity * sizeof(uint64_t));
+    if (index->tree == NULL) return false;
+    index_fill_tree(index, 1, 0);
+    return true;
+}
+
+// Takes ownership of keys (size elements, original order). Returns NULL on allocation failure.
+static aq_index* index_build(int type, uint64_t *keys, size_t size) {
+    aq_index *index = calloc(1, sizeof(aq_index));
+    uint32_t *positions = malloc(size * sizeof(uint32_t));
+    uint64_t *key_tmp = malloc(size * sizeof(uint64_t));
+    uint32_t *pos_tmp = malloc(size * sizeof(uint32_t));
+    if (index == NULL || positions == NULL || key_tmp == NULL || pos_tmp == NULL) {
+        free(index); free(positions); free(key_tmp); free(pos_tmp); free(keys);
+        return NULL;
+    }
+    for (size_t i = 0; i < size; ++i) positions[i] = (i <= INT_MAX) ? (uint32_t)i : UINT32_MAX;
+    radix_sort_pairs(keys, positions, key_tmp, pos_tmp, size);
+    free(key_tmp); free(pos_tmp);
+
+    index->type = type;
+    index->size = size;
+    index->keys = keys;
+    index->positions = positions;
+    if (!index_layout(index)) { aq_index_destroy(index); return NULL; }
+    return index;
+}
+
+aq_index* aq_index_create_int(const int *arr, size_t size) {
+    if (arr == NULL || size == 0) return NULL;
+    uint64_t *keys = malloc(size * sizeof(uint64_t));
+    if (keys == NULL) return NULL;
+    for (size_t i = 0; i < size; ++i) keys[i] = int_to_key(arr[i]);
+    return index_build(INDEX_INT, keys, size);
+}
+
+aq_index* aq_index_create_float(const float *arr, size_t size) {
+    if (arr == NULL || size == 0) return NULL;
+    uint64_t *keys = malloc(size * sizeof(uint64_t));
+    if (keys == NULL) return NULL;
+    for (size_t i = 0; i < size; ++i) keys[i] = index_float_key(arr[i]);
+    return index_build(INDEX_FLOAT, keys, size);
+}
+
+aq_index* aq_index_create_double(const double *arr, size_t size) {
+    if (arr == NULL || size == 0) return NULL;
+    uint64_t *keys = malloc(size * sizeof(uint64_t));
+    if (keys == NULL) return NULL;
+    for (size_t i = 0; i < size; ++i) keys[i] = index_double_key(arr[i]);
+    return index_build(INDEX_DOUBLE, keys, size);
+}
+
+void aq_index_destroy(aq_index *index) {
+    if (index == NULL) return;
+    free(index->keys); free(index->positions);
+    free(index->tree);
+    free(index->strings);
+    free(index);
+}
+
+size_t aq_index_size(const aq_index *index) {
+    return (index == NULL) ? 0 : index->size;
+}
+
+// The tree is perfect, so after `levels` steps k - capacity is the number of
+// separators < key, i.e. the first block whose separator is >= key.
+static size_t index_block_from_slot(const aq_index *index, size_t k) {
+    size_t block = k - (index->tree_mask + 1);
+    return (block < index->blocks) ? block : index->blocks;
+}
+
+// Number of keys < key, given the first block whose separator is >= key.
+static size_t index_rank_in_block(const aq_index *index, size_t block, uint64_t key) {
+    if (block == 0) return 0;
+    size_t start = (block - 1) * INDEX_BLOCK_SIZE;
+    size_t end = (start + INDEX_BLOCK_SIZE < index->size) ? start + INDEX_BLOCK_SIZE : index->size;
+    size_t rank = start;
+    for (size_t i = start; i < end; ++i) rank += index->keys[i] < key;
+    return rank;
+}
+
+static size_t index_rank(const aq_index *index, uint64_t key) {
+    const uint64_t *tree = index->tree;
+    size_t k = 1;
+    for (unsigned level = 0; level < index->levels; ++level) {
+        AQ_PREFETCH(tree + ((k * 16) & index->tree_mask));
+        AQ_PREFETCH(tree + ((k * 16 + 8) & index->tree_mask));
+        k = 2 * k + (tree[k] < key);
+    }
+    return index_rank_in_block(index, index_block_from_slot(index, k), key);
+}
+
+// index_rank for up to INDEX_BATCH keys, descending all trees level by level so
+// the cache misses of different queries overlap.
+static void index_rank_batch(const aq_index *index, const uint64_t *keys, size_t count, size_t *ranks) {
+    const uint64_t *tree = index->tree;
+    size_t k[INDEX_BATCH];
+    for (size_t j = 0; j < count; ++j) k[j] = 1;
+    for (unsigned level = 0; level < index->levels; ++level) {
+        for (size_t j = 0; j < count; ++j) {
+            AQ_PREFETCH(tree + ((k[j] * 16) & index->tree_mask));
+            AQ_PREFETCH(tree + ((k[j] * 16 + 8) & index->tree_mask));
+            k[j] = 2 * k[j] + (tree[k[j]] < keys[j]);
+        }
+    }
+    for (size_t j = 0; j < count; ++j) {
+        k[j] = index_block_from_slot(index, k[j]);
+        if (k[j] > 0) AQ_PREFETCH(index->keys + (k[j] - 1) * INDEX_BLOCK_SIZE);
+    }
+    for (size_t j = 0; j < count; ++j) ranks[j] = index_rank_in_block(index, k[j], keys[j]);
+}
+
+// Smallest original position among keys equal to key, starting at its rank. -1 if absent.
+static int index_first_position(const aq_index *index, size_t rank, uint64_t key) {
+    if (rank >= index->size || index->keys[rank] != key) return -1;
+    uint32_t pos = index->positions[rank]; // Stable sort: first of the run is the smallest
+    return (pos == UINT32_MAX) ? -1 : (int)pos;
+}
+
+// Key range that contains every float within FLOAT_EPSILON of value (with margin);
+// candidates are then checked with the same test as array_index_of_float.
+static void index_float_window(float value, uint64_t *lo_key, uint64_t *hi_key) {
+    double lo = (double)value - 2.0 * FLOAT_EPSILON, hi = (double)value + 2.0 * FLOAT_EPSILON;
+    float flo = (float)lo, fhi = (float)hi;
+    if ((double)flo > lo) flo = nextafterf(flo, -INFINITY);
+    if ((double)fhi < hi) fhi = nextafterf(fhi, INFINITY);
+    *lo_key = index_float_key(flo); *hi_key = index_float_key(fhi);
+}
+
+static void index_double_window(double value, uint64_t *lo_key, uint64_t *hi_key) {
+    *lo_key = index_double_key(nextafter(value - 2.0 * DOUBLE_EPSILON, -INFINITY));
+    *hi_key = index_double_key(nextafter(value + 2.0 * DOUBLE_EPSILON, INFINITY));
+}
+
+// Scans the candidates in [rank, hi_key] and returns the smallest matching position,
+// INT_MAX + 1LL if only positions beyond INT_MAX match, or -1 if nothing matches.
+static long long index_scan_float(const aq_index *index, size_t rank, uint64_t hi_key, float value) {
+    long long best = -1;
+    for (size_t i = rank; i < index->size && index->keys[i] <= hi_key; ++i) {
+        float candidate = key_to_float((uint32_t)index->keys[i]);
+        if (fabs(candidate - value) < FLOAT_EPSILON) {
+            long long pos = (index->positions[i] == UINT32_MAX) ? (long long)INT_MAX + 1 : index->positions[i];
+            if (best < 0 || pos < best) best = pos;
+        }
+    }
+    return best;
+}
+
+static long long index_scan_double(const aq_index *index, size_t rank, uint64_t hi_key, double value) {
+    long long best = -1;
+    for (size_t i = rank; i < index->size && index->keys[i] <= hi_key; ++i) {
+        double candidate = key_to_double(index->keys[i]);
+        if (fabs(candidate - value) < DOUBLE_EPSILON) {
+            long long pos = (index->positions[i] == UINT32_MAX) ? (long long)INT_MAX + 1 : index->positions[i];
+            if (best < 0 || pos < best) best = pos;
+        }
+    }
+    return best;
+}
+
+// O(log n) time. Same result as array_contains_int on the indexed array.
+bool aq_index_contains_int(const aq_index *index, int value) {
+    if (index == NULL || index->type != INDEX_INT) return false;
+    uint64_t key = int_to_key(value);
+    size_t rank = index_rank(index, key);
+    return rank < index->size && index->keys[rank] == key;
+}
+
+// O(log n) time. Same result as array_index_of_int on the indexed array.
+int aq_index_index_of_int(const aq_index *index, int value) {
+    if (index == NULL || index->type != INDEX_INT) return -1;
+    uint64_t key = int_to_key(value);
+    return index_first_position(index, index_rank(index, key), key);
+}
+
+// O(log n) time. Number of elements < value (position of value in sorted order).
+size_t aq_index_lower_bound_int(const aq_index *index, int value) {
+    if (index == NULL || index->type != INDEX_INT) return 0;
+    return index_rank(index, int_to_key(value));
+}
+
+// O(log n) time. Number of elements in [lo, hi] (0 if lo > hi).
+size_t aq_index_count_range_int(const aq_index *index, int lo, int hi) {
+    if (index == NULL || index->type != INDEX_INT || lo > hi) return 0;
+    size_t end = (hi == INT_MAX) ? index->size : index_rank(index, int_to_key(hi + 1));
+    return end - index_rank(index, int_to_key(lo));
+}
+
+// O(count * log n) time with overlapped memory accesses. results[i] = contains(values[i]). Returns the number found.
+size_t aq_index_contains_batch_int(const aq_index *index, const int *values, size_t count, bool *results) {
+    if (index == NULL || index->type != INDEX_INT || values == NULL || results == NULL) return 0;
+    size_t found = 0;
+    for (size_t base = 0; base < count; base += INDEX_BATCH) {
+        size_t n = (count - base < INDEX_BATCH) ? count - base : INDEX_BATCH;
+        uint64_t keys[INDEX_BATCH]; size_t ranks[INDEX_BATCH];
+        for (size_t j = 0; j < n; ++j) keys[j] = int_to_key(values[base + j]);
+        index_rank_batch(index, keys, n, ranks);
+        for (size_t j = 0; j < n; ++j) {
+            results[base + j] = ranks[j] < index->size && index->keys[ranks[j]] == keys[j];
+            found += results[base + j];
+        }
+    }
+    return found;
+}
+
+// O(log n + k) time, k = elements within about 2 * FLOAT_EPSILON. Same result as array_contains_float.
+bool aq_index_contains_float(const aq_index *index, float value) {
+    if (index == NULL || index->type != INDEX_FLOAT || isnan(value)) return false;
+    uint64_t lo_key, hi_key;
+    index_float_window(value, &lo_key, &hi_key);
+    return index_scan_float(index, index_rank(index, lo_key), hi_key, value) >= 0;
+}
+
+// O(log n + k) time. Same result as array_index_of_float (smallest matching index).
+int aq_index_index_of_float(const aq_index *index, float value) {
+    if (index == NULL || index->type != INDEX_FLOAT || isnan(value)) return -1;
+    uint64_t lo_key, hi_key;
+    index_float_window(value, &lo_key, &hi_key);
+    long long pos = index_scan_float(index, index_rank(index, lo_key), hi_key, value);
+    return (pos < 0 || pos > INT_MAX) ? -1 : (int)pos;
+}
+
+// O(log n) time. Number of elements < value (exact compare, -0.0 == 0.0, NaNs sort to the ends).
+size_t aq_index_lower_bound_float(const aq_index *index, float value) {
+    if (index == NULL || index->type != INDEX_FLOAT) return 0;
+    return index_rank(index, index_float_key(value));
+}
+
+// O(log n) time. Number of elements in [lo, hi] (exact compare).
+size_t aq_index_count_range_float(const aq_index *index, float lo, float hi) {
+    if (index == NULL || index->type != INDEX_FLOAT || !(lo <= hi)) return 0;
+    uint64_t hi_key = index_float_key(hi);
+    size_t end = (hi_key == UINT32_MAX) ? index->size : index_rank(index, hi_key + 1);
+    return end - index_rank(index, index_float_key(lo));
+}
+
+// Batched aq_index_contains_float. Returns the number found.
+size_t aq_index_contains_batch_float(const aq_index *index, const float *values, size_t count, bool *results) {
+    if (index == NULL || index->type != INDEX_FLOAT || values == NULL || results == NULL) return 0;
+    size_t found = 0;
+    for (size_t base = 0; base < count; base += INDEX_BATCH) {
+        size_t n = (count - base < INDEX_BATCH) ? count - base : INDEX_BATCH;
+        uint64_t lo_keys[INDEX_BATCH], hi_keys[INDEX_BATCH]; size_t ranks[INDEX_BATCH];
+        for (size_t j = 0; j < n; ++j) index_float_window(values[base + j], &lo_keys[j], &hi_keys[j]);
+        index_rank_batch(index, lo_keys, n, ranks);
+        for (size_t j = 0; j < n; ++j) {
+            results[base + j] = !isnan(values[base + j]) && index_scan_float(index, ranks[j], hi_keys[j], values[base + j]) >= 0;
+            found += results[base + j];
+        }
+    }
+    return found;
+}
+
+// O(log n + k) time. Same result as array_contains_double.
+bool aq_index_contains_double(const aq_index *index, double value) {
+    if (index == NULL || index->type != INDEX_DOUBLE || isnan(value)) return false;
+    uint64_t lo_key, hi_key;
+    index_double_window(value, &lo_key, &hi_key);
+    return index_scan_double(index, index_rank(index, lo_key), hi_key, value) >= 0;
+}
+
+// O(log n + k) time. Same result as array_index_of_double (smallest matching index).
+int aq_index_index_of_double(const aq_index *index, double value) {
+    if (index == NULL || index->type != INDEX_DOUBLE || isnan(value)) return -1;
+    uint64_t lo_key, hi_key;
+    index_double_window(value, &lo_key, &hi_key);
+    long long pos = index_scan_double(index, index_rank(index, lo_key), hi_key, value);
+    return (pos < 0 || pos > INT_MAX) ? -1 : (int)pos;
+}
+
+// O(log n) time. Number of elements < value (exact compare, -0.0 == 0.0, NaNs sort to the ends).
+size_t aq_index_lower_bound_double(const aq_index *index, double value) {
+    if (index == NULL || index->type != INDEX_DOUBLE) return 0;
+    return index_rank(index, index_double_key(value));
+}
+
+// O(log n) time. Number of elements in [lo, hi] (exact compare).
+size_t aq_index_count_range_double(const aq_index *index, double lo, double hi) {
+    if (index == NULL || index->type != INDEX_DOUBLE || !(lo <= hi)) return 0;
+    uint64_t hi_key = index_double_key(hi);
+    size_t end = (hi_key == UINT64_MAX) ? index->size : index_rank(index, hi_key + 1);
+    return end - index_rank(index, index_double_key(lo));
+}
+
+// Batched aq_index_contains_double. Returns the number found.
+size_t aq_index_contains_batch_double(const aq_index *index, const double *values, size_t count, bool *results) {
+    if (index == NULL || index->type != INDEX_DOUBLE || values == NULL || results == NULL) return 0;
+    size_t found = 0;
+    for (size_t base = 0; base < count; base += INDEX_BATCH) {
+        size_t n = (count - base < INDEX_BATCH) ? count - base : INDEX_BATCH;
+        uint64_t lo_keys[INDEX_BATCH], hi_keys[INDEX_BATCH]; size_t ranks[INDEX_BATCH];
+        for (size_t j = 0; j < n; ++j) index_double_window(values[base + j], &lo_keys[j], &hi_keys[j]);
+        index_rank_batch(index, lo_keys, n, ranks);
+        for (size_t j = 0; j < n; ++j) {
+            results[base + j] = !isnan(values[base + j]) && index_scan_double(index, ranks[j], hi_keys[j], values[base + j]) >= 0;
+            found += results[base + j];
+        }
+    }
+    return found;
+}
+
+
+typedef struct IndexStringEntry {
+    string s;
+    size_t pos;
+} IndexStringEntry;
+
+// Same order as compare_string; ties keep the original order so runs start at the first occurrence.
+static int compare_index_string_entry(const void *a, const void *b) {
+    const IndexStringEntry *ea = (const IndexStringEntry*)a, *eb = (const IndexStringEntry*)b;
+    int c = compare_string(&ea->s, &eb->s);
+    if (c != 0) return c;
+    return (ea->pos > eb->pos) - (ea->pos < eb->pos);
+}
+
+// First 8 bytes, big-endian, zero padded: key order agrees with strcmp. NULL and "" share key 0.
+// Refines a prefix rank to the number of strings < value (compare_string order).
+static size_t index_string_rank(const aq_index *index, size_t rank, uint64_t key, const string value) {
+    size_t end = rank, step = 1;
+    while (end < index->size && index->keys[end] == key) { end = rank + step; step <<= 1; }
+    if (end > index->size) end = index->size;
+    size_t lo = rank, hi = end; // Everything in [rank, end) past the run has a larger prefix
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (compare_string(&index->strings[mid], &value) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// O(n log n * L) build. The strings are not copied: they must outlive the index and stay unchanged.
+aq_index* aq_index_create_string(const string *arr, size_t size) {
+    if (arr == NULL || size == 0) return NULL;
+    IndexStringEntry *entries = malloc(size * sizeof(IndexStringEntry));
+    aq_index *index = calloc(1, sizeof(aq_index));
+    if (entries == NULL || index == NULL) { free(entries); free(index); return NULL; }
+    for (size_t i = 0; i < size; ++i) { entries[i].s = arr[i]; entries[i].pos = i; }
+    qsort(entries, size, sizeof(IndexStringEntry), compare_index_string_entry);
+
+    index->type = INDEX_STRING;
+    index->size = size;
+    index->keys = malloc(size * sizeof(uint64_t));
+    index->positions = malloc(size * sizeof(uint32_t));
+    index->strings = malloc(size * sizeof(string));
+    if (index->keys == NULL || index->positions == NULL || index->strings == NULL) {
+        free(entries); aq_index_destroy(index); return NULL;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        index->strings[i] = entries[i].s;
+        index->keys[i] = string_prefix_key(entries[i].s);
+        index->positions[i] = (entries[i].pos <= INT_MAX) ? (uint32_t)entries[i].pos : UINT32_MAX;
+    }
+    free(entries);
+    if (!index_layout(index)) { aq_index_destroy(index); return NULL; }
+    return index;
+}
+
+// O(log n * L) time. Same result as array_contains_string (NULL matches NULL).
+bool aq_index_contains_string(const aq_index *index, const string value) {
+    if (index == NULL || index->type != INDEX_STRING) return false;
+    uint64_t key = string_prefix_key(value);
+    size_t rank = index_string_rank(index, index_rank(index, key), key, value);
+    return rank < index->size && string_equals(index->strings[rank], value);
+}
+
+// O(log n * L) time. Same result as find_string (-1 for a NULL target).
+int aq_index_index_of_string(const aq_index *index, const string value) {
+    if (index == NULL || index->type != INDEX_STRING || value == NULL) return -1;
+    uint64_t key = string_prefix_key(value);
+    size_t rank = index_string_rank(index, index_rank(index, key), key, value);
+    if (rank >= index->size || !string_equals(index->strings[rank], value)) return -1;
+    return (index->positions[rank] == UINT32_MAX) ? -1 : (int)index->positions[rank];
+}
+
+// O(log n * L) time. Number of strings < value in sort_array_string order (NULL first).
+size_t aq_index_lower_bound_string(const aq_index *index, const string value) {
+    if (index == NULL || index->type != INDEX_STRING) return 0;
+    uint64_t key = string_prefix_key(value);
+    return index_string_rank(index, index_rank(index, key), key, value);
+}
+
+// Batched aq_index_contains_string. Returns the number found.
+size_t aq_index_contains_batch_string(const aq_index *index, const string *values, size_t count, bool *results) {
+    if (index == NULL || index->type != INDEX_STRING || values == NULL || results == NULL) return 0;
+    size_t found = 0;
+    for (size_t base = 0; base < count; base += INDEX_BATCH) {
+        size_t n = (count - base < INDEX_BATCH) ? count - base : INDEX_BATCH;
+        uint64_t keys[INDEX_BATCH]; size_t ranks[INDEX_BATCH];
+        for (size_t j = 0; j < n; ++j) keys[j] = string_prefix_key(values[base + j]);
+        index_rank_batch(index, keys, n, ranks);
+        for (size_t j = 0; j < n; ++j) {
+            size_t rank = index_string_rank(index, ranks[j], keys[j], values[base + j]);
+            results[base + j] = rank < index->size && string_equals(index->strings[rank], values[base + j]);
+            found += results[base + j];
+        }
+    }
+    return found;
+}
+
+// --- Parallel Sorting ---
+// sort_array_parallel / sort_array_double_parallel run the radix engine with
+// the array split across worker threads: every pass is a counting phase and a
+// scatter phase, with per-thread bucket offsets so the result is identical to
+// the serial sort. sort_array_string_parallel sorts one chunk per thread and
+// then merges pairs of runs in rounds; each thread writes an equal slice of
+// the output, found by binary search (merge path). Threads are created per
+// phase and joined, which is cheap next to the data sizes that reach here.
+// Below PARALLEL_SORT_THRESHOLD elements, or without pthreads, the serial
+// functions are used.
+#define PARALLEL_SORT_THRESHOLD 131072
+#define PARALLEL_SORT_MIN_CHUNK 32768
+#define PARALLEL_SORT_MAX_THREADS 256
+
+#if !defined(AQUANT_NO_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define AQUANT_HAVE_PTHREADS 1
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Clamps the requested thread count: <= 0 means one per online CPU.
+static size_t parallel_thread_count(int num_threads, size_t size) {
+    size_t threads = (num_threads > 0) ? (size_t)num_threads : 1;
+#ifdef AQUANT_HAVE_PTHREADS
+    if (num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (size_t)cpus : 1;
+    }
+#else
+    threads = 1;
+#endif
+    if (threads > size / PARALLEL_SORT_MIN_CHUNK) threads = size / PARALLEL_SORT_MIN_CHUNK;
+    if (threads > PARALLEL_SORT_MAX_THREADS) threads = PARALLEL_SORT_MAX_THREADS;
+    return (threads == 0) ? 1 : threads;
+}
+
+// Runs worker(tasks + i * task_size) for every i, on its own thread where
+// possible. A task whose thread cannot be created runs on the calling thread.
+static void run_parallel(void *(*worker)(void*), void *tasks, size_t task_size, size_t count) {
+    unsigned char *base = tasks;
+#ifdef AQUANT_HAVE_PTHREADS
+    pthread_t threads[PARALLEL_SORT_MAX_THREADS];
+    bool started[PARALLEL_SORT_MAX_THREADS];
+    for (size_t i = 1; i < count; ++i) started[i] = pthread_create(&threads[i], NULL, worker, base + i * task_size) == 0;
+    worker(base);
+    for (size_t i = 1; i < count; ++i) {
+        if (started[i]) pthread_join(threads[i], NULL);
+        else worker(base + i * task_size);
+    }
+#else
+    for (size_t i = 0; i < count; ++i) worker(base + i * task_size);
+#endif
+}
+
+enum { RADIX_TO_KEYS, RADIX_COUNT, RADIX_SCATTER, RADIX_FROM_KEYS };
+
+typedef struct RadixTask {
+    int phase;
+    bool is_double;         // 8-byte double keys, otherwise 4-byte int keys
+    unsigned char *src;
+    unsigned char *dst;     // RADIX_SCATTER target; RADIX_FROM_KEYS writes values here
+    size_t begin, end;      // This thread's element range in src
+    unsigned shift;
+    size_t counts[256];     // Digit counts, then this thread's write offsets
+    size_t all_counts[8][256]; // RADIX_TO_KEYS: histogram of every digit
+} RadixTask;
+
+static void *radix_worker(void *arg) {
+    RadixTask *t = arg;
+    if (t->is_double) {
+        for (size_t i = t->begin; i < t->end; ++i) {
+            unsigned char *p = t->src + i * 8;
+            uint64_t k;
+            if (t->phase == RADIX_TO_KEYS) {
+                double d; memcpy(&d, p, 8); k = double_to_key(d); memcpy(p, &k, 8);
+                for (unsigned digit = 0; digit < 8; ++digit) t->all_counts[digit][(k >> (digit * 8)) & 0xFF]++;
+                continue;
+            }
+            memcpy(&k, p, 8);
+            if (t->phase == RADIX_COUNT) t->counts[(k >> t->shift) & 0xFF]++;
+            else if (t->phase == RADIX_SCATTER) memcpy(t->dst + t->counts[(k >> t->shift) & 0xFF]++ * 8, &k, 8);
+            else { double d = key_to_double(k); memcpy(t->dst + i * 8, &d, 8); }
+        }
+    } else {
+        for (size_t i = t->begin; i < t->end; ++i) {
+            unsigned char *p = t->src + i * 4;
+            uint32_t k;
+            if (t->phase == RADIX_TO_KEYS) {
+                int v; memcpy(&v, p, 4); k = int_to_key(v); memcpy(p, &k, 4);
+                for (unsigned digit = 0; digit < 4; ++digit) t->all_counts[digit][(k >> (digit * 8)) & 0xFF]++;
+                continue;
+            }
+            memcpy(&k, p, 4);
+            if (t->phase == RADIX_COUNT) t->counts[(k >> t->shift) & 0xFF]++;
+            else if (t->phase == RADIX_SCATTER) memcpy(t->dst + t->counts[(k >> t->shift) & 0xFF]++ * 4, &k, 4);
+            else { int v = key_to_int(k); memcpy(t->dst + i * 4, &v, 4); }
+        }
+    }
+    return NULL;
+}
+
+// Parallel LSD radix sort of int (is_double false) or double values. Returns
+// false if memory is short, in which case the caller sorts serially.
+static bool parallel_radix_sort(void *arr, size_t size, bool is_double, size_t threads) {
+    size_t w = is_double ? 8 : 4;
+    RadixTask *tasks = calloc(threads, sizeof(RadixTask));
+    unsigned char *scratch = malloc(size * w);
+    if (tasks == NULL || scratch == NULL) { free(tasks); free(scratch); return false; }
+    unsigned char *src = arr, *dst = scratch;
+    for (size_t t = 0; t < threads; ++t) {
+        tasks[t].is_double = is_double;
+        tasks[t].begin = size * t / threads;
+        tasks[t].end = size * (t + 1) / threads;
+        tasks[t].phase = RADIX_TO_KEYS;
+        tasks[t].src = src;
+    }
+    run_parallel(radix_worker, tasks, sizeof(RadixTask), threads);
+
+    for (unsigned pass = 0; pass < w; ++pass) {
+        size_t total[256] = {0};
+        for (size_t t = 0; t < threads; ++t)
+            for (size_t d = 0; d < 256; ++d) total[d] += tasks[t].all_counts[pass][d];
+        uint64_t first = 0;
+        memcpy(&first, src, w);
+        if (total[(first >> (pass * 8)) & 0xFF] == size) continue; // Every key has the same digit
+        for (size_t t = 0; t < threads; ++t) {
+            tasks[t].phase = RADIX_COUNT; tasks[t].shift = pass * 8;
+            tasks[t].src = src; tasks[t].dst = dst;
+            memset(tasks[t].counts, 0, sizeof(tasks[t].counts));
+        }
+        run_parallel(radix_worker, tasks, sizeof(RadixTask), threads);
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; ++d) {
+            for (size_t t = 0; t < threads; ++t) { size_t c = tasks[t].counts[d]; tasks[t].counts[d] = offset; offset += c; }
+        }
+        for (size_t t = 0; t < threads; ++t) tasks[t].phase = RADIX_SCATTER;
+        run_parallel(radix_worker, tasks, sizeof(RadixTask), threads);
+        unsigned char *tmp = src; src = dst; dst = tmp;
     }
+
+    for (size_t t = 0; t < threads; ++t) { tasks[t].phase = RADIX_FROM_KEYS; tasks[t].src = src; tasks[t].dst = arr; }
+    run_parallel(radix_worker, tasks, sizeof(RadixTask), threads);
+    free(tasks);
+    free(scratch);
+    return true;
 }
-// Needs srand() called once at program start. O(n) time.
-void array_shuffle_float(float arr[], size_t size) {
+
+// O(n / threads) time per thread for large inputs. Same result as sort_array.
+void sort_array_parallel(int arr[], size_t size, int num_threads) {
     if (arr == NULL || size < 2) return;
-    for (size_t i = size - 1; i > 0; --i) { size_t j = (size_t)rand() % (i + 1); float temp = arr[i]; arr[i] = arr[j]; arr[j] = temp;}
-}
-// Needs srand() called once at program start. O(n) time.
-void array_shuffle_double(double arr[], size_t size) {
-     if (arr == NULL || size < 2) return;
-    for (size_t i = size - 1; i > 0; --i) { size_t j = (size_t)rand() % (i + 1); double temp = arr[i]; arr[i] = arr[j]; arr[j] = temp;}
-}
-// Needs srand() called once at program start. O(n) time.
-void array_shuffle_string(string arr[], size_t size) {
-     if (arr == NULL || size < 2) return;
-    for (size_t i = size - 1; i > 0; --i) { size_t j = (size_t)rand() % (i + 1); string temp = arr[i]; arr[i] = arr[j]; arr[j] = temp;}
+    size_t threads = parallel_thread_count(num_threads, size);
+    if (size < PARALLEL_SORT_THRESHOLD || threads < 2 || !parallel_radix_sort(arr, size, false, threads)) sort_array(arr, size);
 }
 
-// O(n) average time, O(n) space. Caller must free returned array.
-int* array_unique_int(const int *arr, size_t size, size_t *new_size) {
-    if (new_size == NULL) return NULL;
-    if (arr == NULL || size == 0) { *new_size = 0; return NULL; }
-    HashTable *ht = ht_create(size);
-    if (!ht) { *new_size = 0; return NULL; } // Allocation failed
-    for (size_t i = 0; i < size; ++i) ht_insert(ht, arr[i]); // Populate counts
-    size_t unique_count = 0;
-    for (size_t i = 0; i < ht->table_size; ++i) { HashNode *current = ht->buckets[i]; while(current) { unique_count++; current = current->next;}}
-    *new_size = unique_count;
-    if (unique_count == 0) { ht_destroy(ht); return NULL; }
-    int *unique_arr = malloc(unique_count * sizeof(int));
-    if (unique_arr == NULL) { ht_destroy(ht); *new_size = 0; return NULL; } // Allocation failed
-    size_t k = 0;
-    for (size_t i = 0; i < ht->table_size; ++i) {
-        HashNode *current = ht->buckets[i];
-        while(current) { unique_arr[k++] = current->key; current = current->next;}
-    }
-    ht_destroy(ht);
-    return unique_arr; // Caller must free
+// O(n / threads) time per thread for large inputs. Same result as sort_array_double.
+void sort_array_double_parallel(double arr[], size_t size, int num_threads) {
+    if (arr == NULL || size < 2) return;
+    size_t threads = parallel_thread_count(num_threads, size);
+    if (size < PARALLEL_SORT_THRESHOLD || threads < 2 || !parallel_radix_sort(arr, size, true, threads)) sort_array_double(arr, size);
 }
 
-// O(size1 + size2) time. Caller must free.
-int* array_concat_int(const int *arr1, size_t size1, const int *arr2, size_t size2, size_t *new_size) {
-    if (new_size == NULL) return NULL;
-    size_t total_size = size1 + size2; *new_size = total_size;
-    if (total_size == 0) return NULL; // Cannot create empty array
-    int *concat_arr = malloc(total_size * sizeof(int));
-    if (concat_arr == NULL) { *new_size = 0; return NULL;} // Allocation failed
-    if (arr1 && size1 > 0) memcpy(concat_arr, arr1, size1 * sizeof(int));
-    if (arr2 && size2 > 0) memcpy(concat_arr + size1, arr2, size2 * sizeof(int));
-    return concat_arr; // Caller must free
+typedef struct StringSortTask {
+    string *src;
+    string *dst;
+    const size_t *bounds;   // Run boundaries for this round (runs + 1 entries)
+    size_t runs;
+    size_t begin, end;      // Chunk to sort, or output slice to merge
+} StringSortTask;
+
+static void *string_chunk_worker(void *arg) {
+    StringSortTask *t = arg;
+    sort_array_string(t->src + t->begin, t->end - t->begin);
+    return NULL;
 }
 
-// O(size1 + size2) time. Caller must free.
-float* array_concat_float(const float *arr1, size_t size1, const float *arr2, size_t size2, size_t *new_size) {
-    if (new_size == NULL) return NULL;
-    size_t total_size = size1 + size2; *new_size = total_size;
-    if (total_size == 0) return NULL;
-    float *concat_arr = malloc(total_size * sizeof(float));
-    if (concat_arr == NULL) { *new_size = 0; return NULL;}
-    if (arr1 && size1 > 0) memcpy(concat_arr, arr1, size1 * sizeof(float));
-    if (arr2 && size2 > 0) memcpy(concat_arr + size1, arr2, size2 * sizeof(float));
-    return concat_arr; // Caller must free
+// Number of elements taken from a (length na) among the first k outputs of a
+// stable merge of a and b (ties take from a first).
+static size_t merge_path_split(const string *a, size_t na, const string *b, size_t nb, size_t k) {
+    size_t lo = (k > nb) ? k - nb : 0, hi = (k < na) ? k : na;
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        if (compare_string(&a[i], &b[k - i - 1]) <= 0) lo = i + 1;
+        else hi = i;
+    }
+    return lo;
 }
 
-// O(size1 + size2) time. Caller must free.
-double* array_concat_double(const double *arr1, size_t size1, const double *arr2, size_t size2, size_t *new_size) {
-    if (new_size == NULL) return NULL;
-    size_t total_size = size1 + size2; *new_size = total_size;
-    if (total_size == 0) return NULL;
-    double *concat_arr = malloc(total_size * sizeof(double));
-    if (concat_arr == NULL) { *new_size = 0; return NULL;}
-    if (arr1 && size1 > 0) memcpy(concat_arr, arr1, size1 * sizeof(double));
-    if (arr2 && size2 > 0) memcpy(concat_arr + size1, arr2, size2 * sizeof(double));
-    return concat_arr; // Caller must free
+static void *string_merge_worker(void *arg) {
+    StringSortTask *t = arg;
+    for (size_t r = 0; r < t->runs; r += 2) {
+        size_t start = t->bounds[r], mid = t->bounds[r + 1];
+        size_t stop = (r + 2 <= t->runs) ? t->bounds[r + 2] : mid;
+        size_t lo = (t->begin > start) ? t->begin : start, hi = (t->end < stop) ? t->end : stop;
+        if (lo >= hi) continue;
+        const string *a = t->src + start, *b = t->src + mid;
+        size_t na = mid - start, nb = stop - mid;
+        size_t i = merge_path_split(a, na, b, nb, lo - start), i_end = merge_path_split(a, na, b, nb, hi - start);
+        size_t j = (lo - start) - i, j_end = (hi - start) - i_end;
+        string *out = t->dst + lo;
+        while (i < i_end && j < j_end) *out++ = (compare_string(&b[j], &a[i]) < 0) ? b[j++] : a[i++];
+        while (i < i_end) *out++ = a[i++];
+        while (j < j_end) *out++ = b[j++];
+    }
+    return NULL;
 }
 
-// O((size1 + size2) * L) time (deep copy). Caller must free using free_string_array.
-string* array_concat_string(const string *arr1, size_t size1, const string *arr2, size_t size2, size_t *new_size) {
-    if (new_size == NULL) return NULL;
-    size_t total_size = size1 + size2; *new_size = total_size;
-    if (total_size == 0) return NULL;
-    string *concat_arr = malloc(total_size * sizeof(string));
-    if (concat_arr == NULL) { *new_size = 0; return NULL;}
-    for(size_t i=0; i < size1; ++i) { concat_arr[i] = string_copy(arr1 ? arr1[i] : NULL); if (concat_arr[i] == NULL && (arr1 ? arr1[i] : NULL) != NULL) { for(size_t k=0; k<i; ++k) free(concat_arr[k]); free(concat_arr); *new_size=0; return NULL;} } // Copy arr1, handle fail
-    for(size_t i=0; i < size2; ++i) { concat_arr[size1 + i] = string_copy(arr2 ? arr2[i] : NULL); if (concat_arr[size1+i] == NULL && (arr2 ? arr2[i] : NULL) != NULL) { for(size_t k=0; k<(size1+i); ++k) free(concat_arr[k]); free(concat_arr); *new_size=0; return NULL;} } // Copy arr2, handle fail
-    return concat_arr; // Caller must free using free_string_array
+// O((n log n) / threads + n log threads) comparisons. Same order as sort_array_string.
+void sort_array_string_parallel(string arr[], size_t size, int num_threads) {
+    if (arr == NULL || size < 2) return;
+    size_t threads = parallel_thread_count(num_threads, size);
+    StringSortTask *tasks = NULL;
+    size_t *bounds = NULL;
+    string *scratch = NULL;
+    if (size >= PARALLEL_SORT_THRESHOLD && threads >= 2) {
+        tasks = calloc(threads, sizeof(StringSortTask));
+        bounds = malloc((threads + 1) * sizeof(size_t));
+        scratch = malloc(size * sizeof(string));
+    }
+    if (tasks == NULL || bounds == NULL || scratch == NULL) {
+        free(tasks); free(bounds); free(scratch);
+        sort_array_string(arr, size);
+        return;
+    }
+    for (size_t t = 0; t <= threads; ++t) bounds[t] = size * t / threads;
+    for (size_t t = 0; t < threads; ++t) { tasks[t].src = arr; tasks[t].begin = bounds[t]; tasks[t].end = bounds[t + 1]; }
+    run_parallel(string_chunk_worker, tasks, sizeof(StringSortTask), threads);
+
+    string *src = arr, *dst = scratch;
+    for (size_t runs = threads; runs > 1; runs = (runs + 1) / 2) {
+        for (size_t t = 0; t < threads; ++t) {
+            tasks[t].src = src; tasks[t].dst = dst; tasks[t].bounds = bounds; tasks[t].runs = runs;
+            tasks[t].begin = size * t / threads; tasks[t].end = size * (t + 1) / threads;
+        }
+        run_parallel(string_merge_worker, tasks, sizeof(StringSortTask), threads);
+        for (size_t r = 0; r <= (runs + 1) / 2; ++r) bounds[r] = bounds[(2 * r < runs) ? 2 * r : runs];
+        string *tmp = src; src = dst; dst = tmp;
+    }
+    if (src != arr) memcpy(arr, src, size * sizeof(string));
+    free(tasks); free(bounds); free(scratch);
 }
 
 
@@ -930,27 +6141,29 @@ string* array_concat_string(const string *arr1, size_t size1, const string *arr2
 // ... (string_concat, string_substring, string_find_char, etc. - unchanged) ...
 // O(L1 + L2) time. Caller must free.
 string string_concat(const string s1, const string s2) {
+    return string_concat_a(NULL, s1, s2);
+}
+
+// O(L1 + L2) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_concat_a(aq_arena *arena, const string s1, const string s2) {
     if (s1 == NULL && s2 == NULL) return NULL;
     size_t len1 = (s1 == NULL) ? 0 : strlen(s1);
     size_t len2 = (s2 == NULL) ? 0 : strlen(s2);
-    size_t total_len = len1 + len2;
-    string new_s = malloc(total_len + 1);
-    if (new_s == NULL) return NULL; // Allocation failed
-    if (s1 != NULL) memcpy(new_s, s1, len1);
-    if (s2 != NULL) memcpy(new_s + len1, s2, len2 + 1);
-    else new_s[total_len] = '\0';
-    return new_s; // Caller must free
+    return concat_bytes(arena, s1, len1, s2, len2); // Caller must free
 }
 
 // O(L) time. Caller must free.
 string string_substring(const string s, size_t start, size_t length) {
-    if (s == NULL) return NULL; size_t s_len = strlen(s);
-    if (start > s_len) start = s_len; if (start + length > s_len) length = s_len - start;
-    if (length == 0) { string empty_s = malloc(1); if (empty_s) *empty_s = '\0'; return empty_s; } // Return "" or NULL
-    string sub_s = malloc(length + 1);
-    if (sub_s == NULL) return NULL; // Allocation failed
-    memcpy(sub_s, s + start, length); sub_s[length] = '\0';
-    return sub_s; // Caller must free
+    return string_substring_a(NULL, s, start, length);
+}
+
+// O(L) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_substring_a(aq_arena *arena, const string s, size_t start, size_t length) {
+    if (s == NULL) return NULL;
+    size_t s_len = strlen(s);
+    if (start > s_len) start = s_len;
+    if (length > s_len - start) length = s_len - start;
+    return copy_bytes(arena, s + start, length); // Caller must free
 }
 
 // O(L) time. Returns index or -1.
@@ -972,27 +6185,80 @@ int string_find_substring(const string haystack, const string needle) {
 
 // O(L) time. Caller must free.
 string string_replace_char(const string s, char old_char, char new_char) {
+    return string_replace_char_a(NULL, s, old_char, new_char);
+}
+
+// O(L) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_replace_char_a(aq_arena *arena, const string s, char old_char, char new_char) {
     if (s == NULL) return NULL;
-    string new_s = string_copy(s); // Start with a copy
+    string new_s = string_copy_a(arena, s); // Start with a copy
     if (new_s == NULL) return NULL;
     for (size_t i = 0; new_s[i] != '\0'; ++i) { if (new_s[i] == old_char) new_s[i] = new_char; }
     return new_s; // Caller must free
 }
 
+// O(L) expected time, one allocation. Replaces every non-overlapping from, left to right. Caller must free.
+string string_replace_all(const string s, const string from, const string to) {
+    return string_replace_all_a(NULL, s, from, to);
+}
+
+// O(L) expected time. Result lives in the arena (malloc'd when arena is NULL).
+string string_replace_all_a(aq_arena *arena, const string s, const string from, const string to) {
+    if (s == NULL) return NULL;
+    size_t len = strlen(s), out_len;
+    if (from == NULL || *from == '\0') return copy_bytes(arena, s, len); // Nothing to replace
+    return replace_bytes(arena, s, len, from, strlen(from), (to == NULL) ? "" : to, (to == NULL) ? 0 : strlen(to), &out_len);
+}
+
+// O(L) expected time, no allocation. Needs strlen(to) <= strlen(from); returns the number of replacements.
+size_t string_replace_all_in_place(string s, const string from, const string to) {
+    if (s == NULL || from == NULL || *from == '\0') return 0;
+    size_t from_len = strlen(from), to_len = (to == NULL) ? 0 : strlen(to), count = 0;
+    if (to_len > from_len) return 0; // Would grow the string
+    char *end = s + strlen(s), *r = s, *w = s;
+    const char *hit;
+    while ((hit = find_bytes(r, end, from, from_len)) != NULL) {
+        size_t keep = (size_t)(hit - r);
+        if (w != r) memmove(w, r, keep); // Equal lengths never shift, so the text stays put
+        w += keep;
+        if (to_len > 0) { memcpy(w, to, to_len); w += to_len; }
+        r += keep + from_len;
+        count++;
+    }
+    if (w != r) memmove(w, r, (size_t)(end - r) + 1); // Tail and terminator
+    return count;
+}
+
 // O(L) time. Caller must free.
 string string_to_lower(const string s) {
-    if (s == NULL) return NULL; size_t len = strlen(s);
-    string new_s = malloc(len + 1); if (new_s == NULL) return NULL;
-    for (size_t i = 0; i <= len; ++i) new_s[i] = (char)tolower((unsigned char)s[i]);
-    return new_s; // Caller must free
+    return string_to_lower_a(NULL, s);
+}
+
+// O(L) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_to_lower_a(aq_arena *arena, const string s) {
+    if (s == NULL) return NULL;
+    return case_bytes(arena, s, strlen(s), false); // Caller must free
 }
 
 // O(L) time. Caller must free.
 string string_to_upper(const string s) {
-    if (s == NULL) return NULL; size_t len = strlen(s);
-    string new_s = malloc(len + 1); if (new_s == NULL) return NULL;
-    for (size_t i = 0; i <= len; ++i) new_s[i] = (char)toupper((unsigned char)s[i]);
-    return new_s; // Caller must free
+    return string_to_upper_a(NULL, s);
+}
+
+// O(L) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_to_upper_a(aq_arena *arena, const string s) {
+    if (s == NULL) return NULL;
+    return case_bytes(arena, s, strlen(s), true); // Caller must free
+}
+
+// O(L) time, no allocation. Converts the caller's buffer.
+void string_to_lower_in_place(string s) {
+    if (s != NULL) convert_case(s, s, strlen(s), false);
+}
+
+// O(L) time, no allocation. Converts the caller's buffer.
+void string_to_upper_in_place(string s) {
+    if (s != NULL) convert_case(s, s, strlen(s), true);
 }
 
 // O(L) time. Caller must free returned array AND strings using free_string_array.
@@ -1023,20 +6289,50 @@ string* string_split(const string s, char delimiter, size_t *num_tokens) {
     return tokens; // Caller must free using free_string_array
 }
 
+// O(L) time. Tokens and the array live in the arena (string_split when arena is NULL).
+// One copy of s is cut in place at each delimiter, so the arena sees two allocations.
+string* string_split_a(aq_arena *arena, const string s, char delimiter, size_t *num_tokens) {
+    if (arena == NULL) return string_split(s, delimiter, num_tokens);
+    if (s == NULL || num_tokens == NULL) { if(num_tokens) *num_tokens = 0; return NULL; }
+    size_t s_len = strlen(s); size_t token_count = 1;
+    for (const char *p = s; (p = memchr(p, delimiter, s_len - (size_t)(p - s))) != NULL; ++p) token_count++;
+    if (delimiter == '\0') token_count = 1; // strchr semantics: the terminator is not a delimiter
+
+    string* tokens = aq_arena_alloc(arena, token_count * sizeof(string));
+    string text = aq_arena_alloc(arena, s_len + 1);
+    if (tokens == NULL || text == NULL) { *num_tokens = 0; return NULL; } // Arena keeps any partial allocation
+    memcpy(text, s, s_len + 1);
+
+    string current_pos = text;
+    for (size_t i = 0; i + 1 < token_count; ++i) {
+        string next_delimiter = memchr(current_pos, delimiter, s_len - (size_t)(current_pos - text));
+        *next_delimiter = '\0';
+        tokens[i] = current_pos; current_pos = next_delimiter + 1;
+    }
+    tokens[token_count - 1] = current_pos;
+    *num_tokens = token_count;
+    return tokens; // Released with the arena
+}
+
 // O(n * L + n*S) time (S is separator length). Caller must free.
 string string_join(const string *arr, size_t size, const string separator) {
-    if (arr == NULL || size == 0) { string empty_s = malloc(1); if(empty_s) *empty_s = '\0'; return empty_s; } // Return "" or NULL
+    return string_join_a(NULL, arr, size, separator);
+}
+
+// O(n * L + n*S) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_join_a(aq_arena *arena, const string *arr, size_t size, const string separator) {
+    aq_strbuf sb;
+    aq_strbuf_init_a(&sb, arena);
+    if (arr == NULL || size == 0) return aq_strbuf_release(&sb); // Return "" or NULL
     size_t total_len = 0; size_t sep_len = (separator == NULL) ? 0 : strlen(separator);
     for (size_t i = 0; i < size; ++i) { if (arr[i] != NULL) total_len += strlen(arr[i]); if (i < size - 1) total_len += sep_len;}
-    string result_s = malloc(total_len + 1);
-    if (result_s == NULL) return NULL; // Allocation failed
+    if (!aq_strbuf_reserve(&sb, total_len)) return NULL; // One exact allocation
 
-    size_t current_pos = 0;
     for (size_t i = 0; i < size; ++i) {
-        if (arr[i] != NULL) { size_t len = strlen(arr[i]); memcpy(result_s + current_pos, arr[i], len); current_pos += len;}
-        if (i < size - 1 && separator != NULL) { memcpy(result_s + current_pos, separator, sep_len); current_pos += sep_len;}
-    } result_s[total_len] = '\0';
-    return result_s; // Caller must free
+        aq_strbuf_append_string(&sb, arr[i]);
+        if (i < size - 1) aq_strbuf_append(&sb, separator, sep_len);
+    }
+    return aq_strbuf_release(&sb); // Caller must free
 }
 
 // O(min(L, P)) time.
@@ -1060,65 +6356,594 @@ bool string_is_empty(const string s) {
     return s == NULL || *s == '\0';
 }
 
-// O(L) time. Uses local pointer copy.
+// O(L) time. ASCII is checked 16-32 bytes per step; other bytes use isalpha.
 bool string_is_alpha(const string s) {
-    if (s == NULL || *s == '\0') return false;
-    const char *p = s; // Use local pointer copy
-    while (*p) {
-        if (!isalpha((unsigned char)*p)) return false;
-        p++; // Increment copy
-    }
-    return true;
+    return all_bytes_in_class(s, ASCII_ALPHA, isalpha);
 }
-// O(L) time. Uses local pointer copy.
+// O(L) time. ASCII is checked 16-32 bytes per step; other bytes use isdigit.
 bool string_is_digit(const string s) {
-     if (s == NULL || *s == '\0') return false;
-    const char *p = s; // Use local pointer copy
-    while (*p) {
-        if (!isdigit((unsigned char)*p)) return false;
-        p++; // Increment copy
-    }
-    return true;
+    return all_bytes_in_class(s, ASCII_DIGIT, isdigit);
 }
-// O(L) time. Uses local pointer copy.
+// O(L) time. ASCII is checked 16-32 bytes per step; other bytes use isalnum.
 bool string_is_alnum(const string s) {
-     if (s == NULL || *s == '\0') return false;
-    const char *p = s; // Use local pointer copy
-    while (*p) {
-        if (!isalnum((unsigned char)*p)) return false;
-        p++; // Increment copy
-    }
-    return true;
+    return all_bytes_in_class(s, ASCII_ALPHA | ASCII_DIGIT, isalnum);
 }
-// O(L) time. Uses local pointer copy.
+// O(L) time. ASCII is checked 16-32 bytes per step; other bytes use isspace.
 bool string_is_space(const string s) {
-     if (s == NULL || *s == '\0') return false;
-    const char *p = s; // Use local pointer copy
-    while (*p) {
-        if (!isspace((unsigned char)*p)) return false;
-        p++; // Increment copy
-    }
-    return true;
+    return all_bytes_in_class(s, ASCII_SPACE, isspace);
 }
 
 // O(L) time. Use success flag to check conversion.
 float string_to_float(const string s, bool *success) {
-    if (s == NULL || *s == '\0') { if (success) *success = false; return 0.0f; }
-    char *endptr; errno = 0; float f = strtof(s, &endptr);
-    if (endptr == s || (errno == ERANGE && (f == HUGE_VALF || f == -HUGE_VALF || f == 0))) { if (success) *success = false; return 0.0f; }
-    char *check_ptr = endptr; while (isspace((unsigned char)*check_ptr)) check_ptr++;
-    if (*check_ptr != '\0') { if (success) *success = false; return 0.0f; }
-    if (success) *success = true; return f;
+    float f = 0.0f;
+    bool ok = parse_float_line(s, &f) == PARSE_OK; // Same rules as get_float
+    if (success) *success = ok;
+    return ok ? f : 0.0f;
 }
 
 // O(L) time. Use success flag to check conversion.
 double string_to_double(const string s, bool *success) {
-     if (s == NULL || *s == '\0') { if (success) *success = false; return 0.0; }
-    char *endptr; errno = 0; double d = strtod(s, &endptr);
-    if (endptr == s || (errno == ERANGE && (d == HUGE_VAL || d == -HUGE_VAL || d == 0))) { if (success) *success = false; return 0.0; }
-    char *check_ptr = endptr; while (isspace((unsigned char)*check_ptr)) check_ptr++;
-    if (*check_ptr != '\0') { if (success) *success = false; return 0.0; }
-    if (success) *success = true; return d;
+    double d = 0.0;
+    bool ok = parse_double_line(s, &d) == PARSE_OK; // Same rules as get_double
+    if (success) *success = ok;
+    return ok ? d : 0.0;
+}
+
+
+// --- String Views ---
+// Zero-copy splitting: tokens are (ptr, len) views into the caller's text.
+// Single-byte delimiters and delimiter sets go through the set_mask kernel,
+// 64 bytes at a time; the tokenizer keeps the current mask, so short tokens
+// cost a bit scan rather than a new vector search each. Multi-byte
+// delimiters use the find kernel.
+enum { TOKENIZE_CHAR, TOKENIZE_STR, TOKENIZE_ANY };
+
+static void tokenizer_start(aq_tokenizer *tok, const char *s, size_t length, const char *delim, size_t delim_len, int mode) {
+    tok->pos = s;
+    tok->end = (s == NULL) ? NULL : s + length;
+    tok->delim = delim;
+    tok->delim_len = delim_len;
+    tok->mode = mode;
+    tok->done = (s == NULL);
+    tok->window = NULL;
+    tok->mask = 0;
+}
+
+// O(1) time. Splits s[0..length) at every occurrence of delimiter.
+void aq_tokenizer_init(aq_tokenizer *tok, const char *s, size_t length, char delimiter) {
+    if (tok == NULL) return;
+    memset(tok->set_bits, 0, sizeof(tok->set_bits));
+    unsigned char c = (unsigned char)delimiter;
+    tok->set_bits[c >> 3] = (unsigned char)(1u << (c & 7));
+    tok->single = delimiter;
+    tokenizer_start(tok, s, length, NULL, 1, TOKENIZE_CHAR);
+}
+
+// O(D) time. Splits at every non-overlapping occurrence of the delimiter string (empty or NULL: no split).
+void aq_tokenizer_init_str(aq_tokenizer *tok, const char *s, size_t length, const char *delimiter) {
+    if (tok == NULL) return;
+    tokenizer_start(tok, s, length, delimiter, (delimiter == NULL) ? 0 : strlen(delimiter), TOKENIZE_STR);
+}
+
+// O(D) time. Splits at every byte that occurs in delimiters (empty or NULL: no split).
+void aq_tokenizer_init_any(aq_tokenizer *tok, const char *s, size_t length, const char *delimiters) {
+    if (tok == NULL) return;
+    memset(tok->set_bits, 0, sizeof(tok->set_bits));
+    size_t count = 0;
+    if (delimiters != NULL) {
+        for (; delimiters[count] != '\0'; ++count) {
+            unsigned char c = (unsigned char)delimiters[count];
+            tok->set_bits[c >> 3] |= (unsigned char)(1u << (c & 7));
+        }
+    }
+    tokenizer_start(tok, s, length, delimiters, count, TOKENIZE_ANY);
+}
+
+// Next set byte at or after start, or NULL. Reuses the tokenizer's current 64-byte mask.
+static const char* tokenizer_find_set(aq_tokenizer *tok, const char *start) {
+    const char *set = (tok->mode == TOKENIZE_CHAR) ? &tok->single : tok->delim;
+    if (tok->window == NULL || start >= tok->window + SET_MASK_WINDOW) {
+        tok->window = start;
+        size_t n = (size_t)(tok->end - start);
+        tok->mask = aq_string_kernels.set_mask(start, (n < SET_MASK_WINDOW) ? n : SET_MASK_WINDOW, set, tok->delim_len, tok->set_bits);
+    }
+    for (;;) {
+        uint64_t mask = tok->mask;
+        if (start > tok->window) mask &= ~(uint64_t)0 << (start - tok->window);
+        if (mask != 0) return tok->window + trailing_zeros_64(mask);
+        if (tok->end - tok->window <= SET_MASK_WINDOW) return NULL;
+        tok->window += SET_MASK_WINDOW;
+        size_t n = (size_t)(tok->end - tok->window);
+        tok->mask = aq_string_kernels.set_mask(tok->window, (n < SET_MASK_WINDOW) ? n : SET_MASK_WINDOW, set, tok->delim_len, tok->set_bits);
+    }
+}
+
+// O(token length) time. Views point into the tokenized text; n delimiters give n + 1 tokens.
+bool aq_tokenizer_next(aq_tokenizer *tok, aq_strview *token) {
+    if (tok == NULL || tok->done) return false;
+    const char *start = tok->pos, *hit = NULL;
+    size_t skip = 1;
+    if (tok->mode == TOKENIZE_STR) {
+        if (tok->delim_len > 0) hit = find_bytes(start, tok->end, tok->delim, tok->delim_len);
+        skip = tok->delim_len;
+    } else if (tok->delim_len > 0) {
+        hit = tokenizer_find_set(tok, start);
+    }
+    if (hit == NULL) { hit = tok->end; tok->done = true; }
+    else tok->pos = hit + skip;
+    if (token != NULL) { token->ptr = start; token->len = (size_t)(hit - start); }
+    return true;
+}
+
+// Shared body of the string_split_view* functions: total token count, first max_views stored.
+static size_t split_view_fill(aq_tokenizer *tok, aq_strview *views, size_t max_views) {
+    size_t count = 0;
+    aq_strview token;
+    while (aq_tokenizer_next(tok, &token)) {
+        if (views != NULL && count < max_views) views[count] = token;
+        count++;
+    }
+    return count;
+}
+
+// O(L) time. Returns the token count (0 for NULL); stores at most max_views views.
+size_t string_split_view(const string s, char delimiter, aq_strview *views, size_t max_views) {
+    aq_tokenizer tok;
+    aq_tokenizer_init(&tok, s, (s == NULL) ? 0 : strlen(s), delimiter);
+    return split_view_fill(&tok, views, max_views);
+}
+
+// O(L + D) time. Like string_split_view with a multi-byte delimiter.
+size_t string_split_view_str(const string s, const string delimiter, aq_strview *views, size_t max_views) {
+    aq_tokenizer tok;
+    aq_tokenizer_init_str(&tok, s, (s == NULL) ? 0 : strlen(s), delimiter);
+    return split_view_fill(&tok, views, max_views);
+}
+
+// O(L + D) time. Like string_split_view, splitting at any byte of delimiters.
+size_t string_split_view_any(const string s, const string delimiters, aq_strview *views, size_t max_views) {
+    aq_tokenizer tok;
+    aq_tokenizer_init_any(&tok, s, (s == NULL) ? 0 : strlen(s), delimiters);
+    return split_view_fill(&tok, views, max_views);
+}
+
+// O(V) time. Result lives in the arena (malloc'd when arena is NULL).
+string string_view_copy_a(aq_arena *arena, aq_strview view) {
+    if (view.ptr == NULL && view.len > 0) return NULL;
+    return copy_bytes(arena, view.ptr, view.len);
+}
+
+// O(V) time. Compares the view's bytes with a null-terminated string.
+bool string_view_equals(aq_strview view, const string s) {
+    if (s == NULL) return false;
+    size_t len = strlen(s);
+    return len == view.len && (len == 0 || memcmp(view.ptr, s, len) == 0);
+}
+
+
+// --- Length-Carrying Strings ---
+// aq_str caches the length next to the pointer, so these functions never call
+// strlen on their inputs and every result carries its length forward. ptr[len]
+// is always '\0', which makes s.ptr usable anywhere a string is expected.
+// cap > 0 marks an owned malloc'd buffer of cap bytes; cap == 0 is borrowed.
+static inline aq_str str_owned(string ptr, size_t len) {
+    aq_str s = { ptr, (ptr == NULL) ? 0 : len, (ptr == NULL) ? 0 : len + 1 };
+    return s;
+}
+
+// O(L) time (one strlen). Borrows s; nothing is copied.
+aq_str aq_str_from(const string s) {
+    aq_str result = { s, (s == NULL) ? 0 : strlen(s), 0 };
+    return result;
+}
+
+// O(L) time. Owned, null-terminated copy of len bytes.
+aq_str aq_str_copy(const char *data, size_t len) {
+    if (data == NULL && len > 0) return str_owned(NULL, 0);
+    return str_owned(copy_bytes(NULL, data, len), len);
+}
+
+// O(L) time (one strlen). Takes ownership of a malloc'd string such as a string_* result.
+aq_str aq_str_take(string s) {
+    return str_owned(s, (s == NULL) ? 0 : strlen(s));
+}
+
+// O(1) for owned strings (O(L) copy for borrowed ones). Caller must free; *s is reset.
+string aq_str_release(aq_str *s) {
+    if (s == NULL || s->ptr == NULL) return NULL;
+    string result = (s->cap > 0) ? s->ptr : copy_bytes(NULL, s->ptr, s->len);
+    s->ptr = NULL; s->len = 0; s->cap = 0;
+    return result;
+}
+
+// O(1) time. Frees an owned string (borrowed ones are left alone); *s is reset.
+void aq_str_free(aq_str *s) {
+    if (s == NULL) return;
+    if (s->cap > 0) free(s->ptr);
+    s->ptr = NULL; s->len = 0; s->cap = 0;
+}
+
+// O(1) time.
+aq_strview aq_str_view(aq_str s) {
+    aq_strview view = { s.ptr, s.len };
+    return view;
+}
+
+// O(L1 + L2) time. Owned result; empty (ptr NULL) only when both inputs are.
+aq_str aq_str_concat(aq_str a, aq_str b) {
+    if (a.ptr == NULL && b.ptr == NULL) return str_owned(NULL, 0);
+    return str_owned(concat_bytes(NULL, a.ptr, a.len, b.ptr, b.len), a.len + b.len);
+}
+
+// O(length) time. Owned result, clamped like string_substring.
+aq_str aq_str_substring(aq_str s, size_t start, size_t length) {
+    if (s.ptr == NULL) return str_owned(NULL, 0);
+    if (start > s.len) start = s.len;
+    if (length > s.len - start) length = s.len - start;
+    return str_owned(copy_bytes(NULL, s.ptr + start, length), length);
+}
+
+// O(L) time. Owned result.
+aq_str aq_str_trim(aq_str s) {
+    if (s.ptr == NULL) return str_owned(NULL, 0);
+    size_t start;
+    size_t len = trim_bounds(s.ptr, s.len, &start);
+    return str_owned(copy_bytes(NULL, s.ptr + start, len), len);
+}
+
+// O(L) time. Owned result.
+aq_str aq_str_to_lower(aq_str s) {
+    if (s.ptr == NULL) return str_owned(NULL, 0);
+    return str_owned(case_bytes(NULL, s.ptr, s.len, false), s.len);
+}
+
+// O(L) time. Owned result.
+aq_str aq_str_to_upper(aq_str s) {
+    if (s.ptr == NULL) return str_owned(NULL, 0);
+    return str_owned(case_bytes(NULL, s.ptr, s.len, true), s.len);
+}
+
+// O(total length) time, one allocation and one pass over the bytes. Owned result.
+aq_str aq_str_join(const aq_str *arr, size_t size, aq_str separator) {
+    if (arr == NULL || size == 0) return str_owned(copy_bytes(NULL, "", 0), 0);
+    size_t total_len = separator.len * (size - 1);
+    if (separator.len != 0 && total_len / separator.len != size - 1) return str_owned(NULL, 0); // Overflow
+    for (size_t i = 0; i < size; ++i) {
+        if (arr[i].len > SIZE_MAX - 1 - total_len) return str_owned(NULL, 0);
+        total_len += arr[i].len;
+    }
+    aq_strbuf sb;
+    aq_strbuf_init(&sb);
+    if (!aq_strbuf_reserve(&sb, total_len)) return str_owned(NULL, 0);
+    for (size_t i = 0; i < size; ++i) {
+        if (i > 0) aq_strbuf_append_str(&sb, separator);
+        aq_strbuf_append_str(&sb, arr[i]);
+    }
+    return aq_strbuf_release_str(&sb);
+}
+
+// O(L) time; O(1) when the lengths differ.
+bool aq_str_equals(aq_str a, aq_str b) {
+    if (a.ptr == NULL || b.ptr == NULL) return a.ptr == b.ptr;
+    return a.len == b.len && (a.ptr == b.ptr || memcmp(a.ptr, b.ptr, a.len) == 0);
+}
+
+// O(P) time.
+bool aq_str_starts_with(aq_str s, aq_str prefix) {
+    if (s.ptr == NULL || prefix.ptr == NULL) return false;
+    return prefix.len <= s.len && memcmp(s.ptr, prefix.ptr, prefix.len) == 0;
+}
+
+// O(S) time.
+bool aq_str_ends_with(aq_str s, aq_str suffix) {
+    if (s.ptr == NULL || suffix.ptr == NULL) return false;
+    return suffix.len <= s.len && memcmp(s.ptr + s.len - suffix.len, suffix.ptr, suffix.len) == 0;
+}
+
+// O(L_haystack + candidates * L_needle) time. true if needle occurs; *offset gets the first match.
+bool aq_str_find(aq_str haystack, aq_str needle, size_t *offset) {
+    if (haystack.ptr == NULL || needle.ptr == NULL) return false;
+    const char *hit = (needle.len == 0) ? haystack.ptr : find_bytes(haystack.ptr, haystack.ptr + haystack.len, needle.ptr, needle.len);
+    if (hit == NULL) return false;
+    if (offset != NULL) *offset = (size_t)(hit - haystack.ptr);
+    return true;
+}
+
+// O(L) expected time. Owned result; an empty from leaves s unchanged.
+aq_str aq_str_replace_all(aq_str s, aq_str from, aq_str to) {
+    if (s.ptr == NULL) return str_owned(NULL, 0);
+    if (from.ptr == NULL || from.len == 0) return str_owned(copy_bytes(NULL, s.ptr, s.len), s.len);
+    size_t out_len = 0;
+    string out = replace_bytes(NULL, s.ptr, s.len, from.ptr, from.len, (to.ptr == NULL) ? "" : to.ptr, to.len, &out_len);
+    return str_owned(out, out_len);
+}
+
+
+// --- Substring Search ---
+// string_find_all steps libc strstr, which already scans a NUL-terminated
+// haystack with SIMD and needs no separate strlen pass; aq_str_find, whose
+// lengths are known, runs on the find kernel.
+// aq_matcher is an Aho-Corasick automaton for many patterns at once. The trie's
+// failure links are folded into a full transition table at build time, so a
+// scan is one table load per text byte whatever the number of patterns. Bytes
+// that occur in no pattern share one column (byte classes), which keeps rows
+// short. Table entries hold the target row's offset shifted left by one, with
+// bit 0 set when some pattern ends in that state. While the automaton sits in
+// the root state, a scan jumps to the next byte that starts some pattern with
+// the set_mask kernel, when the patterns have few distinct first bytes.
+#define MATCHER_MISSING UINT32_MAX
+#define MATCHER_SKIP_PROBE 64 // Root-state jumps measured before deciding to keep skipping
+#define MATCHER_SKIP_MIN 16   // Average bytes per jump needed to keep skipping
+
+struct aq_matcher {
+    uint8_t byte_class[256];
+    size_t classes;
+    uint32_t *delta;       // states * classes entries: (row offset << 1) | has_output
+    int32_t *match;        // Per state: lowest pattern ending exactly here, or -1
+    uint32_t *out_link;    // Per state: nearest state on the failure chain with a match (0: none)
+    size_t states;
+    size_t pattern_count;
+    size_t *pattern_len;
+    int32_t *same_next;    // Next pattern with the same text, or -1
+    char first[AQ_SET_SIMD_MAX];      // Distinct first bytes of the patterns
+    size_t first_count;               // 0: too many first bytes, no skipping
+    unsigned char first_bits[32];
+};
+
+// O(L_haystack * L_needle) worst case, typically linear. Offsets of every (possibly overlapping) match, ascending. Caller must free.
+size_t* string_find_all(const string haystack, const string needle, size_t *count) {
+    if (count == NULL) return NULL;
+    *count = 0;
+    if (haystack == NULL || needle == NULL || *needle == '\0') return NULL;
+    size_t found = 0, capacity = 0;
+    const char *p = haystack, *hit;
+    size_t *offsets = NULL;
+    while ((hit = strstr(p, needle)) != NULL) {
+        if (found == capacity) {
+            size_t new_capacity = (capacity == 0) ? 16 : capacity * 2;
+            size_t *temp = realloc(offsets, new_capacity * sizeof(size_t));
+            if (temp == NULL) { free(offsets); return NULL; } // Allocation failed
+            offsets = temp; capacity = new_capacity;
+        }
+        offsets[found++] = (size_t)(hit - haystack);
+        p = hit + 1;
+    }
+    if (found < capacity && found > 0) { size_t *temp = realloc(offsets, found * sizeof(size_t)); if (temp != NULL) offsets = temp; }
+    *count = found;
+    return offsets; // NULL when there is no match
+}
+
+static bool matcher_add_state(aq_matcher *m, size_t *capacity) {
+    if (m->states == *capacity) {
+        size_t new_capacity = *capacity * 2;
+        if (new_capacity > (UINT32_MAX / 2) / m->classes) return false; // Row offsets must fit the table entries
+        uint32_t *delta = realloc(m->delta, new_capacity * m->classes * sizeof(uint32_t));
+        if (delta != NULL) m->delta = delta;
+        int32_t *match = realloc(m->match, new_capacity * sizeof(int32_t));
+        if (match != NULL) m->match = match;
+        if (delta == NULL || match == NULL) return false;
+        *capacity = new_capacity;
+    }
+    for (size_t c = 0; c < m->classes; ++c) m->delta[m->states * m->classes + c] = MATCHER_MISSING;
+    m->match[m->states] = -1;
+    m->states++;
+    return true;
+}
+
+// O(total pattern length * distinct pattern bytes) time and space. NULL and empty patterns never match.
+aq_matcher* aq_matcher_create(const string *patterns, size_t count) {
+    if (patterns == NULL || count == 0 || count > INT32_MAX) return NULL;
+    aq_matcher *m = calloc(1, sizeof(aq_matcher));
+    if (m == NULL) return NULL;
+    m->pattern_count = count;
+    m->pattern_len = malloc(count * sizeof(size_t));
+    m->same_next = malloc(count * sizeof(int32_t));
+    if (m->pattern_len == NULL || m->same_next == NULL) { aq_matcher_destroy(m); return NULL; }
+    bool used[256] = { false };
+    for (size_t p = 0; p < count; ++p) {
+        m->pattern_len[p] = (patterns[p] == NULL) ? 0 : strlen(patterns[p]);
+        m->same_next[p] = -1;
+        for (size_t i = 0; i < m->pattern_len[p]; ++i) used[(unsigned char)patterns[p][i]] = true;
+    }
+    for (size_t p = 0; p < count; ++p) {
+        if (m->pattern_len[p] == 0) continue;
+        unsigned char c = (unsigned char)patterns[p][0];
+        if (byte_in_set(m->first_bits, c)) continue;
+        m->first_bits[c >> 3] |= (unsigned char)(1u << (c & 7));
+        if (m->first_count < AQ_SET_SIMD_MAX) m->first[m->first_count] = (char)c;
+        m->first_count++;
+    }
+    if (m->first_count > AQ_SET_SIMD_MAX) m->first_count = 0;
+    m->classes = 1; // Class 0: bytes in no pattern
+    for (int b = 0; b < 256; ++b) m->byte_class[b] = used[b] ? (uint8_t)m->classes++ : 0;
+
+    // Trie
+    size_t capacity = 64;
+    if (capacity > (UINT32_MAX / 2) / m->classes) { aq_matcher_destroy(m); return NULL; }
+    m->delta = malloc(capacity * m->classes * sizeof(uint32_t));
+    m->match = malloc(capacity * sizeof(int32_t));
+    if (m->delta == NULL || m->match == NULL || !matcher_add_state(m, &capacity)) { aq_matcher_destroy(m); return NULL; }
+    for (size_t p = 0; p < count; ++p) {
+        if (m->pattern_len[p] == 0) continue;
+        size_t s = 0;
+        for (size_t i = 0; i < m->pattern_len[p]; ++i) {
+            uint32_t *slot = &m->delta[s * m->classes + m->byte_class[(unsigned char)patterns[p][i]]];
+            if (*slot == MATCHER_MISSING) {
+                if (!matcher_add_state(m, &capacity)) { aq_matcher_destroy(m); return NULL; }
+                slot = &m->delta[s * m->classes + m->byte_class[(unsigned char)patterns[p][i]]]; // delta may have moved
+                *slot = (uint32_t)(m->states - 1);
+            }
+            s = *slot;
+        }
+        if (m->match[s] < 0) m->match[s] = (int32_t)p;
+        else { int32_t q = m->match[s]; while (m->same_next[q] >= 0) q = m->same_next[q]; m->same_next[q] = (int32_t)p; }
+    }
+
+    // Failure links in BFS order, folded into the table; rows of shallower states are complete first
+    uint32_t *fail = malloc(m->states * sizeof(uint32_t));
+    uint32_t *queue = malloc(m->states * sizeof(uint32_t));
+    m->out_link = malloc(m->states * sizeof(uint32_t));
+    if (fail == NULL || queue == NULL || m->out_link == NULL) { free(fail); free(queue); aq_matcher_destroy(m); return NULL; }
+    size_t head = 0, tail = 0, C = m->classes;
+    fail[0] = 0; m->out_link[0] = 0;
+    for (size_t c = 0; c < C; ++c) {
+        uint32_t t = m->delta[c];
+        if (t == MATCHER_MISSING) { m->delta[c] = 0; continue; }
+        fail[t] = 0; m->out_link[t] = 0; queue[tail++] = t;
+    }
+    while (head < tail) {
+        uint32_t s = queue[head++];
+        for (size_t c = 0; c < C; ++c) {
+            uint32_t t = m->delta[s * C + c];
+            uint32_t via_fail = m->delta[fail[s] * C + c];
+            if (t == MATCHER_MISSING) { m->delta[s * C + c] = via_fail; continue; }
+            fail[t] = via_fail;
+            m->out_link[t] = (m->match[via_fail] >= 0) ? via_fail : m->out_link[via_fail];
+            queue[tail++] = t;
+        }
+    }
+    free(fail); free(queue);
+
+    // Encode entries as (row offset << 1) | has_output
+    for (size_t i = 0; i < m->states * C; ++i) {
+        uint32_t t = m->delta[i];
+        m->delta[i] = (uint32_t)((t * C) << 1) | (uint32_t)(m->match[t] >= 0 || m->out_link[t] != 0);
+    }
+    return m;
+}
+
+void aq_matcher_destroy(aq_matcher *matcher) {
+    if (matcher == NULL) return;
+    free(matcher->delta); free(matcher->match); free(matcher->out_link);
+    free(matcher->pattern_len); free(matcher->same_next);
+    free(matcher);
+}
+
+// Shared scan: stores up to max_matches, returns the total (stops after the first when first_only).
+static size_t matcher_scan(const aq_matcher *m, const char *text, size_t length, aq_match *matches, size_t max_matches, bool first_only) {
+    const uint32_t *delta = m->delta;
+    uint32_t entry = 0;
+    size_t found = 0, skips = 0, skipped = 0;
+    bool skipping = m->first_count > 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (entry == 0 && skipping) {
+            // Root state: jump to the next byte that can start a pattern
+            size_t from = i;
+            uint64_t mask = 0;
+            while (i < length) {
+                size_t n = (length - i < SET_MASK_WINDOW) ? length - i : SET_MASK_WINDOW;
+                mask = aq_string_kernels.set_mask(text + i, n, m->first, m->first_count, m->first_bits);
+                if (mask != 0) break;
+                i += n;
+            }
+            if (mask == 0) break;
+            i += (size_t)trailing_zeros_64(mask);
+            // Stop skipping when first bytes are so common that the jumps are short
+            skipped += i - from;
+            if (++skips == MATCHER_SKIP_PROBE && skipped < MATCHER_SKIP_PROBE * MATCHER_SKIP_MIN) skipping = false;
+        }
+        entry = delta[(entry >> 1) + m->byte_class[(unsigned char)text[i]]];
+        if (!(entry & 1)) continue;
+        uint32_t s = (uint32_t)((entry >> 1) / m->classes);
+        for (uint32_t o = (m->match[s] >= 0) ? s : m->out_link[s]; o != 0; o = m->out_link[o]) {
+            for (int32_t p = m->match[o]; p >= 0; p = m->same_next[p]) {
+                if (matches != NULL && found < max_matches) { matches[found].offset = i + 1 - m->pattern_len[p]; matches[found].pattern = (size_t)p; }
+                found++;
+                if (first_only) return found;
+            }
+        }
+    }
+    return found;
+}
+
+// O(L + matches) time. Returns the match count; stores at most max_matches, ordered by end offset.
+size_t aq_matcher_find_all(const aq_matcher *matcher, const char *text, size_t length, aq_match *matches, size_t max_matches) {
+    if (matcher == NULL || text == NULL) return 0;
+    return matcher_scan(matcher, text, length, matches, max_matches, false);
+}
+
+// O(position of the first match) time. true if any pattern occurs; *match (may be NULL) gets the earliest-ending one.
+bool aq_matcher_find_first(const aq_matcher *matcher, const char *text, size_t length, aq_match *match) {
+    if (matcher == NULL || text == NULL) return false;
+    return matcher_scan(matcher, text, length, match, 1, true) > 0;
+}
+
+// Candidate replacement for string_replace_many, ordered by start, longest first, then by rule.
+typedef struct {
+    size_t start, end, rule;
+} ReplaceHit;
+
+static int replace_hit_compare(const void *a, const void *b) {
+    const ReplaceHit *x = (const ReplaceHit*)a, *y = (const ReplaceHit*)b;
+    if (x->start != y->start) return (x->start < y->start) ? -1 : 1;
+    if (x->end != y->end) return (x->end > y->end) ? -1 : 1;
+    return (x->rule > y->rule) - (x->rule < y->rule);
+}
+
+// O(L + M log M) time for M raw matches. Caller must free.
+string string_replace_many(const string s, const aq_replace_rule *rules, size_t count) {
+    return string_replace_many_a(NULL, s, rules, count);
+}
+
+// O(L + M log M) time. All rules are found in one aq_matcher pass; the
+// leftmost match wins, the longest one when several start together (the
+// earlier rule on a tie), and replaced text is never rescanned.
+string string_replace_many_a(aq_arena *arena, const string s, const aq_replace_rule *rules, size_t count) {
+    if (s == NULL) return NULL;
+    size_t len = strlen(s);
+    if (rules == NULL || count == 0 || count > SIZE_MAX / sizeof(string)) return copy_bytes(arena, s, len);
+    string *froms = malloc(count * sizeof(string));
+    if (froms == NULL) return NULL;
+    for (size_t k = 0; k < count; ++k) froms[k] = (string)rules[k].from;
+    aq_matcher *matcher = aq_matcher_create(froms, count);
+    free(froms);
+    if (matcher == NULL) return NULL;
+    size_t total = aq_matcher_find_all(matcher, s, len, NULL, 0);
+    if (total == 0) { aq_matcher_destroy(matcher); return copy_bytes(arena, s, len); }
+    aq_match *found = (total <= SIZE_MAX / sizeof(ReplaceHit)) ? malloc(total * sizeof(aq_match)) : NULL;
+    ReplaceHit *hits = (found != NULL) ? malloc(total * sizeof(ReplaceHit)) : NULL;
+    if (hits == NULL) { free(found); aq_matcher_destroy(matcher); return NULL; }
+    aq_matcher_find_all(matcher, s, len, found, total);
+    for (size_t i = 0; i < total; ++i) {
+        hits[i].start = found[i].offset;
+        hits[i].end = found[i].offset + matcher->pattern_len[found[i].pattern];
+        hits[i].rule = found[i].pattern;
+    }
+    free(found);
+    aq_matcher_destroy(matcher);
+    // Matches arrive ordered by end, so each is at most one pattern length out
+    // of start order: insertion sort finishes in O(M * longest from) moves.
+    for (size_t i = 1; i < total; ++i) {
+        ReplaceHit key = hits[i];
+        size_t j = i;
+        while (j > 0 && replace_hit_compare(&hits[j - 1], &key) > 0) { hits[j] = hits[j - 1]; j--; }
+        hits[j] = key;
+    }
+
+    // Keep the leftmost-longest hits that do not overlap an earlier one; size the output exactly
+    size_t kept = 0, pos = 0, out_len = len;
+    for (size_t i = 0; i < total; ++i) {
+        if (hits[i].start < pos) continue;
+        size_t to_len = (rules[hits[i].rule].to == NULL) ? 0 : strlen(rules[hits[i].rule].to);
+        if (to_len > SIZE_MAX - 1 - out_len) { free(hits); return NULL; } // Result too large
+        out_len = out_len - (hits[i].end - hits[i].start) + to_len;
+        pos = hits[i].end;
+        hits[kept++] = hits[i];
+    }
+    string out = str_alloc(arena, out_len + 1);
+    if (out == NULL) { free(hits); return NULL; }
+    char *w = out;
+    pos = 0;
+    for (size_t i = 0; i < kept; ++i) {
+        memcpy(w, s + pos, hits[i].start - pos); w += hits[i].start - pos;
+        const char *to = rules[hits[i].rule].to;
+        if (to != NULL) { size_t to_len = strlen(to); memcpy(w, to, to_len); w += to_len; }
+        pos = hits[i].end;
+    }
+    memcpy(w, s + pos, len - pos); w += len - pos;
+    *w = '\0';
+    free(hits);
+    return out;
 }
 
 
@@ -1189,24 +7014,28 @@ void free_string(string s) {
 
 // --- Utility Functions ---
 // ... (initialize_random, get_random_*, start/stop_timer - unchanged) ...
+// Seeds the calling thread's generator from the clock (and srand() for code still using rand()).
 void initialize_random() {
-    srand((unsigned int)time(NULL));
+    uint64_t seed = (uint64_t)time(NULL);
+    aq_seed_random(seed ^ ((uint64_t)clock() << 32) ^ (uint64_t)(uintptr_t)&thread_rng);
+    srand((unsigned int)seed);
 }
 
-// O(1) time. Random integer in [min, max] (inclusive).
+// O(1) time. Random integer in [min, max] (inclusive), every value equally likely.
 int get_random_int(int min, int max) {
     if (min > max) { int temp = min; min = max; max = temp; }
-    return min + (rand() % (max - min + 1));
+    uint64_t span = (uint64_t)((long long)max - min) + 1; // Up to 2^32, no overflow
+    return (int)((long long)min + (long long)aq_rng_bounded(current_rng(), span));
 }
-// O(1) time. Random float in [min, max].
+// O(1) time. Random float in [min, max] (24 random bits).
 float get_random_float(float min, float max) {
      if (min > max) { float temp = min; min = max; max = temp; }
-    return min + ((float)rand() / (float)RAND_MAX) * (max - min);
+    return min + ((float)(aq_rng_next(current_rng()) >> 40) / 16777215.0f) * (max - min);
 }
-// O(1) time. Random double in [min, max].
+// O(1) time. Random double in [min, max] (53 random bits).
 double get_random_double(double min, double max) {
     if (min > max) { double temp = min; min = max; max = temp; }
-     return min + ((double)rand() / (double)RAND_MAX) * (max - min);
+     return min + ((double)(aq_rng_next(current_rng()) >> 11) / 9007199254740991.0) * (max - min);
 }
 
 
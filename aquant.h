@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
 #include <math.h>
 
 // Define string type
@@ -12,6 +14,118 @@ typedef char *string;
 #define FLOAT_EPSILON 1e-6f
 #define DOUBLE_EPSILON 1e-9
 
+// Result of the single-pass array_stats_* functions
+typedef struct aq_stats {
+    size_t count;
+    double min;
+    double max;
+    size_t argmin;   // Index of the first minimum
+    size_t argmax;   // Index of the first maximum
+    double sum;      // Exact for int arrays while |sum| < 2^53
+    double mean;
+    double variance; // Population variance (divide by count); numerically stable
+} aq_stats;
+
+// Sorted, read-only index over an array for repeated lookups (aq_index_create_*)
+typedef struct aq_index aq_index;
+
+// Value -> count table built in one pass (aq_histogram_create_*)
+typedef struct aq_histogram aq_histogram;
+
+// Hashed string set and string -> size_t map that own copies of their keys (aq_strset_create, aq_strmap_create)
+typedef struct aq_strset aq_strset;
+typedef struct aq_strmap aq_strmap;
+
+// Pool of canonical strings, one per distinct value (aq_intern_create). IDs number them densely.
+typedef struct aq_intern aq_intern;
+#define AQ_INTERN_NONE ((size_t)-1) // aq_intern_id result for strings not in the pool
+
+// Buffered line reader over a FILE* or file descriptor (aq_reader_create_*)
+typedef struct aq_reader aq_reader;
+
+// Non-interactive input source for the aq_input_get_* functions (aq_input_create_*)
+typedef struct aq_input_ctx aq_input_ctx;
+
+// Result of an aq_input_get_* call
+typedef enum aq_input_status {
+    AQ_INPUT_OK = 0,
+    AQ_INPUT_EOF,     // No more lines
+    AQ_INPUT_INVALID, // Not a valid value (same rules as the get_* functions); the line is consumed
+    AQ_INPUT_RANGE,   // A number outside the type's or the requested range; the line is consumed
+    AQ_INPUT_ERROR    // Read or allocation failure, or a NULL argument
+} aq_input_status;
+
+// Non-owning slice of a string: len bytes at ptr, not null-terminated
+typedef struct aq_strview {
+    const char *ptr;
+    size_t len;
+} aq_strview;
+
+// String with a cached length: ptr[len] is always '\0'. cap > 0 means ptr is an
+// owned malloc'd buffer of cap bytes (release with aq_str_free); cap == 0 means borrowed.
+typedef struct aq_str {
+    char *ptr;
+    size_t len;
+    size_t cap;
+} aq_str;
+
+// Lazy splitter over a string (aq_tokenizer_init*). Fields are internal.
+typedef struct aq_tokenizer {
+    const char *pos;
+    const char *end;
+    const char *delim;
+    size_t delim_len;
+    int mode;
+    bool done;
+    char single;
+    unsigned char set_bits[32];
+    const char *window;
+    uint64_t mask;
+} aq_tokenizer;
+
+// Bump allocator for the string_*_a functions (aq_arena_create)
+typedef struct aq_arena aq_arena;
+
+// C99 stand-in for max_align_t: every aq_arena_alloc result is aligned to AQ_ARENA_ALIGN
+typedef union aq_max_align {
+    long double ld;
+    long long ll;
+    double d;
+    void *p;
+    void (*fn)(void);
+} aq_max_align;
+typedef struct aq_max_align_probe {
+    char c;
+    aq_max_align u;
+} aq_max_align_probe;
+#define AQ_ARENA_ALIGN offsetof(aq_max_align_probe, u)
+
+// Multi-pattern matcher (aq_matcher_create) and one reported match
+typedef struct aq_matcher aq_matcher;
+typedef struct aq_match {
+    size_t offset;  // Start of the match in the text
+    size_t pattern; // Index into the patterns given to aq_matcher_create
+} aq_match;
+
+// One from -> to substitution for string_replace_many (a NULL to deletes)
+typedef struct aq_replace_rule {
+    const char *from;
+    const char *to;
+} aq_replace_rule;
+
+// Growable string builder (aq_strbuf_init). data[len] is '\0' once cap > 0.
+typedef struct aq_strbuf {
+    char *data;
+    size_t len;
+    size_t cap;
+    aq_arena *arena; // NULL: malloc'd buffer
+} aq_strbuf;
+
+// xoshiro256** generator state. Seed with aq_rng_seed before use.
+typedef struct aq_rng {
+    uint64_t s[4];
+} aq_rng;
+
 // --- Input Functions ---
 string get_string(const char *prompt); // Caller must free result
 char get_char(const char *prompt);
@@ -22,6 +136,50 @@ double get_double(const char *prompt);
 int get_int_range(const char *prompt, int min, int max);
 string get_string_non_empty(const char *prompt); // Caller must free result
 
+// --- Line Reader Functions ---
+aq_reader* aq_reader_create_file(FILE *fp); // Reads via fp's own buffer, never past the current line
+aq_reader* aq_reader_create_fd(int fd); // Reads ahead in 64 KiB blocks. NULL without POSIX read()
+aq_reader* aq_reader_create_buffer(const char *data, size_t size); // Borrows data: keep it alive
+void aq_reader_destroy(aq_reader *reader); // Does not close the FILE/fd
+const char* aq_reader_next_line(aq_reader *reader, size_t *length); // Borrowed until the next call, '\n' removed. NULL at EOF
+
+// --- Input Context Functions ---
+// No prompts and no retries: each call consumes one line and reports problems through the status.
+aq_input_ctx* aq_input_create_file(FILE *fp); // Free with aq_input_destroy (does not close fp)
+aq_input_ctx* aq_input_create_fd(int fd);
+aq_input_ctx* aq_input_create_buffer(const char *data, size_t size); // Borrows data: keep it alive
+void aq_input_destroy(aq_input_ctx *ctx);
+size_t aq_input_line_number(const aq_input_ctx *ctx); // Lines consumed so far, for error messages
+aq_input_status aq_input_get_line(aq_input_ctx *ctx, const char **line, size_t *length); // Borrowed until the next call
+aq_input_status aq_input_get_string(aq_input_ctx *ctx, string *out); // Caller must free *out
+aq_input_status aq_input_get_string_non_empty(aq_input_ctx *ctx, string *out); // Caller must free *out
+aq_input_status aq_input_get_char(aq_input_ctx *ctx, char *out);
+aq_input_status aq_input_get_int(aq_input_ctx *ctx, int *out);
+aq_input_status aq_input_get_int_range(aq_input_ctx *ctx, int min, int max, int *out); // AQ_INPUT_RANGE outside [min, max]
+aq_input_status aq_input_get_long(aq_input_ctx *ctx, long *out);
+aq_input_status aq_input_get_float(aq_input_ctx *ctx, float *out);
+aq_input_status aq_input_get_double(aq_input_ctx *ctx, double *out);
+
+// --- Numeric Scan Functions ---
+// Read whitespace-separated numbers to EOF. Caller must free the result.
+// NULL with *count = 0 on empty input, any invalid token, or a read error.
+int* aq_scan_int_array(FILE *fp, size_t *count);
+int* aq_scan_int_array_fd(int fd, size_t *count);
+int* aq_scan_int_array_buffer(const char *data, size_t size, size_t *count);
+double* aq_scan_double_array(FILE *fp, size_t *count);
+double* aq_scan_double_array_fd(int fd, size_t *count);
+double* aq_scan_double_array_buffer(const char *data, size_t size, size_t *count);
+
+// --- Binary Array File Functions ---
+// 64-byte header (type, count, byte order) + raw data. Files are only readable on machines with the same byte order.
+bool aq_array_save_int(const char *path, const int *arr, size_t size);
+bool aq_array_save_float(const char *path, const float *arr, size_t size);
+bool aq_array_save_double(const char *path, const double *arr, size_t size);
+const int* aq_array_map_int(const char *path, size_t *size); // Zero-copy, read-only. NULL if missing, invalid, wrong type or empty
+const float* aq_array_map_float(const char *path, size_t *size);
+const double* aq_array_map_double(const char *path, size_t *size);
+void aq_array_unmap(const void *data); // Releases a pointer returned by aq_array_map_*
+
 // --- Integer Array Functions ---
 bool array_max(const int *arr, size_t size, int *max_val);
 bool array_min(const int *arr, size_t size, int *min_val);
@@ -29,15 +187,21 @@ bool array_sum(const int *arr, size_t size, long long *sum);
 bool array_contains_int(const int *arr, size_t size, int value);
 int array_index_of_int(const int *arr, size_t size, int value);
 double array_average(const int *arr, size_t size);
+bool array_stats_int(const int *arr, size_t size, aq_stats *stats); // One pass: min, max, argmin, argmax, sum, mean, variance
 size_t array_count_occurrence(const int *arr, size_t size, int value);
 int* array_copy_int(const int *arr, size_t size); // Caller must free result
 bool array_has_pair_sum(const int *arr, size_t size, int target); // O(n) average
 bool array_has_pair_product(const int *arr, size_t size, int target); // O(n) average
 bool array_has_pair_difference(const int *arr, size_t size, int target); // O(n) average
-void sort_array(int arr[], size_t size); // O(n log n)
+void sort_array(int arr[], size_t size); // O(n) radix sort
+void sort_array_parallel(int arr[], size_t size, int num_threads); // num_threads <= 0: one per CPU. Serial below ~131k elements
+bool array_nth_int(const int *arr, size_t size, size_t n, int *result); // n-th smallest (0-based), O(n) expected, no full sort
+double array_median_int(const int *arr, size_t size); // Returns NAN on error/empty
+bool array_percentiles_int(const int *arr, size_t size, const double *percents, size_t count, double *results); // percents in [0, 100], interpolated
+bool array_top_k_int(const int *arr, size_t size, size_t k, int *out); // k largest into out, descending
 void print_array(const int arr[], size_t size);
 void array_reverse_int(int arr[], size_t size);
-void array_shuffle_int(int arr[], size_t size); // Call initialize_random() once first
+void array_shuffle_int(int arr[], size_t size); // Unbiased Fisher-Yates on the calling thread's generator
 int* array_unique_int(const int *arr, size_t size, size_t *new_size); // O(n) average, caller must free result
 int* array_concat_int(const int *arr1, size_t size1, const int *arr2, size_t size2, size_t *new_size); // Caller must free result
 
@@ -46,14 +210,19 @@ bool array_max_float(const float *arr, size_t size, float *max_val);
 bool array_min_float(const float *arr, size_t size, float *min_val);
 bool array_sum_float(const float *arr, size_t size, double *sum);
 double array_average_float(const float *arr, size_t size);
-void sort_array_float(float arr[], size_t size); // O(n log n)
+bool array_stats_float(const float *arr, size_t size, aq_stats *stats); // One pass: min, max, argmin, argmax, sum, mean, variance
+void sort_array_float(float arr[], size_t size); // O(n) radix sort
+bool array_nth_float(const float *arr, size_t size, size_t n, float *result); // n-th smallest (0-based), O(n) expected
+double array_median_float(const float *arr, size_t size); // Returns NAN on error/empty
+bool array_percentiles_float(const float *arr, size_t size, const double *percents, size_t count, double *results);
+bool array_top_k_float(const float *arr, size_t size, size_t k, float *out); // k largest into out, descending
 bool array_contains_float(const float *arr, size_t size, float value);
 int array_index_of_float(const float *arr, size_t size, float value);
 size_t array_count_occurrence_float(const float *arr, size_t size, float value);
 float* array_copy_float(const float *arr, size_t size); // Caller must free result
 void print_float_array(const float arr[], size_t size);
 void array_reverse_float(float arr[], size_t size);
-void array_shuffle_float(float arr[], size_t size); // Call initialize_random() once first
+void array_shuffle_float(float arr[], size_t size); // Unbiased Fisher-Yates on the calling thread's generator
 float* array_concat_float(const float *arr1, size_t size1, const float *arr2, size_t size2, size_t *new_size); // Caller must free result
 
 // --- Double Array Functions ---
@@ -61,28 +230,110 @@ bool array_max_double(const double *arr, size_t size, double *max_val);
 bool array_min_double(const double *arr, size_t size, double *min_val);
 bool array_sum_double(const double *arr, size_t size, double *sum);
 double array_average_double(const double *arr, size_t size);
-void sort_array_double(double arr[], size_t size); // O(n log n)
+bool array_stats_double(const double *arr, size_t size, aq_stats *stats); // One pass: min, max, argmin, argmax, sum, mean, variance
+void sort_array_double(double arr[], size_t size); // O(n) radix sort
+void sort_array_double_parallel(double arr[], size_t size, int num_threads); // num_threads <= 0: one per CPU. Serial below ~131k elements
+bool array_nth_double(const double *arr, size_t size, size_t n, double *result); // n-th smallest (0-based), O(n) expected
+double array_median_double(const double *arr, size_t size); // Returns NAN on error/empty
+bool array_percentiles_double(const double *arr, size_t size, const double *percents, size_t count, double *results);
+bool array_top_k_double(const double *arr, size_t size, size_t k, double *out); // k largest into out, descending
 bool array_contains_double(const double *arr, size_t size, double value);
 int array_index_of_double(const double *arr, size_t size, double value);
 size_t array_count_occurrence_double(const double *arr, size_t size, double value);
 double* array_copy_double(const double *arr, size_t size); // Caller must free result
 void print_double_array(const double arr[], size_t size);
 void array_reverse_double(double arr[], size_t size);
-void array_shuffle_double(double arr[], size_t size); // Call initialize_random() once first
+void array_shuffle_double(double arr[], size_t size); // Unbiased Fisher-Yates on the calling thread's generator
 double* array_concat_double(const double *arr1, size_t size1, const double *arr2, size_t size2, size_t *new_size); // Caller must free result
 
 // --- String Array Functions ---
 bool array_max_string(const string *arr, size_t size, string *max_val); // Returns pointer within arr
 bool array_min_string(const string *arr, size_t size, string *min_val); // Returns pointer within arr
 void sort_array_string(string arr[], size_t size); // O(n log n * L)
+void sort_array_string_parallel(string arr[], size_t size, int num_threads); // num_threads <= 0: one per CPU. Serial below ~131k elements
 bool array_contains_string(const string *arr, size_t size, const string value);
 int find_string(const string names[], size_t size, const string target_name); // Alias for index_of_string
 size_t array_count_occurrence_string(const string *arr, size_t size, const string value);
 string* array_copy_string_array(const string *arr, size_t size); // Deep copy. Caller must free using free_string_array.
 void print_string_array(const string arr[], size_t size);
 void array_reverse_string(string arr[], size_t size);
-void array_shuffle_string(string arr[], size_t size); // Call initialize_random() once first
+void array_shuffle_string(string arr[], size_t size); // Unbiased Fisher-Yates on the calling thread's generator
 string* array_concat_string(const string *arr1, size_t size1, const string *arr2, size_t size2, size_t *new_size); // Deep copy. Caller must free using free_string_array.
+string* array_unique_string(const string *arr, size_t size, size_t *new_size); // O(n) average, first-occurrence order. Caller must free using free_string_array.
+
+// --- Sorted Index Functions ---
+// Build once (O(n) for numbers, O(n log n * L) for strings), then query in O(log n).
+// Queries on an index of another element type return false / -1 / 0.
+aq_index* aq_index_create_int(const int *arr, size_t size); // Copies the values. Free with aq_index_destroy
+aq_index* aq_index_create_float(const float *arr, size_t size); // Copies the values. Free with aq_index_destroy
+aq_index* aq_index_create_double(const double *arr, size_t size); // Copies the values. Free with aq_index_destroy
+aq_index* aq_index_create_string(const string *arr, size_t size); // Borrows the strings: keep them alive and unchanged
+void aq_index_destroy(aq_index *index);
+size_t aq_index_size(const aq_index *index);
+bool aq_index_contains_int(const aq_index *index, int value);
+int aq_index_index_of_int(const aq_index *index, int value); // First occurrence, like array_index_of_int
+size_t aq_index_lower_bound_int(const aq_index *index, int value); // Number of elements < value
+size_t aq_index_count_range_int(const aq_index *index, int lo, int hi); // Number of elements in [lo, hi]
+size_t aq_index_contains_batch_int(const aq_index *index, const int *values, size_t count, bool *results); // Returns number found
+bool aq_index_contains_float(const aq_index *index, float value); // FLOAT_EPSILON match, like array_contains_float
+int aq_index_index_of_float(const aq_index *index, float value);
+size_t aq_index_lower_bound_float(const aq_index *index, float value); // Exact compare, -0.0 == 0.0
+size_t aq_index_count_range_float(const aq_index *index, float lo, float hi);
+size_t aq_index_contains_batch_float(const aq_index *index, const float *values, size_t count, bool *results);
+bool aq_index_contains_double(const aq_index *index, double value); // DOUBLE_EPSILON match, like array_contains_double
+int aq_index_index_of_double(const aq_index *index, double value);
+size_t aq_index_lower_bound_double(const aq_index *index, double value); // Exact compare, -0.0 == 0.0
+size_t aq_index_count_range_double(const aq_index *index, double lo, double hi);
+size_t aq_index_contains_batch_double(const aq_index *index, const double *values, size_t count, bool *results);
+bool aq_index_contains_string(const aq_index *index, const string value);
+int aq_index_index_of_string(const aq_index *index, const string value); // Like find_string
+size_t aq_index_lower_bound_string(const aq_index *index, const string value); // sort_array_string order
+size_t aq_index_contains_batch_string(const aq_index *index, const string *values, size_t count, bool *results);
+
+// --- Histogram Functions ---
+aq_histogram* aq_histogram_create_int(const int *arr, size_t size); // O(n). Dense counters when the value range is small
+aq_histogram* aq_histogram_create_string(const string *arr, size_t size); // Borrows the strings: keep them alive
+void aq_histogram_destroy(aq_histogram *hist);
+size_t aq_histogram_distinct(const aq_histogram *hist); // Number of distinct values
+size_t aq_histogram_count_int(const aq_histogram *hist, int value); // O(1)
+size_t aq_histogram_count_string(const aq_histogram *hist, const string value); // O(L), NULL counts NULL elements
+bool aq_histogram_next_int(const aq_histogram *hist, size_t *cursor, int *value, size_t *count); // Start with *cursor = 0
+bool aq_histogram_next_string(const aq_histogram *hist, size_t *cursor, string *value, size_t *count); // Start with *cursor = 0
+
+// --- String Set and Map Functions (O(L) average per operation; NULL keys are rejected) ---
+aq_strset* aq_strset_create(size_t expected); // expected is a sizing hint. Free with aq_strset_destroy
+void aq_strset_destroy(aq_strset *set);
+void aq_strset_clear(aq_strset *set); // Keeps the memory for reuse
+bool aq_strset_add(aq_strset *set, const string s); // Copies new keys. false only for NULL or allocation failure
+bool aq_strset_add_view(aq_strset *set, aq_strview s);
+bool aq_strset_contains(const aq_strset *set, const string s);
+bool aq_strset_contains_view(const aq_strset *set, aq_strview s);
+bool aq_strset_remove(aq_strset *set, const string s); // false if absent
+size_t aq_strset_size(const aq_strset *set);
+bool aq_strset_next(const aq_strset *set, size_t *cursor, string *value); // Start with *cursor = 0. Insertion order until a removal
+aq_strmap* aq_strmap_create(size_t expected); // expected is a sizing hint. Free with aq_strmap_destroy
+void aq_strmap_destroy(aq_strmap *map);
+void aq_strmap_clear(aq_strmap *map); // Keeps the memory for reuse
+size_t* aq_strmap_ref(aq_strmap *map, const string key); // Value slot, inserted as 0 if absent. Valid until the next insertion
+size_t* aq_strmap_ref_view(aq_strmap *map, aq_strview key);
+bool aq_strmap_put(aq_strmap *map, const string key, size_t value); // Inserts or overwrites
+bool aq_strmap_get(const aq_strmap *map, const string key, size_t *value); // false if absent
+bool aq_strmap_get_view(const aq_strmap *map, aq_strview key, size_t *value);
+bool aq_strmap_remove(aq_strmap *map, const string key); // false if absent
+size_t aq_strmap_size(const aq_strmap *map);
+bool aq_strmap_next(const aq_strmap *map, size_t *cursor, string *key, size_t *value); // Start with *cursor = 0. Insertion order until a removal
+
+// --- String Interning Functions (canonical strings live until aq_intern_destroy; never free them) ---
+aq_intern* aq_intern_create(size_t expected); // expected is a sizing hint. Free with aq_intern_destroy
+void aq_intern_destroy(aq_intern *pool); // Also frees every canonical string
+string aq_intern_string(aq_intern *pool, const string s); // O(L). Equal strings get the same pointer
+string aq_intern_view(aq_intern *pool, aq_strview s);
+size_t aq_intern_size(const aq_intern *pool); // Number of distinct strings (IDs are 0 .. size - 1)
+size_t aq_intern_id(aq_intern *pool, const string s); // O(1) for canonical pointers, O(L) otherwise; AQ_INTERN_NONE if absent
+string aq_intern_lookup(const aq_intern *pool, size_t id); // Canonical string for an ID, NULL if out of range
+string* aq_intern_copy_string_array(aq_intern *pool, const string *arr, size_t size); // Canonical pointers. Caller must free() the array only
+string* aq_intern_concat_string(aq_intern *pool, const string *arr1, size_t size1, const string *arr2, size_t size2, size_t *new_size); // Canonical pointers. Caller must free() the array only
+void aq_intern_sort(aq_intern *pool, string arr[], size_t size); // sort_array_string order via integer ranks, O(n) once ranked
 
 // --- String Manipulation Functions ---
 string string_copy(const string s); // Caller must free result
@@ -98,9 +349,16 @@ string string_concat(const string s1, const string s2); // Caller must free resu
 string string_substring(const string s, size_t start, size_t length); // Caller must free result
 int string_find_char(const string s, char c);
 int string_find_substring(const string haystack, const string needle);
+size_t* string_find_all(const string haystack, const string needle, size_t *count); // Every match offset (overlapping). Caller must free result
 string string_replace_char(const string s, char old_char, char new_char); // Caller must free result
+string string_replace_all(const string s, const string from, const string to); // Non-overlapping, left to right. Caller must free result
+size_t string_replace_all_in_place(string s, const string from, const string to); // Needs strlen(to) <= strlen(from). Returns replacements
+string string_replace_many(const string s, const aq_replace_rule *rules, size_t count); // One pass, longest match wins. Caller must free result
 string string_to_lower(const string s); // Caller must free result
 string string_to_upper(const string s); // Caller must free result
+void string_to_lower_in_place(string s); // Converts the caller's buffer, no allocation
+void string_to_upper_in_place(string s);
+size_t string_trim_in_place(string s); // Moves the trimmed text to the front; returns its length
 string* string_split(const string s, char delimiter, size_t *num_tokens); // Caller must free using free_string_array.
 string string_join(const string *arr, size_t size, const string separator); // Caller must free result
 bool string_starts_with(const string s, const string prefix);
@@ -108,12 +366,87 @@ bool string_ends_with(const string s, const string suffix);
 float string_to_float(const string s, bool *success);
 double string_to_double(const string s, bool *success);
 
+// --- Arena Functions ---
+aq_arena* aq_arena_create(size_t block_size); // 0 selects the 64 KiB default. Free with aq_arena_destroy
+void aq_arena_destroy(aq_arena *arena); // Releases everything allocated from the arena
+void aq_arena_reset(aq_arena *arena); // O(1); invalidates all allocations, keeps the blocks
+void* aq_arena_alloc(aq_arena *arena, size_t size); // Aligned like malloc; never free individually
+
+// --- Arena String Functions (results live in the arena; a NULL arena means malloc) ---
+string string_copy_a(aq_arena *arena, const string s);
+string string_trim_a(aq_arena *arena, const string s);
+string string_concat_a(aq_arena *arena, const string s1, const string s2);
+string string_substring_a(aq_arena *arena, const string s, size_t start, size_t length);
+string string_replace_char_a(aq_arena *arena, const string s, char old_char, char new_char);
+string string_replace_all_a(aq_arena *arena, const string s, const string from, const string to);
+string string_replace_many_a(aq_arena *arena, const string s, const aq_replace_rule *rules, size_t count);
+string string_to_lower_a(aq_arena *arena, const string s);
+string string_to_upper_a(aq_arena *arena, const string s);
+string* string_split_a(aq_arena *arena, const string s, char delimiter, size_t *num_tokens); // Do not use free_string_array
+string string_join_a(aq_arena *arena, const string *arr, size_t size, const string separator);
+
+// --- String View Functions (views point into the input; nothing is allocated) ---
+size_t string_split_view(const string s, char delimiter, aq_strview *views, size_t max_views); // Returns token count; stores at most max_views
+size_t string_split_view_str(const string s, const string delimiter, aq_strview *views, size_t max_views); // Multi-character delimiter
+size_t string_split_view_any(const string s, const string delimiters, aq_strview *views, size_t max_views); // Any byte of delimiters
+void aq_tokenizer_init(aq_tokenizer *tok, const char *s, size_t length, char delimiter);
+void aq_tokenizer_init_str(aq_tokenizer *tok, const char *s, size_t length, const char *delimiter); // delimiter must outlive tok
+void aq_tokenizer_init_any(aq_tokenizer *tok, const char *s, size_t length, const char *delimiters); // delimiters must outlive tok
+bool aq_tokenizer_next(aq_tokenizer *tok, aq_strview *token); // false when no tokens are left
+string string_view_copy_a(aq_arena *arena, aq_strview view); // Null-terminated copy; a NULL arena means malloc
+bool string_view_equals(aq_strview view, const string s);
+
+// --- Length-Carrying String Functions (results are owned; free with aq_str_free) ---
+aq_str aq_str_from(const string s); // Borrows s, no copy
+aq_str aq_str_copy(const char *data, size_t len); // Owned copy of len bytes
+aq_str aq_str_take(string s); // Adopts a malloc'd string, e.g. from string_concat
+string aq_str_release(aq_str *s); // O(1) hand-off to a plain string (copies if borrowed). Caller must free result
+void aq_str_free(aq_str *s); // Frees owned strings; no-op for borrowed ones
+aq_strview aq_str_view(aq_str s);
+aq_str aq_str_concat(aq_str a, aq_str b);
+aq_str aq_str_substring(aq_str s, size_t start, size_t length);
+aq_str aq_str_trim(aq_str s);
+aq_str aq_str_to_lower(aq_str s);
+aq_str aq_str_to_upper(aq_str s);
+aq_str aq_str_join(const aq_str *arr, size_t size, aq_str separator);
+bool aq_str_equals(aq_str a, aq_str b);
+bool aq_str_starts_with(aq_str s, aq_str prefix);
+bool aq_str_ends_with(aq_str s, aq_str suffix);
+bool aq_str_find(aq_str haystack, aq_str needle, size_t *offset); // offset may be NULL; empty needle matches at 0
+aq_str aq_str_replace_all(aq_str s, aq_str from, aq_str to);
+
+// --- String Builder Functions (append functions return false on allocation failure) ---
+void aq_strbuf_init(aq_strbuf *sb); // Empty; nothing is allocated until the first append
+void aq_strbuf_init_a(aq_strbuf *sb, aq_arena *arena); // Grows inside arena
+bool aq_strbuf_reserve(aq_strbuf *sb, size_t additional);
+bool aq_strbuf_append(aq_strbuf *sb, const char *data, size_t len);
+bool aq_strbuf_append_string(aq_strbuf *sb, const string s);
+bool aq_strbuf_append_str(aq_strbuf *sb, aq_str s);
+bool aq_strbuf_append_char(aq_strbuf *sb, char c);
+bool aq_strbuf_append_int(aq_strbuf *sb, long long value);
+bool aq_strbuf_append_double(aq_strbuf *sb, double value); // Shortest %.15g-%.17g text that round-trips
+void aq_strbuf_clear(aq_strbuf *sb); // Keeps the capacity
+string aq_strbuf_release(aq_strbuf *sb); // O(1) move-out. Caller must free result (unless from an arena)
+aq_str aq_strbuf_release_str(aq_strbuf *sb); // O(1) move-out keeping length and capacity
+void aq_strbuf_free(aq_strbuf *sb);
+
+// --- Multi-Pattern Search Functions ---
+aq_matcher* aq_matcher_create(const string *patterns, size_t count); // Patterns are copied into the automaton. Free with aq_matcher_destroy
+void aq_matcher_destroy(aq_matcher *matcher);
+size_t aq_matcher_find_all(const aq_matcher *matcher, const char *text, size_t length, aq_match *matches, size_t max_matches); // Returns match count; stores at most max_matches
+bool aq_matcher_find_first(const aq_matcher *matcher, const char *text, size_t length, aq_match *match); // match may be NULL
+
 // --- Memory Management Helpers ---
 void free_string(string s); // Frees string allocated by aquant functions
 void free_string_array(string *arr, size_t size); // Frees array of strings allocated by aquant functions
 
 // --- Utility Functions ---
-void initialize_random(); // Call ONCE at program start if using random functions
+void initialize_random(); // Seeds the calling thread's generator from the clock (optional: threads self-seed)
+void aq_seed_random(uint64_t seed); // Reproducible sequence for the calling thread
+void aq_rng_seed(aq_rng *rng, uint64_t seed); // Independent generator, e.g. one per worker
+uint64_t aq_rng_next(aq_rng *rng); // 64 random bits
+uint64_t aq_rng_bounded(aq_rng *rng, uint64_t bound); // Unbiased, in [0, bound)
+double aq_rng_double(aq_rng *rng); // In [0, 1)
 int get_random_int(int min, int max);
 float get_random_float(float min, float max);
 double get_random_double(double min, double max);
@@ -5,12 +5,36 @@
 #include <limits.h> // For INT_MAX etc.
 #include <float.h>  // For FLT_MAX etc.
 #include <math.h>   // For fabs, isnan
+#include <stdint.h> // For uint32_t
 
 // Helper to print simple pass/fail
 void check(const char* test_name, bool condition) {
     printf("%s: %s\n", test_name, condition ? "PASS" : "FAIL");
 }
 
+// qsort references for the sort checks. Floats/doubles use the IEEE total
+// order the sorts promise: -NaN first, -0.0 before +0.0, +NaN last.
+static int ref_compare_int(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int ref_compare_double_value(double x, double y) {
+    int rx = isnan(x) ? (signbit(x) ? 0 : 2) : 1, ry = isnan(y) ? (signbit(y) ? 0 : 2) : 1;
+    if (rx != ry) return rx - ry;
+    if (rx != 1) return 0;
+    if (x != y) return (x > y) - (x < y);
+    return (signbit(y) != 0) - (signbit(x) != 0);
+}
+
+static int ref_compare_float(const void *a, const void *b) {
+    return ref_compare_double_value(*(const float*)a, *(const float*)b);
+}
+
+static int ref_compare_double(const void *a, const void *b) {
+    return ref_compare_double_value(*(const double*)a, *(const double*)b);
+}
+
 int main(void) {
     printf("AQUANT Library Comprehensive Test\n");
     printf("=================================\n\n");
@@ -44,6 +68,115 @@ int main(void) {
     if(sne) free_string(sne);
     printf("\n");
 
+    // --- Line Reader ---
+    printf("--- Line Reader ---\n");
+    FILE *reader_file = tmpfile();
+    if (reader_file != NULL) {
+        fputs("first\n\nno newline at end", reader_file);
+        for (int k = 0; k < 1000; ++k) fputc('a' + k % 26, reader_file);
+        rewind(reader_file);
+        aq_reader *reader = aq_reader_create_file(reader_file);
+        size_t line_len = 0;
+        const char *line = aq_reader_next_line(reader, &line_len);
+        check("aq_reader_next_line (first)", line != NULL && strcmp(line, "first") == 0 && line_len == 5);
+        line = aq_reader_next_line(reader, &line_len);
+        check("aq_reader_next_line (empty line)", line != NULL && line_len == 0 && line[0] == '\0');
+        line = aq_reader_next_line(reader, &line_len);
+        check("aq_reader_next_line (long, no newline)", line != NULL && line_len == 1017 && strncmp(line, "no newline at end", 17) == 0 && line[1016] == 'l');
+        check("aq_reader_next_line (EOF)", aq_reader_next_line(reader, &line_len) == NULL && line_len == 0);
+        aq_reader_destroy(reader);
+        fclose(reader_file);
+    }
+    check("aq_reader_create_file (NULL)", aq_reader_create_file(NULL) == NULL);
+    check("aq_reader_next_line (NULL)", aq_reader_next_line(NULL, NULL) == NULL);
+    aq_reader *mem_reader = aq_reader_create_buffer("a\nbc", 4);
+    size_t mem_len = 0;
+    const char *mem_line = aq_reader_next_line(mem_reader, &mem_len);
+    bool mem_ok = mem_line != NULL && strcmp(mem_line, "a") == 0;
+    mem_line = aq_reader_next_line(mem_reader, &mem_len);
+    mem_ok = mem_ok && mem_line != NULL && strcmp(mem_line, "bc") == 0 && mem_len == 2;
+    check("aq_reader_create_buffer", mem_ok && aq_reader_next_line(mem_reader, NULL) == NULL);
+    aq_reader_destroy(mem_reader);
+    printf("\n");
+
+    // --- Input Context ---
+    printf("--- Input Context ---\n");
+    const char *batch = "42\n 7 \nabc\n12x\n99999999999\n3.5\nq\n\n1e999\n5\ntext";
+    aq_input_ctx *in = aq_input_create_buffer(batch, strlen(batch));
+    int in_int = 0;
+    double in_double = 0;
+    char in_char = 0;
+    string in_str = NULL;
+    check("aq_input_get_int (ok)", aq_input_get_int(in, &in_int) == AQ_INPUT_OK && in_int == 42);
+    check("aq_input_get_int (spaces)", aq_input_get_int(in, &in_int) == AQ_INPUT_OK && in_int == 7);
+    check("aq_input_get_int (invalid)", aq_input_get_int(in, &in_int) == AQ_INPUT_INVALID && in_int == 7);
+    check("aq_input_get_int (trailing)", aq_input_get_int(in, &in_int) == AQ_INPUT_INVALID);
+    check("aq_input_get_int (range)", aq_input_get_int(in, &in_int) == AQ_INPUT_RANGE);
+    check("aq_input_get_double (ok)", aq_input_get_double(in, &in_double) == AQ_INPUT_OK && in_double == 3.5);
+    check("aq_input_get_char (ok)", aq_input_get_char(in, &in_char) == AQ_INPUT_OK && in_char == 'q');
+    check("aq_input_get_string_non_empty (empty)", aq_input_get_string_non_empty(in, &in_str) == AQ_INPUT_INVALID && in_str == NULL);
+    check("aq_input_get_double (overflow)", aq_input_get_double(in, &in_double) == AQ_INPUT_RANGE);
+    check("aq_input_get_int_range (out)", aq_input_get_int_range(in, 1, 4, &in_int) == AQ_INPUT_RANGE);
+    check("aq_input_line_number", aq_input_line_number(in) == 10);
+    check("aq_input_get_string (last line)", aq_input_get_string(in, &in_str) == AQ_INPUT_OK && string_equals(in_str, "text"));
+    free_string(in_str);
+    check("aq_input_get_int (EOF)", aq_input_get_int(in, &in_int) == AQ_INPUT_EOF);
+    aq_input_destroy(in);
+    check("aq_input_get_int (NULL ctx)", aq_input_get_int(NULL, &in_int) == AQ_INPUT_ERROR);
+    printf("\n");
+
+    // --- Numeric Scan ---
+    printf("--- Numeric Scan ---\n");
+    const char *int_text = " 1 -2\n\t+3  2147483647 -2147483648\n";
+    size_t scan_count = 0;
+    int *scanned_ints = aq_scan_int_array_buffer(int_text, strlen(int_text), &scan_count);
+    check("aq_scan_int_array_buffer (normal)", scanned_ints != NULL && scan_count == 5 && scanned_ints[0] == 1 && scanned_ints[1] == -2 && scanned_ints[2] == 3 && scanned_ints[3] == INT_MAX && scanned_ints[4] == INT_MIN);
+    free(scanned_ints);
+    check("aq_scan_int_array_buffer (overflow)", aq_scan_int_array_buffer("1 2147483648", 12, &scan_count) == NULL && scan_count == 0);
+    check("aq_scan_int_array_buffer (bad token)", aq_scan_int_array_buffer("1 2x 3", 6, &scan_count) == NULL && scan_count == 0);
+    check("aq_scan_int_array_buffer (empty)", aq_scan_int_array_buffer(" \n ", 3, &scan_count) == NULL && scan_count == 0);
+    const char *double_text = "0.1 -2.5e3 12345678901234567890123 inf";
+    double *scanned_doubles = aq_scan_double_array_buffer(double_text, strlen(double_text), &scan_count);
+    check("aq_scan_double_array_buffer (normal)", scanned_doubles != NULL && scan_count == 4 && scanned_doubles[0] == 0.1 && scanned_doubles[1] == -2500.0 && scanned_doubles[2] == 1.2345678901234567e22 && isinf(scanned_doubles[3]));
+    free(scanned_doubles);
+    check("aq_scan_double_array_buffer (underflow)", aq_scan_double_array_buffer("1 1e-400", 8, &scan_count) == NULL);
+    FILE *scan_file = tmpfile();
+    if (scan_file != NULL) {
+        for (int k = 0; k < 100000; ++k) fprintf(scan_file, "%d%c", k - 50000, (k % 7 == 0) ? '\n' : ' ');
+        rewind(scan_file);
+        scanned_ints = aq_scan_int_array(scan_file, &scan_count);
+        bool scan_ok = scanned_ints != NULL && scan_count == 100000;
+        for (size_t k = 0; scan_ok && k < scan_count; ++k) scan_ok = scanned_ints[k] == (int)k - 50000;
+        check("aq_scan_int_array (FILE, many blocks)", scan_ok);
+        free(scanned_ints);
+        fclose(scan_file);
+    }
+    printf("\n");
+
+    // --- Binary Array Files ---
+    printf("--- Binary Array Files ---\n");
+    const char *array_path = "aquant_test_array.bin";
+    double saved[1000];
+    for (int k = 0; k < 1000; ++k) saved[k] = k * 0.5 - 100.0;
+    check("aq_array_save_double", aq_array_save_double(array_path, saved, 1000));
+    size_t mapped_size = 0;
+    const double *mapped = aq_array_map_double(array_path, &mapped_size);
+    check("aq_array_map_double (contents)", mapped != NULL && mapped_size == 1000 && memcmp(mapped, saved, sizeof(saved)) == 0);
+    double mapped_max = 0;
+    check("aq_array_map_double (aligned, usable)", mapped != NULL && ((uintptr_t)mapped % 64) == 0 && array_max_double(mapped, mapped_size, &mapped_max) && mapped_max == 399.5);
+    check("aq_array_map_int (wrong type)", aq_array_map_int(array_path, &mapped_size) == NULL && mapped_size == 0);
+    int saved_ints[] = {3, 1, 2};
+    check("aq_array_save_int", aq_array_save_int(array_path, saved_ints, 3));
+    const int *mapped_ints = aq_array_map_int(array_path, &mapped_size);
+    check("aq_array_map_int", mapped_ints != NULL && mapped_size == 3 && mapped_ints[2] == 2 && array_contains_int(mapped_ints, mapped_size, 1));
+    check("aq_array_save_int (old mapping intact)", mapped != NULL && memcmp(mapped, saved, sizeof(saved)) == 0);
+    aq_array_unmap(mapped);
+    check("aq_array_save_int (missing directory)", !aq_array_save_int("aquant_no_such_dir/array.bin", saved_ints, 3));
+    aq_array_unmap(mapped_ints);
+    remove(array_path);
+    check("aq_array_map_float (missing file)", aq_array_map_float(array_path, &mapped_size) == NULL && mapped_size == 0);
+    printf("\n");
+
 
     // --- Integer Array Functions ---
     printf("--- Integer Array Functions ---\n");
@@ -97,11 +230,96 @@ int main(void) {
     check("array_average (empty)", isnan(array_average(arr_empty, size_empty)));
     check("array_average (single)", array_average(arr_single, size_single) == 42.0);
     check("array_average (NULL arr)", isnan(array_average(NULL, size1)));
+    aq_stats st;
+    check("array_stats_int (normal)", array_stats_int(arr1, size1, &st) && st.count == size1 && st.min == -2 && st.max == INT_MAX && st.argmin == 1 && st.argmax == 7);
+    check("array_stats_int (mean)", fabs(st.mean - array_average(arr1, size1)) < 0.001);
+    check("array_stats_int (variance)", array_stats_int(arr_dup, size_dup, &st) && st.variance == 0.0 && st.sum == 9.0);
+    check("array_stats_int (first min index)", array_stats_int(arr1, size1, &st) && st.argmin == 1 && array_stats_int(arr_neg, size_neg, &st) && st.argmin == 1 && st.argmax == 2);
+    check("array_stats_int (empty)", !array_stats_int(arr_empty, size_empty, &st));
+    check("array_stats_int (NULL out)", !array_stats_int(arr1, size1, NULL));
+    // Long arrays run the 32/64-element vector loops and fold the tail; odd
+    // sizes leave tails of every length. The extremes sit in the last elements,
+    // and the int values sum far past INT_MAX. Results must match plain loops.
+    size_t reduce_sizes[] = {65, 67, 97, 131, 255, 1023};
+    bool reduce_int_ok = true, reduce_float_ok = true, reduce_double_ok = true;
+    for (size_t t = 0; t < sizeof(reduce_sizes) / sizeof(reduce_sizes[0]); ++t) {
+        size_t n = reduce_sizes[t];
+        int *ri = malloc(n * sizeof(int));
+        float *rf = malloc(n * sizeof(float));
+        double *rd = malloc(n * sizeof(double));
+        if (!ri || !rf || !rd) { free(ri); free(rf); free(rd); reduce_int_ok = reduce_float_ok = reduce_double_ok = false; break; }
+        for (size_t k = 0; k < n; ++k) {
+            ri[k] = (k % 2 == 0) ? INT_MAX - (int)(k * 37 % 1000) : -(int)(k * 53 % 100000);
+            rf[k] = (float)((int)(k * 7919 % 2001) - 1000) * 0.37f;
+            rd[k] = ((int)(k * 7919 % 2001) - 1000) * 1.25e-3;
+        }
+        ri[n - 1] = (t % 2 == 0) ? INT_MIN : INT_MAX; ri[n - 2] = (t % 2 == 0) ? INT_MAX : INT_MIN;
+        rf[n - 1] = (t % 2 == 0) ? -5000.0f : 5000.0f;
+        rd[n - 1] = (t % 2 == 0) ? 5000.0 : -5000.0;
+
+        int imin = ri[0], imax = ri[0]; size_t iargmin = 0, iargmax = 0; long long isum = 0;
+        float fmin = rf[0], fmax = rf[0]; double fsum = 0, fabs_sum = 0;
+        double dmin = rd[0], dmax = rd[0], dsum = 0, dabs_sum = 0;
+        for (size_t k = 0; k < n; ++k) {
+            if (ri[k] < imin) { imin = ri[k]; iargmin = k; }
+            if (ri[k] > imax) { imax = ri[k]; iargmax = k; }
+            isum += ri[k];
+            if (rf[k] < fmin) fmin = rf[k];
+            if (rf[k] > fmax) fmax = rf[k];
+            fsum += rf[k]; fabs_sum += fabs(rf[k]);
+            if (rd[k] < dmin) dmin = rd[k];
+            if (rd[k] > dmax) dmax = rd[k];
+            dsum += rd[k]; dabs_sum += fabs(rd[k]);
+        }
+        double imean = (double)isum / n, im2 = 0;
+        for (size_t k = 0; k < n; ++k) im2 += (ri[k] - imean) * (ri[k] - imean);
+
+        int gi_min = 0, gi_max = 0; long long gi_sum = 0;
+        if (!array_min(ri, n, &gi_min) || gi_min != imin || !array_max(ri, n, &gi_max) || gi_max != imax ||
+            !array_sum(ri, n, &gi_sum) || gi_sum != isum || !array_stats_int(ri, n, &st) ||
+            st.min != imin || st.max != imax || st.argmin != iargmin || st.argmax != iargmax || st.sum != (double)isum ||
+            fabs(st.variance - im2 / n) > 1e-9 * (im2 / n)) reduce_int_ok = false;
+        float gf_min = 0, gf_max = 0; double gf_sum = 0;
+        if (!array_min_float(rf, n, &gf_min) || gf_min != fmin || !array_max_float(rf, n, &gf_max) || gf_max != fmax ||
+            !array_sum_float(rf, n, &gf_sum) || fabs(gf_sum - fsum) > n * DBL_EPSILON * fabs_sum) reduce_float_ok = false;
+        double gd_min = 0, gd_max = 0, gd_sum = 0;
+        if (!array_min_double(rd, n, &gd_min) || gd_min != dmin || !array_max_double(rd, n, &gd_max) || gd_max != dmax ||
+            !array_sum_double(rd, n, &gd_sum) || fabs(gd_sum - dsum) > n * DBL_EPSILON * dabs_sum) reduce_double_ok = false;
+        free(ri); free(rf); free(rd);
+    }
+    check("array_min/max/sum/stats_int (long arrays, tails, overflow)", reduce_int_ok);
+    check("array_min/max/sum_float (long arrays, tails)", reduce_float_ok);
+    check("array_min/max/sum_double (long arrays, tails)", reduce_double_ok);
+    int nth_val, top3[3];
+    double pct_in[] = {0.0, 100.0, 25.0}, pct_out[3];
+    check("array_nth_int", array_nth_int(arr1, size1, 0, &nth_val) && nth_val == -2 && array_nth_int(arr1, size1, 7, &nth_val) && nth_val == INT_MAX);
+    check("array_nth_int (out of range)", !array_nth_int(arr1, size1, size1, &nth_val));
+    check("array_median_int (even size)", array_median_int(arr1, size1) == 5.0);
+    check("array_median_int (empty)", isnan(array_median_int(arr_empty, size_empty)));
+    check("array_percentiles_int", array_percentiles_int(arr1, size1, pct_in, 3, pct_out) && pct_out[0] == -2.0 && pct_out[1] == (double)INT_MAX && fabs(pct_out[2] - 0.75) < 1e-12);
+    check("array_percentiles_int (invalid percent)", !array_percentiles_int(arr1, size1, (double[]){101.0}, 1, pct_out));
+    check("array_top_k_int", array_top_k_int(arr1, size1, 3, top3) && top3[0] == INT_MAX && top3[1] == 9 && top3[2] == 8);
+    check("array_top_k_int (k > size)", !array_top_k_int(arr_single, size_single, 2, top3));
     check("array_count_occurrence (multiple)", array_count_occurrence(arr1, size1, 5) == 2);
     check("array_count_occurrence (single)", array_count_occurrence(arr1, size1, 8) == 1);
     check("array_count_occurrence (none)", array_count_occurrence(arr1, size1, 100) == 0);
     check("array_count_occurrence (empty)", array_count_occurrence(arr_empty, size_empty, 5) == 0);
     check("array_count_occurrence (NULL arr)", array_count_occurrence(NULL, size1, 5) == 0);
+    int search_arr[100];
+    for (int k = 0; k < 100; ++k) search_arr[k] = k % 50;
+    check("array_index_of_int (vector blocks)", array_index_of_int(search_arr, 100, 49) == 49 && array_count_occurrence(search_arr, 100, 7) == 2 && !array_contains_int(search_arr, 100, 50));
+    aq_histogram *hist = aq_histogram_create_int(arr1, size1); // Range includes INT_MAX: sparse
+    check("aq_histogram_count_int (sparse)", hist != NULL && aq_histogram_count_int(hist, 5) == 2 && aq_histogram_count_int(hist, INT_MAX) == 1 && aq_histogram_count_int(hist, 100) == 0);
+    size_t hist_cursor = 0, hist_total = 0, hist_count; int hist_value;
+    while (aq_histogram_next_int(hist, &hist_cursor, &hist_value, &hist_count)) hist_total += hist_count;
+    check("aq_histogram_next_int (sparse)", hist_total == size1 && aq_histogram_distinct(hist) == 7);
+    aq_histogram_destroy(hist);
+    hist = aq_histogram_create_int(arr_neg, size_neg); // Small range: dense, ascending iteration
+    hist_cursor = 0;
+    check("aq_histogram_next_int (dense)", hist != NULL && aq_histogram_next_int(hist, &hist_cursor, &hist_value, &hist_count) && hist_value == -10 && hist_count == 1);
+    check("aq_histogram_count_int (dense)", aq_histogram_count_int(hist, -5) == 1 && aq_histogram_count_int(hist, -6) == 0 && aq_histogram_count_int(hist, INT_MIN) == 0);
+    aq_histogram_destroy(hist);
+    check("aq_histogram_create_int (empty)", aq_histogram_create_int(arr_empty, size_empty) == NULL);
     arr_copy = array_copy_int(arr1, size1);
     check("array_copy_int (check content)", arr_copy != NULL && arr_copy[0] == 5 && arr_copy[size1 - 1] == INT_MAX);
     check("array_copy_int (check distinct ptr)", arr_copy != arr1);
@@ -124,6 +342,9 @@ int main(void) {
     check("array_has_pair_product (no)", !array_has_pair_product(pair_prod_arr, 5, 11));
     check("array_has_pair_product (empty)", !array_has_pair_product(arr_empty, size_empty, 10));
     check("array_has_pair_product (NULL arr)", !array_has_pair_product(NULL, 5, 10));
+    int pair_min_arr[] = {INT_MIN, -1, 5};
+    int pair_min_ok[] = {1, INT_MIN};
+    check("array_has_pair_product (INT_MIN)", !array_has_pair_product(pair_min_arr, 3, INT_MIN) && array_has_pair_product(pair_min_ok, 2, INT_MIN));
     int pair_diff_arr[] = {1, 5, 9, 10};
     check("array_has_pair_difference (yes)", array_has_pair_difference(pair_diff_arr, 4, 4));
     check("array_has_pair_difference (yes, neg target)", array_has_pair_difference(pair_diff_arr, 4, -4));
@@ -131,6 +352,8 @@ int main(void) {
     check("array_has_pair_difference (no)", !array_has_pair_difference(pair_diff_arr, 4, 2));
     check("array_has_pair_difference (empty)", !array_has_pair_difference(arr_empty, size_empty, 1));
     check("array_has_pair_difference (NULL arr)", !array_has_pair_difference(NULL, 4, 1));
+    int pair_diff_min[] = {0, INT_MIN};
+    check("array_has_pair_difference (INT_MIN)", array_has_pair_difference(pair_diff_min, 2, INT_MIN) && !array_has_pair_difference(pair_min_arr, 3, INT_MIN));
     arr_copy = array_copy_int(arr1, size1);
     if(arr_copy) {
         sort_array(arr_copy, size1);
@@ -141,6 +364,71 @@ int main(void) {
     }
     sort_array(arr_empty, size_empty);
     check("sort_array (empty)", true);
+    size_t big_n = 200000;
+    int *big_a = malloc(big_n * sizeof(int)), *big_b = malloc(big_n * sizeof(int));
+    if (big_a && big_b) {
+        for (size_t k = 0; k < big_n; ++k) big_a[k] = (int)(uint32_t)(k * 2654435761u); // Spread over the full int range
+        memcpy(big_b, big_a, big_n * sizeof(int));
+        sort_array(big_a, big_n);
+        sort_array_parallel(big_b, big_n, 4);
+        bool sorted = true;
+        for (size_t k = 1; k < big_n; ++k) if (big_a[k - 1] > big_a[k]) sorted = false;
+        check("sort_array (large, radix)", sorted);
+        check("sort_array_parallel (matches serial)", memcmp(big_a, big_b, big_n * sizeof(int)) == 0);
+    }
+    free(big_a); free(big_b);
+    // Both sort paths (stack quicksort up to 256 elements, radix above) against qsort,
+    // with negatives, duplicates, extremes and, for floats/doubles, +-0.0, +-inf and +-NaN.
+    size_t sort_sizes[] = {200, 1001};
+    bool int_ok = true, float_ok = true, double_ok = true;
+    for (size_t t = 0; t < 2; ++t) {
+        size_t n = sort_sizes[t];
+        int *ia = malloc(n * sizeof(int)), *ib = malloc(n * sizeof(int));
+        float *fa = malloc(n * sizeof(float)), *fb = malloc(n * sizeof(float));
+        double *da = malloc(n * sizeof(double)), *db = malloc(n * sizeof(double));
+        if (!ia || !ib || !fa || !fb || !da || !db) { int_ok = float_ok = double_ok = false; }
+        else {
+            for (size_t k = 0; k < n; ++k) {
+                int v = (int)((k * 7919) % 601) - 300;
+                ia[k] = (k % 97 == 0) ? INT_MIN : (k % 89 == 0) ? INT_MAX : v;
+                double d = v * 0.25;
+                switch (k % 53) {
+                    case 0: d = -0.0; break;
+                    case 1: d = 0.0; break;
+                    case 2: d = NAN; break;
+                    case 3: d = -NAN; break;
+                    case 4: d = INFINITY; break;
+                    case 5: d = -INFINITY; break;
+                    case 6: d = v * 1e30; break;
+                }
+                da[k] = d; fa[k] = (float)d;
+            }
+            memcpy(ib, ia, n * sizeof(int)); memcpy(fb, fa, n * sizeof(float)); memcpy(db, da, n * sizeof(double));
+            sort_array(ia, n); qsort(ib, n, sizeof(int), ref_compare_int);
+            sort_array_float(fa, n); qsort(fb, n, sizeof(float), ref_compare_float);
+            sort_array_double(da, n); qsort(db, n, sizeof(double), ref_compare_double);
+            if (memcmp(ia, ib, n * sizeof(int)) != 0) int_ok = false;
+            if (memcmp(fa, fb, n * sizeof(float)) != 0 || !signbit(fa[0]) || !isnan(fa[0]) || !isnan(fa[n - 1])) float_ok = false;
+            if (memcmp(da, db, n * sizeof(double)) != 0 || !signbit(da[0]) || !isnan(da[0]) || !isnan(da[n - 1])) double_ok = false;
+        }
+        free(ia); free(ib); free(fa); free(fb); free(da); free(db);
+    }
+    check("sort_array (small and radix, matches qsort)", int_ok);
+    check("sort_array_float (small and radix, +-0.0, NaN, matches qsort)", float_ok);
+    check("sort_array_double (small and radix, +-0.0, NaN, matches qsort)", double_ok);
+    aq_index *idx = aq_index_create_int(arr1, size1);
+    check("aq_index_create_int", idx != NULL && aq_index_size(idx) == size1);
+    check("aq_index_contains_int (present)", aq_index_contains_int(idx, INT_MAX) && aq_index_contains_int(idx, -2));
+    check("aq_index_contains_int (not present)", !aq_index_contains_int(idx, 7) && !aq_index_contains_int(idx, INT_MIN));
+    check("aq_index_index_of_int (first occurrence)", aq_index_index_of_int(idx, 5) == 0 && aq_index_index_of_int(idx, 9) == 4);
+    check("aq_index_index_of_int (not present)", aq_index_index_of_int(idx, 3) == -1);
+    check("aq_index_lower_bound_int", aq_index_lower_bound_int(idx, 5) == 3 && aq_index_lower_bound_int(idx, INT_MIN) == 0);
+    check("aq_index_count_range_int", aq_index_count_range_int(idx, 0, 5) == 4 && aq_index_count_range_int(idx, 9, INT_MAX) == 2);
+    int idx_queries[] = {8, 4, -2, 6}; bool idx_found[4];
+    check("aq_index_contains_batch_int", aq_index_contains_batch_int(idx, idx_queries, 4, idx_found) == 2 && idx_found[0] && !idx_found[1] && idx_found[2] && !idx_found[3]);
+    check("aq_index (wrong type)", !aq_index_contains_float(idx, 5.0f) && aq_index_index_of_double(idx, 5.0) == -1);
+    aq_index_destroy(idx);
+    check("aq_index_create_int (empty)", aq_index_create_int(arr_empty, size_empty) == NULL);
     sort_array(arr_single, size_single);
     check("sort_array (single)", arr_single[0] == 42);
     printf("print_array (normal): "); print_array(arr1, size1);
@@ -202,8 +490,21 @@ int main(void) {
     check("array_min_float", array_min_float(farr1, fsize1, &fmin_val) && fabs(fmin_val - (-1.0f)) < FLOAT_EPSILON);
     check("array_sum_float", array_sum_float(farr1, fsize1, &fsum_val) && fabs(fsum_val - (3.14 - 1.0 + 0.0 + 100.5 + 3.14)) < DOUBLE_EPSILON);
     check("array_average_float", fabs(array_average_float(farr1, fsize1) - ((3.14 - 1.0 + 0.0 + 100.5 + 3.14) / 5.0)) < DOUBLE_EPSILON);
+    aq_stats fst;
+    check("array_stats_float", array_stats_float(farr1, fsize1, &fst) && fst.argmin == 1 && fst.argmax == 3 && fabs(fst.mean - array_average_float(farr1, fsize1)) < DOUBLE_EPSILON);
+    double fvar = 0.0;
+    for (size_t k = 0; k < fsize1; ++k) fvar += (farr1[k] - fst.mean) * (farr1[k] - fst.mean);
+    check("array_stats_float (variance)", fabs(fst.variance - fvar / fsize1) < 1e-6);
     check("array_contains_float", array_contains_float(farr1, fsize1, 3.14f));
     check("array_index_of_float", array_index_of_float(farr1, fsize1, 0.0f) == 2);
+    float fnth, ftop[2];
+    check("array_nth_float", array_nth_float(farr1, fsize1, 1, &fnth) && fnth == 0.0f);
+    check("array_median_float", array_median_float(farr1, fsize1) == (double)3.14f);
+    check("array_top_k_float", array_top_k_float(farr1, fsize1, 2, ftop) && ftop[0] == 100.5f && ftop[1] == 3.14f);
+    aq_index *fidx = aq_index_create_float(farr1, fsize1);
+    check("aq_index_index_of_float", aq_index_index_of_float(fidx, 3.14f) == 0 && aq_index_index_of_float(fidx, -0.0f) == 2 && aq_index_index_of_float(fidx, 2.0f) == -1);
+    check("aq_index_count_range_float", aq_index_count_range_float(fidx, 0.0f, 3.5f) == 3);
+    aq_index_destroy(fidx);
     check("array_count_occurrence_float", array_count_occurrence_float(farr1, fsize1, 3.14f) == 2);
     farr_copy = array_copy_float(farr1, fsize1);
     check("array_copy_float", farr_copy != NULL && fabs(farr_copy[0] - 3.14f) < FLOAT_EPSILON);
@@ -258,9 +559,60 @@ int main(void) {
     check("find_string (first occurrence)", find_string(sarr1, ssize1, "Apple") == 0);
     check("find_string (NULL)", find_string(sarr1, ssize1, NULL) == 4);
     check("find_string (not present)", find_string(sarr1, ssize1, "Orange") == -1);
+    aq_index *sidx = aq_index_create_string(sarr1, ssize1);
+    check("aq_index_contains_string", aq_index_contains_string(sidx, "Banana") && aq_index_contains_string(sidx, "") && aq_index_contains_string(sidx, NULL) && !aq_index_contains_string(sidx, "Orange"));
+    check("aq_index_index_of_string", aq_index_index_of_string(sidx, "Apple") == 0 && aq_index_index_of_string(sidx, "Cherry") == 2 && aq_index_index_of_string(sidx, NULL) == -1);
+    check("aq_index_lower_bound_string", aq_index_lower_bound_string(sidx, "Banana") == 4);
+    aq_index_destroy(sidx);
     check("array_count_occurrence_string (multiple)", array_count_occurrence_string(sarr1, ssize1, "Apple") == 2);
     check("array_count_occurrence_string (NULL)", array_count_occurrence_string(sarr1, ssize1, NULL) == 1);
     check("array_count_occurrence_string (none)", array_count_occurrence_string(sarr1, ssize1, "Orange") == 0);
+    aq_histogram *shist = aq_histogram_create_string(sarr1, ssize1);
+    check("aq_histogram_count_string", aq_histogram_count_string(shist, "Apple") == 2 && aq_histogram_count_string(shist, NULL) == 1 && aq_histogram_count_string(shist, "") == 1 && aq_histogram_count_string(shist, "Orange") == 0);
+    check("aq_histogram_distinct (string)", aq_histogram_distinct(shist) == 5);
+    size_t shist_cursor = 0, shist_count = 0; string shist_value = "x";
+    check("aq_histogram_next_string (NULL first, then first-occurrence order)", aq_histogram_next_string(shist, &shist_cursor, &shist_value, &shist_count) && shist_value == NULL && aq_histogram_next_string(shist, &shist_cursor, &shist_value, &shist_count) && string_equals(shist_value, "Apple") && shist_count == 2);
+    aq_histogram_destroy(shist);
+    string *sarr_unique = array_unique_string(sarr1, ssize1, &snew_size);
+    check("array_unique_string", sarr_unique != NULL && snew_size == 5 && string_equals(sarr_unique[0], "Apple") && string_equals(sarr_unique[2], "Cherry") && sarr_unique[3] == NULL && string_equals(sarr_unique[4], "") && sarr_unique[0] != sarr1[0]);
+    free_string_array(sarr_unique, snew_size);
+    check("array_unique_string (empty)", array_unique_string(sarr_empty, ssize_empty, &snew_size) == NULL && snew_size == 0);
+    aq_strset *sset = aq_strset_create(0);
+    for (size_t i = 0; i < ssize1; ++i) aq_strset_add(sset, sarr1[i]);
+    check("aq_strset_add / aq_strset_contains", aq_strset_size(sset) == 4 && aq_strset_contains(sset, "Banana") && aq_strset_contains(sset, "") && !aq_strset_contains(sset, NULL) && !aq_strset_contains(sset, "Orange"));
+    check("aq_strset_contains_view", aq_strset_contains_view(sset, (aq_strview){ "Cherry pie", 6 }) && !aq_strset_contains_view(sset, (aq_strview){ "Cherry pie", 7 }));
+    check("aq_strset_remove", aq_strset_remove(sset, "Apple") && !aq_strset_remove(sset, "Apple") && !aq_strset_contains(sset, "Apple") && aq_strset_contains(sset, "Cherry") && aq_strset_size(sset) == 3);
+    char sset_key[16];
+    for (int i = 0; i < 1000; ++i) { snprintf(sset_key, sizeof(sset_key), "key%d", i); aq_strset_add(sset, sset_key); }
+    snprintf(sset_key, sizeof(sset_key), "key%d", 999);
+    check("aq_strset (grown, owns keys)", aq_strset_size(sset) == 1003 && aq_strset_contains(sset, "key0") && aq_strset_contains(sset, "key999") && !aq_strset_contains(sset, "key1000"));
+    aq_strset_clear(sset);
+    check("aq_strset_clear", aq_strset_size(sset) == 0 && !aq_strset_contains(sset, "Banana"));
+    aq_strset_destroy(sset);
+    aq_strmap *smap = aq_strmap_create(4);
+    for (size_t i = 0; i < ssize1; ++i) if (sarr1[i] != NULL) (*aq_strmap_ref(smap, sarr1[i]))++;
+    size_t smap_value = 0;
+    check("aq_strmap_ref (counting)", aq_strmap_size(smap) == 4 && aq_strmap_get(smap, "Apple", &smap_value) && smap_value == 2 && !aq_strmap_get(smap, "Orange", &smap_value));
+    check("aq_strmap_put (overwrite)", aq_strmap_put(smap, "Apple", 7) && aq_strmap_get(smap, "Apple", &smap_value) && smap_value == 7 && aq_strmap_size(smap) == 4);
+    size_t smap_cursor = 0; string smap_key = NULL;
+    check("aq_strmap_next (insertion order)", aq_strmap_next(smap, &smap_cursor, &smap_key, &smap_value) && string_equals(smap_key, "Apple") && smap_value == 7);
+    check("aq_strmap_remove", aq_strmap_remove(smap, "Banana") && !aq_strmap_get(smap, "Banana", NULL) && aq_strmap_get_view(smap, (aq_strview){ "Cherry", 6 }, &smap_value) && smap_value == 1 && aq_strmap_size(smap) == 3);
+    aq_strmap_destroy(smap);
+    aq_intern *pool = aq_intern_create(0);
+    char intern_buffer[] = "Banana";
+    string interned = aq_intern_string(pool, "Banana");
+    check("aq_intern_string (one pointer per value)", interned != NULL && interned == aq_intern_string(pool, intern_buffer) && interned != aq_intern_string(pool, "Apple") && string_equals(interned, "Banana"));
+    check("aq_intern_id / aq_intern_lookup", aq_intern_id(pool, interned) == 0 && aq_intern_id(pool, intern_buffer) == 0 && aq_intern_id(pool, "Apple") == 1 && aq_intern_id(pool, "Kiwi") == AQ_INTERN_NONE && aq_intern_lookup(pool, 1) != NULL && aq_intern_lookup(pool, 2) == NULL);
+    string *sarr_interned = aq_intern_copy_string_array(pool, sarr1, ssize1);
+    check("aq_intern_copy_string_array (shared storage)", sarr_interned != NULL && sarr_interned[0] == sarr_interned[3] && sarr_interned[0] != sarr1[0] && string_equals(sarr_interned[2], "Cherry") && sarr_interned[4] == NULL && aq_intern_size(pool) == 4);
+    aq_intern_sort(pool, sarr_interned, ssize1);
+    check("aq_intern_sort", sarr_interned[0] == NULL && string_equals(sarr_interned[1], "") && sarr_interned[2] == sarr_interned[3] && string_equals(sarr_interned[2], "Apple") && string_equals(sarr_interned[5], "Cherry"));
+    free(sarr_interned);
+    string intern_left[] = {"A", "B"}, intern_right[] = {NULL, "D"};
+    sarr_concat = aq_intern_concat_string(pool, intern_left, 2, intern_right, 2, &snew_size);
+    check("aq_intern_concat_string", sarr_concat != NULL && snew_size == 4 && sarr_concat[0] == aq_intern_string(pool, "A") && sarr_concat[2] == NULL && string_equals(sarr_concat[3], "D"));
+    free(sarr_concat); sarr_concat = NULL;
+    aq_intern_destroy(pool);
     sarr_copy = array_copy_string_array(sarr1, ssize1);
     check("array_copy_string_array (check content)", sarr_copy != NULL && string_equals(sarr_copy[0], "Apple") && sarr_copy[4] == NULL && string_equals(sarr_copy[5],""));
     check("array_copy_string_array (check distinct ptrs)", sarr_copy != sarr1 && (sarr_copy[0] == NULL || sarr_copy[0] != sarr1[0]));
@@ -272,6 +624,25 @@ int main(void) {
         check("sort_array_string", sarr_copy[0]==NULL && string_equals(sarr_copy[1],"") && string_equals(sarr_copy[5],"Cherry"));
         free_string_array(sarr_copy, ssize1); sarr_copy = NULL;
     }
+    size_t skey_n = 5000;
+    char (*skey_pool)[48] = malloc(skey_n * sizeof(*skey_pool));
+    string *skeys = malloc(skey_n * sizeof(string));
+    if (skey_pool && skeys) {
+        for (size_t k = 0; k < skey_n; ++k) {
+            uint32_t h = (uint32_t)(k * 2654435761u);
+            // Long shared prefixes, duplicates, length ties at 8-byte boundaries and a non-ASCII byte
+            snprintf(skey_pool[k], sizeof(skey_pool[k]), "GET /api/v1/item/%u%s", h % 700, (h >> 12) % 3 == 0 ? "" : ((h >> 12) % 3 == 1 ? "/x" : "\xE9"));
+            skeys[k] = (k % 97 == 0) ? NULL : skey_pool[k];
+        }
+        sort_array_string(skeys, skey_n);
+        bool skeys_sorted = true;
+        for (size_t k = 1; k < skey_n; ++k) {
+            if (skeys[k - 1] == NULL) continue;
+            if (skeys[k] == NULL || strcmp(skeys[k - 1], skeys[k]) > 0) skeys_sorted = false;
+        }
+        check("sort_array_string (large, shared prefixes)", skeys_sorted && skeys[0] == NULL && skeys[(skey_n + 96) / 97 - 1] == NULL && skeys[(skey_n + 96) / 97] != NULL);
+    }
+    free(skey_pool); free(skeys);
     printf("print_string_array (normal): "); print_string_array(sarr1, ssize1);
     printf("print_string_array (empty): "); print_string_array(sarr_empty, ssize_empty);
     printf("print_string_array (NULL arr): "); print_string_array(NULL, 0);
@@ -314,6 +685,8 @@ int main(void) {
     str_trim_res = string_trim("   "); check("string_trim (all space)", string_equals(str_trim_res, "")); if(str_trim_res) free_string(str_trim_res);
     str_trim_res = string_trim(""); check("string_trim (empty)", string_equals(str_trim_res, "")); if(str_trim_res) free_string(str_trim_res);
     str_trim_res = string_trim(NULL); check("string_trim (NULL)", str_trim_res == NULL);
+    char trim_buffer[] = " \t in place \n";
+    check("string_trim_in_place", string_trim_in_place(trim_buffer) == 8 && string_equals(trim_buffer, "in place"));
     check("string_is_int (yes)", string_is_int("123"));
     check("string_is_int (yes, neg)", string_is_int("-45"));
     check("string_is_int (yes, space)", string_is_int("  +678  "));
@@ -322,6 +695,8 @@ int main(void) {
     check("string_is_int (no, trailing)", !string_is_int("123a"));
     check("string_is_int (no, empty)", !string_is_int(""));
     check("string_is_int (no, NULL)", !string_is_int(NULL));
+    check("string_is_int (yes, long digits)", string_is_int("\t1234567890123456789012345\n"));
+    check("string_is_int (no, sign only)", !string_is_int(" - "));
     check("string_is_alpha (yes)", string_is_alpha("HelloWorld"));
     check("string_is_alpha (no, space)", !string_is_alpha("Hello World"));
     check("string_is_alpha (no, digit)", !string_is_alpha("Hello9"));
@@ -331,6 +706,13 @@ int main(void) {
     check("string_is_alnum (no, symbol)", !string_is_alnum("Alpha!123"));
     check("string_is_space (yes)", string_is_space(" \t\n\r "));
     check("string_is_space (no, alpha)", !string_is_space(" a "));
+    char long_class[201];
+    memset(long_class, 'x', 200); long_class[200] = '\0';
+    check("string_is_alpha (long)", string_is_alpha(long_class) && !string_is_digit(long_class));
+    long_class[150] = '7';
+    check("string_is_alpha / string_is_alnum (long, late digit)", !string_is_alpha(long_class) && string_is_alnum(long_class));
+    long_class[199] = '\x80';
+    check("string_is_alnum (long, non-ASCII byte)", !string_is_alnum(long_class));
     check("string_is_empty (yes, null)", string_is_empty(NULL));
     check("string_is_empty (yes, empty)", string_is_empty(""));
     check("string_is_empty (no)", !string_is_empty("a"));
@@ -352,7 +734,21 @@ int main(void) {
     check("string_find_substring (not found)", string_find_substring("Test String", "XYZ") == -1);
     check("string_find_substring (empty needle)", string_find_substring("Test String", "") == 0);
     str_replace = string_replace_char("Hello World", 'o', 'X'); check("string_replace_char", string_equals(str_replace, "HellX WXrld")); if(str_replace) free_string(str_replace);
+    str_replace = string_replace_all("aaa-aaa", "aa", "b"); check("string_replace_all", string_equals(str_replace, "ba-ba")); if(str_replace) free_string(str_replace);
+    str_replace = string_replace_all("x.y", ".", "::"); check("string_replace_all (grow)", string_equals(str_replace, "x::y")); if(str_replace) free_string(str_replace);
+    str_replace = string_replace_all("abc", "", "X"); check("string_replace_all (empty from)", string_equals(str_replace, "abc")); if(str_replace) free_string(str_replace);
+    str_replace = string_replace_all("a, b, c", ", ", NULL); check("string_replace_all (NULL to deletes)", string_equals(str_replace, "abc")); if(str_replace) free_string(str_replace);
+    char in_place_text[] = "one  two   three";
+    check("string_replace_all_in_place", string_replace_all_in_place(in_place_text, "  ", " ") == 2 && string_equals(in_place_text, "one two  three"));
+    check("string_replace_all_in_place (grow refused)", string_replace_all_in_place(in_place_text, "o", "oo") == 0 && string_equals(in_place_text, "one two  three"));
     str_lower = string_to_lower("HeLlO"); check("string_to_lower", string_equals(str_lower, "hello")); if(str_lower) free_string(str_lower);
+    char case_buffer[] = "Mixed Case Text, 40 chars of it: AbC-xYz!";
+    string_to_upper_in_place(case_buffer);
+    check("string_to_upper_in_place", string_equals(case_buffer, "MIXED CASE TEXT, 40 CHARS OF IT: ABC-XYZ!"));
+    string_to_lower_in_place(case_buffer);
+    check("string_to_lower_in_place", string_equals(case_buffer, "mixed case text, 40 chars of it: abc-xyz!"));
+    str_lower = string_to_lower("ABCDEFGHIJKLMNOPQRSTUVWXYZ \xC9 ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+    check("string_to_lower (long, non-ASCII byte kept)", string_equals(str_lower, "abcdefghijklmnopqrstuvwxyz \xC9 abcdefghijklmnopqrstuvwxyz")); if(str_lower) free_string(str_lower);
     str_upper = string_to_upper("HeLlO"); check("string_to_upper", string_equals(str_upper, "HELLO")); if(str_upper) free_string(str_upper);
     str_tokens = string_split("a,b,,d,", ',', &num_tokens); check("string_split (normal)", num_tokens==5 && string_equals(str_tokens[0],"a") && string_equals(str_tokens[2],"") && string_equals(str_tokens[4],"")); if(str_tokens) free_string_array(str_tokens, num_tokens);
     str_tokens = string_split("onlyone", ',', &num_tokens); check("string_split (no delimiter)", num_tokens==1 && string_equals(str_tokens[0],"onlyone")); if(str_tokens) free_string_array(str_tokens, num_tokens);
@@ -372,6 +768,216 @@ int main(void) {
     check("string_to_float (no)", string_to_float(" abc ", &success) == 0.0f && !success);
     check("string_to_double (yes)", fabs(string_to_double(" 9.87e-2 ", &success) - 0.0987) < DOUBLE_EPSILON && success);
     check("string_to_double (no)", string_to_double(" --5.5 ", &success) == 0.0 && !success);
+    check("string_to_double (exact rounding)", string_to_double("0.1", &success) == 0.1 && string_to_double("2.2250738585072014e-308", &success) == DBL_MIN && string_to_double("123456789012345678901234567890", &success) == 123456789012345678901234567890.0 && success);
+    check("string_to_double (subnormal)", string_to_double("4.9e-324", &success) > 0.0 && success);
+    check("string_to_double (overflow)", string_to_double("1e400", &success) == 0.0 && !success);
+    check("string_to_double (underflow)", string_to_double("1e-400", &success) == 0.0 && !success);
+    check("string_to_double (inf)", isinf(string_to_double("-Infinity", &success)) && success);
+    check("string_to_float (overflow)", string_to_float("3.5e38", &success) == 0.0f && !success);
+    check("string_to_double (hex float)", string_to_double("0x1.8p1", &success) == 3.0 && success && string_to_double(" -0xA.Cp-2 ", &success) == -2.6875 && success);
+    check("string_to_float (hex float)", string_to_float("0x.4", &success) == 0.25f && success);
+    check("string_to_float (exact rounding)", string_to_float("16777217", &success) == 16777216.0f && string_to_float("1.17549435e-38", &success) == FLT_MIN && success);
+    printf("\n");
+
+    // --- Arena Strings ---
+    printf("--- Arena Strings ---\n");
+    aq_arena *arena = aq_arena_create(64);
+    check("aq_arena_create", arena != NULL);
+    string arena_copy = string_copy_a(arena, "Arena");
+    string arena_trim = string_trim_a(arena, "  padded \t");
+    string arena_concat = string_concat_a(arena, arena_copy, "!");
+    check("string_copy_a / string_trim_a / string_concat_a", string_equals(arena_copy, "Arena") && string_equals(arena_trim, "padded") && string_equals(arena_concat, "Arena!"));
+    check("string_substring_a", string_equals(string_substring_a(arena, "ABCDEFG", 2, (size_t)-1), "CDEFG"));
+    check("string_to_lower_a / string_to_upper_a", string_equals(string_to_lower_a(arena, "MiXeD"), "mixed") && string_equals(string_to_upper_a(arena, "MiXeD"), "MIXED"));
+    check("string_replace_char_a", string_equals(string_replace_char_a(arena, "a.b.c", '.', '/'), "a/b/c"));
+    check("string_replace_all_a", string_equals(string_replace_all_a(arena, "a.b.c", ".", "->"), "a->b->c"));
+    str_tokens = string_split_a(arena, "x,,yz,", ',', &num_tokens);
+    check("string_split_a", num_tokens == 4 && string_equals(str_tokens[0], "x") && string_equals(str_tokens[1], "") && string_equals(str_tokens[2], "yz") && string_equals(str_tokens[3], ""));
+    check("string_join_a", string_equals(string_join_a(arena, str_tokens, num_tokens, "-"), "x--yz-"));
+    check("aq_arena_alloc (aligned)", ((uintptr_t)aq_arena_alloc(arena, 3) % AQ_ARENA_ALIGN) == 0 && ((uintptr_t)aq_arena_alloc(arena, 1) % AQ_ARENA_ALIGN) == 0);
+    string arena_big = aq_arena_alloc(arena, 1000); // Larger than the block size
+    if (arena_big) { memset(arena_big, 'z', 999); arena_big[999] = '\0'; }
+    check("aq_arena_alloc (oversized)", arena_big != NULL && strlen(arena_big) == 999 && string_equals(arena_copy, "Arena"));
+    aq_arena_reset(arena);
+    bool arena_reuse_ok = true;
+    for (int k = 0; k < 1000; ++k) { string t = string_trim_a(arena, "  tok  "); if (!string_equals(t, "tok")) arena_reuse_ok = false; }
+    check("aq_arena_reset (reuse)", arena_reuse_ok && string_equals(string_copy_a(arena, "after"), "after"));
+    string heap_copy = string_copy_a(NULL, "heap");
+    check("string_copy_a (NULL arena)", string_equals(heap_copy, "heap")); free_string(heap_copy);
+    str_tokens = string_split_a(NULL, "p;q", ';', &num_tokens);
+    check("string_split_a (NULL arena)", num_tokens == 2 && string_equals(str_tokens[1], "q")); free_string_array(str_tokens, num_tokens);
+    check("string_split_a (NULL input)", string_split_a(arena, NULL, ',', &num_tokens) == NULL && num_tokens == 0);
+    check("aq_arena_alloc (NULL arena)", aq_arena_alloc(NULL, 8) == NULL);
+    aq_arena_destroy(arena);
+    aq_arena_destroy(NULL);
+    printf("\n");
+
+    // --- String Views ---
+    printf("--- String Views ---\n");
+    aq_strview views[8];
+    size_t view_count = string_split_view("a,b,,d,", ',', views, 8);
+    check("string_split_view (normal)", view_count == 5 && string_view_equals(views[0], "a") && string_view_equals(views[2], "") && string_view_equals(views[3], "d") && string_view_equals(views[4], ""));
+    check("string_split_view (zero-copy)", views[1].ptr != NULL && *views[1].ptr == 'b' && views[1].len == 1);
+    view_count = string_split_view("x;y;z", ';', views, 2);
+    check("string_split_view (max_views)", view_count == 3 && string_view_equals(views[1], "y"));
+    check("string_split_view (empty / NULL)", string_split_view("", ',', views, 8) == 1 && views[0].len == 0 && string_split_view(NULL, ',', views, 8) == 0);
+    check("string_split_view (count only)", string_split_view("1 2 3 4", ' ', NULL, 0) == 4);
+    view_count = string_split_view_str("k1 => v1 =>  => v3", " => ", views, 8);
+    check("string_split_view_str", view_count == 4 && string_view_equals(views[0], "k1") && string_view_equals(views[2], "") && string_view_equals(views[3], "v3"));
+    check("string_split_view_str (overlap, empty delim)", string_split_view_str("aaaa", "aa", views, 8) == 3 && string_split_view_str("abc", "", views, 8) == 1 && string_view_equals(views[0], "abc"));
+    view_count = string_split_view_any("GET /a?b=1&c=2 HTTP/1.1", " ?&", views, 8);
+    check("string_split_view_any", view_count == 5 && string_view_equals(views[1], "/a") && string_view_equals(views[3], "c=2") && string_view_equals(views[4], "HTTP/1.1"));
+    char long_line[200];
+    memset(long_line, 'q', sizeof(long_line) - 1); long_line[sizeof(long_line) - 1] = '\0';
+    long_line[37] = '\t'; long_line[150] = '|';
+    view_count = string_split_view_any(long_line, "|\t", views, 8);
+    check("string_split_view_any (long line)", view_count == 3 && views[0].len == 37 && views[1].len == 112 && views[2].len == 48);
+    char big_set[] = "abcdefghijklmnopqrstuvwxyz";
+    char big_set_line[] = "AB9cDE0";
+    view_count = string_split_view_any(big_set_line, big_set, views, 8);
+    check("string_split_view_any (large set)", view_count == 2 && string_view_equals(views[0], "AB9") && string_view_equals(views[1], "DE0"));
+    aq_tokenizer tok;
+    const char log_line[] = "2024-01-01|INFO|svc|started";
+    aq_tokenizer_init(&tok, log_line, 14, '|'); // Only the first 14 bytes
+    aq_strview token;
+    size_t token_total = 0; bool second_ok = false;
+    while (aq_tokenizer_next(&tok, &token)) { if (token_total == 1) second_ok = string_view_equals(token, "INF"); token_total++; }
+    check("aq_tokenizer (length-bounded)", token_total == 2 && second_ok && !aq_tokenizer_next(&tok, &token));
+    aq_tokenizer_init_any(&tok, NULL, 0, ",");
+    check("aq_tokenizer (NULL input)", !aq_tokenizer_next(&tok, &token));
+    string view_copy = string_view_copy_a(NULL, views[1]);
+    check("string_view_copy_a", string_equals(view_copy, "DE0")); free_string(view_copy);
+    check("string_view_equals (mismatch)", !string_view_equals(views[1], "DE") && !string_view_equals(views[1], NULL));
+    printf("\n");
+
+    // --- Length-Carrying Strings ---
+    printf("--- Length-Carrying Strings ---\n");
+    aq_str hello = aq_str_from("Hello");
+    check("aq_str_from (borrowed)", hello.len == 5 && hello.cap == 0 && aq_str_from(NULL).ptr == NULL);
+    aq_str greeting = aq_str_concat(hello, aq_str_from(", World"));
+    check("aq_str_concat", greeting.len == 12 && greeting.cap > greeting.len && string_equals(greeting.ptr, "Hello, World"));
+    check("aq_str_concat (both NULL)", aq_str_concat(aq_str_from(NULL), aq_str_from(NULL)).ptr == NULL);
+    aq_str part = aq_str_substring(greeting, 7, 100);
+    check("aq_str_substring", part.len == 5 && string_equals(part.ptr, "World")); aq_str_free(&part);
+    aq_str shout = aq_str_to_upper(greeting), whisper = aq_str_to_lower(greeting);
+    check("aq_str_to_upper / aq_str_to_lower", string_equals(shout.ptr, "HELLO, WORLD") && string_equals(whisper.ptr, "hello, world") && shout.len == 12);
+    aq_str_free(&shout); aq_str_free(&whisper);
+    aq_str padded = aq_str_trim(aq_str_from(" \t spaced out \n"));
+    check("aq_str_trim", padded.len == 10 && string_equals(padded.ptr, "spaced out")); aq_str_free(&padded);
+    padded = aq_str_trim(aq_str_from("   "));
+    check("aq_str_trim (all space)", padded.ptr != NULL && padded.len == 0); aq_str_free(&padded);
+    const char binary_bytes[] = {'a', '\0', 'b'};
+    aq_str binary = aq_str_copy(binary_bytes, 3);
+    check("aq_str_copy (embedded NUL)", binary.len == 3 && binary.ptr[2] == 'b' && binary.ptr[3] == '\0');
+    check("aq_str_equals", aq_str_equals(hello, aq_str_from("Hello")) && !aq_str_equals(hello, aq_str_from("Hell")) && !aq_str_equals(binary, aq_str_from("a")) && aq_str_equals(aq_str_from(NULL), aq_str_from(NULL)));
+    aq_str_free(&binary);
+    check("aq_str_starts_with / aq_str_ends_with", aq_str_starts_with(greeting, hello) && aq_str_ends_with(greeting, aq_str_from("World")) && !aq_str_ends_with(hello, greeting) && aq_str_starts_with(hello, aq_str_from("")));
+    size_t found_at = 0;
+    aq_str long_text = aq_str_from("the quick brown fox jumps over the lazy dog; the quick brown cat naps");
+    check("aq_str_find", aq_str_find(long_text, aq_str_from("brown cat"), &found_at) && found_at == 55 && aq_str_find(greeting, aq_str_from("o, W"), NULL));
+    aq_str replaced_str = aq_str_replace_all(long_text, aq_str_from("quick"), aq_str_from("slow"));
+    check("aq_str_replace_all", replaced_str.len == long_text.len - 2 && string_equals(replaced_str.ptr, "the slow brown fox jumps over the lazy dog; the slow brown cat naps")); aq_str_free(&replaced_str);
+    check("aq_str_find (miss / empty needle)", !aq_str_find(long_text, aq_str_from("brown cow"), &found_at) && aq_str_find(hello, aq_str_from(""), &found_at) && found_at == 0);
+    aq_str parts[3] = { aq_str_from("a"), aq_str_from(NULL), aq_str_from("ccc") };
+    aq_str joined = aq_str_join(parts, 3, aq_str_from(", "));
+    check("aq_str_join", joined.len == 8 && string_equals(joined.ptr, "a, , ccc")); aq_str_free(&joined);
+    joined = aq_str_join(NULL, 0, aq_str_from(","));
+    check("aq_str_join (empty)", joined.ptr != NULL && joined.len == 0); aq_str_free(&joined);
+    aq_strview greeting_view = aq_str_view(greeting);
+    check("aq_str_view", greeting_view.len == 12 && string_view_equals(greeting_view, "Hello, World"));
+    char *greeting_ptr = greeting.ptr;
+    string released = aq_str_release(&greeting);
+    check("aq_str_release (owned, no copy)", released == greeting_ptr && greeting.ptr == NULL && greeting.len == 0);
+    aq_str adopted = aq_str_take(released);
+    check("aq_str_take", adopted.ptr == released && adopted.len == 12 && adopted.cap == 13); aq_str_free(&adopted);
+    string borrowed_copy = aq_str_release(&hello);
+    check("aq_str_release (borrowed, copies)", string_equals(borrowed_copy, "Hello") && hello.ptr == NULL); free_string(borrowed_copy);
+    aq_str_free(NULL);
+    printf("\n");
+
+    // --- String Builder ---
+    printf("--- String Builder ---\n");
+    aq_strbuf sb;
+    aq_strbuf_init(&sb);
+    check("aq_strbuf_init (no allocation)", sb.data == NULL && sb.len == 0 && sb.cap == 0);
+    bool sb_ok = aq_strbuf_append_string(&sb, "id=") && aq_strbuf_append_int(&sb, -42) && aq_strbuf_append_char(&sb, ' ')
+              && aq_strbuf_append_str(&sb, aq_str_from("x=")) && aq_strbuf_append_double(&sb, 0.1) && aq_strbuf_append_string(&sb, NULL)
+              && aq_strbuf_append(&sb, " tail!!", 5);
+    check("aq_strbuf_append*", sb_ok && sb.len == 17 && string_equals(sb.data, "id=-42 x=0.1 tail"));
+    aq_strbuf_clear(&sb);
+    char ll_text[64];
+    aq_strbuf_append_int(&sb, LLONG_MIN); aq_strbuf_append_char(&sb, ','); aq_strbuf_append_int(&sb, LLONG_MAX);
+    aq_strbuf_append_char(&sb, ','); aq_strbuf_append_int(&sb, 0); aq_strbuf_append_char(&sb, ','); aq_strbuf_append_int(&sb, 7);
+    snprintf(ll_text, sizeof(ll_text), "%lld,%lld,0,7", LLONG_MIN, LLONG_MAX);
+    check("aq_strbuf_append_int (limits)", string_equals(sb.data, ll_text));
+    aq_strbuf_clear(&sb);
+    double doubles_in[] = {1.0 / 3.0, 1e300, -2.5, 1e15, 123456.0, -0.0, 5e-324};
+    bool roundtrip_ok = true;
+    for (size_t k = 0; k < sizeof(doubles_in) / sizeof(doubles_in[0]); ++k) {
+        aq_strbuf_clear(&sb);
+        aq_strbuf_append_double(&sb, doubles_in[k]);
+        bool parsed; double back = string_to_double(sb.data, &parsed);
+        if (!parsed || back != doubles_in[k] || signbit(back) != signbit(doubles_in[k])) roundtrip_ok = false;
+    }
+    check("aq_strbuf_append_double (round trip)", roundtrip_ok);
+    aq_strbuf_clear(&sb); aq_strbuf_append_double(&sb, 123456.0); aq_strbuf_append_char(&sb, ' '); aq_strbuf_append_double(&sb, 2.5);
+    check("aq_strbuf_append_double (short form)", string_equals(sb.data, "123456 2.5"));
+    aq_strbuf_clear(&sb);
+    bool growth_ok = true;
+    for (int k = 0; k < 10000; ++k) if (!aq_strbuf_append_char(&sb, (char)('a' + k % 26))) growth_ok = false;
+    check("aq_strbuf (geometric growth)", growth_ok && sb.len == 10000 && sb.cap >= 10001 && sb.cap <= 20002 && sb.data[9999] == 'a' + 9999 % 26);
+    char *sb_data = sb.data;
+    string built = aq_strbuf_release(&sb);
+    check("aq_strbuf_release (O(1) move)", built == sb_data && sb.data == NULL && sb.cap == 0 && strlen(built) == 10000);
+    free_string(built);
+    built = aq_strbuf_release(&sb);
+    check("aq_strbuf_release (empty)", string_equals(built, "")); free_string(built);
+    aq_strbuf_init(&sb);
+    check("aq_strbuf_reserve", aq_strbuf_reserve(&sb, 100) && sb.cap == 101 && sb.len == 0 && string_equals(sb.data, ""));
+    aq_strbuf_append_string(&sb, "moved");
+    aq_str moved = aq_strbuf_release_str(&sb);
+    check("aq_strbuf_release_str", moved.len == 5 && moved.cap == 101 && string_equals(moved.ptr, "moved")); aq_str_free(&moved);
+    aq_arena *sb_arena = aq_arena_create(0);
+    aq_strbuf_init_a(&sb, sb_arena);
+    for (int k = 0; k < 100; ++k) aq_strbuf_append_string(&sb, "0123456789");
+    check("aq_strbuf_init_a", sb.len == 1000 && sb.data[999] == '9' && sb.data[1000] == '\0');
+    moved = aq_strbuf_release_str(&sb);
+    check("aq_strbuf_release_str (arena is borrowed)", moved.cap == 0 && moved.len == 1000);
+    aq_strbuf_free(&sb);
+    aq_arena_destroy(sb_arena);
+    aq_strbuf_init(&sb); aq_strbuf_append_string(&sb, "dropped"); aq_strbuf_free(&sb);
+    check("aq_strbuf_free", sb.data == NULL && sb.len == 0);
+    printf("\n");
+
+    // --- Substring Search ---
+    printf("--- Substring Search ---\n");
+    size_t find_count = 0;
+    size_t *offsets = string_find_all("abababa", "aba", &find_count);
+    check("string_find_all (overlapping)", find_count == 3 && offsets != NULL && offsets[0] == 0 && offsets[1] == 2 && offsets[2] == 4); free(offsets);
+    offsets = string_find_all("abc", "x", &find_count);
+    check("string_find_all (no match)", offsets == NULL && find_count == 0);
+    offsets = string_find_all("abc", "", &find_count);
+    check("string_find_all (empty needle)", offsets == NULL && find_count == 0);
+    const string keywords[] = { "he", "she", "his", "hers", NULL, "he" };
+    aq_matcher *matcher = aq_matcher_create(keywords, 6);
+    aq_match matches[8];
+    size_t match_total = aq_matcher_find_all(matcher, "ushers", 6, matches, 8);
+    check("aq_matcher_find_all", match_total == 4
+          && matches[0].offset == 1 && matches[0].pattern == 1 && matches[1].offset == 2 && matches[1].pattern == 0
+          && matches[2].offset == 2 && matches[2].pattern == 5 && matches[3].offset == 2 && matches[3].pattern == 3);
+    check("aq_matcher_find_all (count only)", aq_matcher_find_all(matcher, "hishe", 5, NULL, 0) == 4);
+    aq_match first_match;
+    check("aq_matcher_find_first", aq_matcher_find_first(matcher, "this", 4, &first_match) && first_match.offset == 1 && first_match.pattern == 2);
+    check("aq_matcher_find_first (none)", !aq_matcher_find_first(matcher, "xyz", 3, NULL) && !aq_matcher_find_first(matcher, "", 0, NULL));
+    aq_matcher_destroy(matcher);
+    const aq_replace_rule escapes[] = { {"&", "&amp;"}, {"<", "&lt;"}, {">", "&gt;"} };
+    string escaped = string_replace_many("a<b && c>d", escapes, 3);
+    check("string_replace_many", string_equals(escaped, "a&lt;b &amp;&amp; c&gt;d")); free_string(escaped);
+    const aq_replace_rule swaps[] = { {"a", "b"}, {"b", "a"}, {"ab", "X"}, {"", "never"} };
+    escaped = string_replace_many("abba", swaps, 4);
+    check("string_replace_many (longest match, no rescan)", string_equals(escaped, "Xab")); free_string(escaped);
+    escaped = string_replace_many("plain", swaps, 0);
+    check("string_replace_many (no rules)", string_equals(escaped, "plain")); free_string(escaped);
     printf("\n");
 
     // --- Memory Management Helpers ---
@@ -391,6 +997,19 @@ int main(void) {
     printf("get_random_int (1-10): %d\n", get_random_int(1, 10));
     printf("get_random_float (0-1): %f\n", get_random_float(0.0f, 1.0f));
     printf("get_random_double (0-1): %f\n", get_random_double(0.0, 1.0));
+    aq_seed_random(2024);
+    int seeded_first = get_random_int(INT_MIN, INT_MAX);
+    aq_seed_random(2024);
+    check("aq_seed_random (reproducible)", get_random_int(INT_MIN, INT_MAX) == seeded_first);
+    bool random_in_range = true;
+    for (int k = 0; k < 1000; ++k) { int r = get_random_int(-2, 2); if (r < -2 || r > 2) random_in_range = false; }
+    check("get_random_int (range)", random_in_range);
+    aq_rng rng;
+    aq_rng_seed(&rng, 7);
+    bool bounded_ok = true;
+    for (int k = 0; k < 1000; ++k) if (aq_rng_bounded(&rng, 3) >= 3 || aq_rng_double(&rng) >= 1.0) bounded_ok = false;
+    check("aq_rng_bounded / aq_rng_double (range)", bounded_ok && aq_rng_bounded(&rng, 0) == 0);
+    check("aq_rng_* (NULL rng)", aq_rng_next(NULL) == 0 && aq_rng_bounded(NULL, 6) == 0 && aq_rng_double(NULL) == 0.0);
     start_timer();
     for(volatile int i=0; i<500000; ++i); // Simulate work
     double elapsed = stop_timer();